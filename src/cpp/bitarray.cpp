@@ -24,29 +24,115 @@
 #include <iostream>
 #include <cstring> // for memset and memcmp
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h> // for movemask packing
+#define BB_PACK_SSE2
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BB_BIG_ENDIAN
+#endif
+
 using namespace BrainBlocks;
 
 // =============================================================================
-// # Popcount
-//
-// Returns the number of active bits in a single word.
-//
-// ## Example
+// # Pack and Unpack Kernels
 //
-// word: {00101100}
-// count = popcount(word)
-// count: 3
+// Convert between byte-per-bit values (any nonzero byte is a 1) and packed
+// words 8 or 16 bits at a time instead of one bit at a time.  Packing uses
+// SSE2 movemask where available and a multiply-gather on 64-bit loads
+// otherwise.  Unpacking spreads each byte of a word into 8 bytes with shifts
+// and masks.  Big-endian targets use the plain per-bit loops.
 //
 // ## Links
 //
-// http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
+// - https://graphics.stanford.edu/~seander/bithacks.html
 // =============================================================================
-inline uint32_t popcount(word_t w) {
+#if !defined(BB_BIG_ENDIAN)
+
+// Returns 8 values packed into the low 8 bits
+static inline uint32_t pack8(const uint8_t* vals) {
+
+    uint64_t v;
+    memcpy(&v, vals, 8);
+
+    // Set the low bit of each byte if that byte is nonzero
+    uint64_t t = ((v & 0x7f7f7f7f7f7f7f7fULL) + 0x7f7f7f7f7f7f7f7fULL) | v;
+    t = (t >> 7) & 0x0101010101010101ULL;
+
+    // Gather the low bit of byte k into bit 56 + k
+    return (uint32_t)((t * 0x0102040810204080ULL) >> 56);
+}
+
+// Writes the low 8 bits of bits as 8 values of 0 or 1
+static inline void unpack8(uint32_t bits, uint8_t* vals) {
+
+    uint64_t x = bits & 0xff;
+    x = (x | (x << 28)) & 0x0000000f0000000fULL;
+    x = (x | (x << 14)) & 0x0003000300030003ULL;
+    x = (x | (x <<  7)) & 0x0101010101010101ULL;
+    memcpy(vals, &x, 8);
+}
+
+#endif
+
+// Packs n values into ceil(n / WBITS) words, zeroing bits past n
+static void pack_bits(const uint8_t* vals, const uint32_t n, word_t* words) {
+
+    uint32_t num_full = n / WBITS;
+    uint32_t beg = 0;
+
+#if !defined(BB_BIG_ENDIAN)
+    for (uint32_t w = 0; w < num_full; w++) {
+        const uint8_t* p = &vals[w * WBITS];
+        word_t word = 0;
+
+#if defined(BB_PACK_SSE2)
+        for (uint32_t k = 0; k < WBITS; k += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)&p[k]);
+            __m128i z = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+            uint32_t m = ~(uint32_t)_mm_movemask_epi8(z) & 0xffff;
+            word |= (word_t)m << k;
+        }
+#else
+        for (uint32_t k = 0; k < WBITS; k += 8)
+            word |= (word_t)pack8(&p[k]) << k;
+#endif
+
+        words[w] = word;
+    }
 
-    w = w - ((w >> 1) & (word_t)~(word_t)0/3);
-    w = (w & (word_t)~(word_t)0/15*3) + ((w >> 2) & (word_t)~(word_t)0/15*3);
-    w = (w + (w >> 4)) & (word_t)~(word_t)0/255*15;
-    return (word_t)(w * ((word_t)~(word_t)0/255)) >> (sizeof(word_t) - 1) * 8;
+    beg = num_full * WBITS;
+#endif
+
+    // Handle remaining values one bit at a time
+    for (uint32_t w = get_wrd(beg); w < (n + WBITS - 1) / WBITS; w++)
+        words[w] = 0;
+
+    for (uint32_t b = beg; b < n; b++)
+        if (vals[b])
+            words[get_wrd(b)] |= (word_t)1 << get_idx(b);
+}
+
+// Unpacks n bits from words into n values of 0 or 1
+static void unpack_bits(const word_t* words, const uint32_t n, uint8_t* vals) {
+
+    uint32_t beg = 0;
+
+#if !defined(BB_BIG_ENDIAN)
+    uint32_t num_bytes = n / 8;
+
+    for (uint32_t i = 0; i < num_bytes; i++) {
+        word_t word = words[(i * 8) / WBITS];
+        unpack8((uint32_t)(word >> ((i * 8) % WBITS)), &vals[i * 8]);
+    }
+
+    beg = num_bytes * 8;
+#endif
+
+    // Handle remaining bits one at a time
+    for (uint32_t b = beg; b < n; b++)
+        vals[b] = (words[get_wrd(b)] >> get_idx(b)) & 1;
 }
 
 // =============================================================================
@@ -82,7 +168,7 @@ void BitArray::resize(const uint32_t n) {
 // =============================================================================
 // # Erase
 //
-// Removes all words from the BitArray.
+// Removes all words from the BitArray and frees their memory.
 //
 // ## Example
 //
@@ -92,7 +178,8 @@ void BitArray::resize(const uint32_t n) {
 // =============================================================================
 void BitArray::erase() {
 
-    words.clear();
+    std::vector<word_t>().swap(words);
+    touched.clear();
     num_b = 0;
     num_bytes = 0;
 }
@@ -305,6 +392,53 @@ void BitArray::set_all() {
 void BitArray::clear_all() {
 
     memset(words.data(), 0x00000000, num_bytes);
+    touched.clear();
+}
+
+// =============================================================================
+// # Set Bit Tracked
+//
+// Sets a particular bit to 1 like set_bit() and remembers its word if the word
+// was empty, so clear_tracked() can later zero only the words in use.  Meant
+// for large per-step activation states where few bits are set between clears.
+// Bits must only be set through this function between clears.
+//
+// ## Example
+//
+// bitarray: {00000000000000000000000000000000 00000000000000000000000000000000}
+// bitarray.set_bit_tracked(35);
+// bitarray: {00000000000000000000000000000000 00010000000000000000000000000000}
+//  touched: {1}
+// =============================================================================
+void BitArray::set_bit_tracked(const uint32_t b) {
+
+    assert(b < num_b);
+
+    word_t& word = words[get_wrd(b)];
+
+    if (word == 0)
+        touched.push_back(get_wrd(b));
+
+    word |= 1 << (get_idx(b));
+}
+
+// =============================================================================
+// # Clear Tracked
+//
+// Sets all bits to 0 by zeroing only the words recorded by set_bit_tracked().
+// Falls back to clear_all() when many words were touched.
+// =============================================================================
+void BitArray::clear_tracked() {
+
+    if (touched.size() * 8 > words.size()) {
+        clear_all();
+        return;
+    }
+
+    for (uint32_t i = 0; i < touched.size(); i++)
+        words[touched[i]] = 0;
+
+    touched.clear();
 }
 
 // =============================================================================
@@ -339,14 +473,28 @@ void BitArray::toggle_all() {
 // =============================================================================
 void BitArray::set_bits(std::vector<uint8_t>& vals) {
 
-    assert(vals.size() <= num_b);
+    set_bits(vals.data(), (uint32_t)vals.size());
+}
 
-    clear_all();
+// =============================================================================
+// # Set Bits (Pointer)
+//
+// Assigns the first n bits from n byte values (nonzero is 1) and clears the
+// rest.  Converts whole words at a time, so it is suited to large dense rows
+// such as numpy arrays handed over from Python.
+// =============================================================================
+void BitArray::set_bits(const uint8_t* vals, const uint32_t n) {
 
-    for (uint32_t i = 0; i < vals.size(); i++) {
-        if (vals[i] > 0)
-            set_bit(i);
-    }
+    assert(n <= num_b);
+
+    uint32_t num_w = (n + WBITS - 1) / WBITS;
+
+    pack_bits(vals, n, words.data());
+
+    if (num_w < words.size())
+        memset(&words[num_w], 0, (words.size() - num_w) * WBYTES);
+
+    touched.clear();
 }
 
 // =============================================================================
@@ -388,12 +536,21 @@ std::vector<uint8_t> BitArray::get_bits() {
 
     std::vector<uint8_t> vals(num_b);
 
-    for (uint32_t b = 0; b < num_b; b++)
-        vals[b] = get_bit(b);
+    get_bits(vals.data());
 
     return vals;
 }
 
+// =============================================================================
+// # Get Bits (Pointer)
+//
+// Writes all num_bits() bit values (0 or 1) to a caller-provided buffer.
+// =============================================================================
+void BitArray::get_bits(uint8_t* vals) {
+
+    unpack_bits(words.data(), num_b, vals);
+}
+
 // =============================================================================
 // # Get Acts
 //
@@ -443,6 +600,45 @@ uint32_t BitArray::num_set() {
     return count;
 }
 
+// =============================================================================
+// # Number of Set (Range)
+//
+// Returns the number of set (1) bits in a range of bits.  Whole words inside
+// the range are popcounted directly and only the two end words are masked.
+//
+// ## Example
+//
+// bitarray: {00101101010000100000000010000100}
+//               ^^^^^
+// count = bitarray.num_set(3, 5);
+// count = 3
+// =============================================================================
+uint32_t BitArray::num_set(const uint32_t beg, const uint32_t len) {
+
+    assert(beg + len <= num_b);
+
+    if (len == 0)
+        return 0;
+
+    uint32_t end = beg + len - 1;
+    uint32_t beg_w = get_wrd(beg);
+    uint32_t end_w = get_wrd(end);
+    word_t beg_mask = ~(word_t)0 << get_idx(beg);
+    word_t end_mask = bitmask(get_idx(end) + 1);
+
+    if (beg_w == end_w)
+        return popcount(words[beg_w] & beg_mask & end_mask);
+
+    uint32_t count = popcount(words[beg_w] & beg_mask);
+
+    for (uint32_t w = beg_w + 1; w < end_w; w++)
+        count += popcount(words[w]);
+
+    count += popcount(words[end_w] & end_mask);
+
+    return count;
+}
+
 // =============================================================================
 // # Number of Cleared
 //
@@ -488,6 +684,24 @@ uint32_t BitArray::num_similar(const BitArray& ba) {
     return count;
 }
 
+// =============================================================================
+// # Fingerprint
+//
+// Returns a 64-bit fingerprint of the bit values (see fingerprint_word).  Equal
+// BitArrays always have equal fingerprints and an empty BitArray has
+// fingerprint 0.  Distinct BitArrays collide with probability ~2^-64, so
+// callers that must be exact should compare the bits on a fingerprint match.
+// =============================================================================
+uint64_t BitArray::fingerprint() {
+
+    uint64_t fp = 0;
+
+    for (uint32_t w = 0; w < words.size(); w++)
+        fp ^= fingerprint_word(w, words[w]);
+
+    return fp;
+}
+
 // =============================================================================
 // # Find Next Set Bit
 //
@@ -770,6 +984,60 @@ BitArray BitArray::operator^(const BitArray& in) {
     return out;
 }
 
+// =============================================================================
+// # In-place Binary Operators
+//
+// Perform "binary and", "binary or", "binary xor" and "binary and not" of this
+// BitArray with an inputted BitArray in place, without allocating a new
+// BitArray.
+//
+// ## Example:
+//
+// bitarray0: {01101010110010010000111110000100}
+// bitarray1: {00100010010100010000001010100000}
+// bitarray0.andnot(bitarray1);
+// bitarray0: {01001000100010000000110100000100}
+// =============================================================================
+BitArray& BitArray::operator&=(const BitArray& in) {
+
+    assert(words.size() == in.words.size());
+
+    for (uint32_t w = 0; w < words.size(); w++)
+        words[w] &= in.words[w];
+
+    return *this;
+}
+
+BitArray& BitArray::operator|=(const BitArray& in) {
+
+    assert(words.size() == in.words.size());
+
+    for (uint32_t w = 0; w < words.size(); w++)
+        words[w] |= in.words[w];
+
+    return *this;
+}
+
+BitArray& BitArray::operator^=(const BitArray& in) {
+
+    assert(words.size() == in.words.size());
+
+    for (uint32_t w = 0; w < words.size(); w++)
+        words[w] ^= in.words[w];
+
+    return *this;
+}
+
+BitArray& BitArray::andnot(const BitArray& in) {
+
+    assert(words.size() == in.words.size());
+
+    for (uint32_t w = 0; w < words.size(); w++)
+        words[w] &= ~in.words[w];
+
+    return *this;
+}
+
 // =============================================================================
 // # Is Equal Operator
 //
@@ -4,10 +4,15 @@
 #ifndef BITARRAY_HPP
 #define BITARRAY_HPP
 
+#include <cassert>
 #include <vector>
 #include <cstdint>
 #include <random>
 
+#if defined(_WIN32)
+#include <xmmintrin.h> // for _mm_prefetch
+#endif
+
 namespace BrainBlocks {
 
 // Setup 32-bit words
@@ -29,6 +34,8 @@ typedef uint64_t word_t;
 #define WBITS (8 * WBYTES)
 #define bitmask(nbits) ((nbits) ? ~(word_t)0 >> (WBITS-(nbits)): (word_t)0)
 
+template <typename E> struct BitExpr;
+
 class BitArray {
 
 public:
@@ -59,19 +66,29 @@ public:
     void clear_all();
     void toggle_all();
 
+    // Sparse clearing of mostly-empty BitArrays
+    void set_bit_tracked(const uint32_t b);
+    void clear_tracked();
+
     // Access and manipulate bits from vectors
     void set_bits(std::vector<uint8_t>& vals);
+    void set_bits(const uint8_t* vals, const uint32_t n);
     void set_acts(std::vector<uint32_t>& idxs);
     std::vector<uint8_t> get_bits();
+    void get_bits(uint8_t* vals);
     std::vector<uint32_t> get_acts();
 
     // Get count of bits
     uint32_t num_set();
+    uint32_t num_set(const uint32_t beg, const uint32_t len);
     uint32_t num_cleared();
     uint32_t num_similar(const BitArray& ba);
     // TODO: uint32_t num_different(const BitArray& ba);
     // TODO: uint32_t hamming_distance();
 
+    // Get 64-bit fingerprint of bit values
+    uint64_t fingerprint();
+
     // Find indices of set/clear bits
     bool find_next_set_bit(const uint32_t beg, uint32_t* result);
 
@@ -102,6 +119,16 @@ public:
     BitArray operator|(const BitArray& in); // binary or
     BitArray operator^(const BitArray& in); // binary xor
 
+    // In-place logic operators (no allocation)
+    BitArray& operator&=(const BitArray& in); // binary and
+    BitArray& operator|=(const BitArray& in); // binary or
+    BitArray& operator^=(const BitArray& in); // binary xor
+    BitArray& andnot(const BitArray& in);     // binary and not
+
+    // Evaluate a logic expression in one pass (see BitExpr)
+    template <typename E>
+    BitArray& assign(const BitExpr<E>& e);
+
     // Comparisons
     bool operator==(const BitArray& in); // equals
     bool operator!=(const BitArray& in); // not equals
@@ -120,6 +147,7 @@ public: // TODO: make private after figuring out bitarray_copy
     uint32_t num_b = 0;
     uint32_t num_bytes = 0;
     std::vector<word_t> words;
+    std::vector<uint32_t> touched; // words set by set_bit_tracked
 };
 
 // =============================================================================
@@ -145,6 +173,29 @@ inline void bitarray_copy(
     }
 }
 
+// =============================================================================
+// # Popcount
+//
+// Returns the number of active bits in a single word.
+//
+// ## Example
+//
+// word: {00101100}
+// count = popcount(word)
+// count: 3
+//
+// ## Links
+//
+// http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
+// =============================================================================
+inline uint32_t popcount(word_t w) {
+
+    w = w - ((w >> 1) & (word_t)~(word_t)0/3);
+    w = (w & (word_t)~(word_t)0/15*3) + ((w >> 2) & (word_t)~(word_t)0/15*3);
+    w = (w + (w >> 4)) & (word_t)~(word_t)0/255*15;
+    return (word_t)(w * ((word_t)~(word_t)0/255)) >> (sizeof(word_t) - 1) * 8;
+}
+
 // =============================================================================
 // # Trailing Zeros
 //
@@ -179,6 +230,194 @@ inline int leading_zeros(word_t word) {
 }
 #endif
 
+// =============================================================================
+// # Prefetch Line
+//
+// Hints the CPU to start loading the cache line holding ptr for reading, so
+// independent random reads can overlap instead of stalling one at a time.
+// =============================================================================
+#if defined(_WIN32)
+inline void prefetch_line(const void* ptr) {
+    _mm_prefetch((const char*)ptr, _MM_HINT_T0);
+}
+#else
+inline void prefetch_line(const void* ptr) {
+    __builtin_prefetch(ptr, 0, 3);
+}
+#endif
+
+// =============================================================================
+// # Fingerprint Word
+//
+// Hashes one word and its position with the splitmix64 finalizer.  A BitArray
+// fingerprint is the XOR of these hashes over its nonzero words, so it can be
+// updated in place when a word changes:
+//
+// fp ^= fingerprint_word(w, old_word) ^ fingerprint_word(w, new_word);
+// =============================================================================
+inline uint64_t fingerprint_word(const uint32_t w, const word_t word) {
+
+    if (word == 0)
+        return 0;
+
+    uint64_t x = ((uint64_t)w << 32) ^ (uint64_t)word;
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// =============================================================================
+// # Bit Expressions
+//
+// Expression templates for compound BitArray logic.  Wrapping BitArrays with
+// bitexpr() makes ~, &, | and ^ build a lightweight expression instead of a
+// new BitArray.  The expression is then evaluated word by word in a single
+// pass, either into an existing BitArray with assign() or straight into a
+// reduction with popcount() or any(), so no temporaries are allocated.  The
+// BitArray operators themselves still return new BitArrays.
+//
+// Expressions hold references to their BitArrays and must be evaluated within
+// the statement that builds them.  All operands must have the same size.
+//
+// ## Example
+//
+// a: {11110000}
+// b: {10100000}
+//
+// uint32_t n = popcount(bitexpr(a) & ~bitexpr(b));
+// n: 2
+//
+// bool overlap = any(bitexpr(a) & bitexpr(b));
+// overlap: true
+//
+// c.assign(bitexpr(a) ^ bitexpr(b));
+// c: {01010000}
+// =============================================================================
+template <typename E>
+struct BitExpr {
+    const E& self() const { return static_cast<const E&>(*this); };
+    uint32_t num_bits() const { return self().num_bits(); };
+    word_t word(const uint32_t w) const { return self().word(w); };
+};
+
+struct BitRef : public BitExpr<BitRef> {
+    BitRef(const BitArray& ba) : ba(ba) {};
+    uint32_t num_bits() const { return ba.num_b; };
+    word_t word(const uint32_t w) const { return ba.words[w]; };
+    const BitArray& ba;
+};
+
+template <typename E>
+struct BitNot : public BitExpr<BitNot<E>> {
+    BitNot(const E& e) : e(e) {};
+    uint32_t num_bits() const { return e.num_bits(); };
+    word_t word(const uint32_t w) const { return ~e.word(w); };
+    const E e;
+};
+
+template <typename L, typename R, typename Op>
+struct BitBinary : public BitExpr<BitBinary<L, R, Op>> {
+    BitBinary(const L& l, const R& r) : l(l), r(r) {
+        assert(l.num_bits() == r.num_bits());
+    };
+    uint32_t num_bits() const { return l.num_bits(); };
+    word_t word(const uint32_t w) const { return Op::f(l.word(w), r.word(w)); };
+    const L l;
+    const R r;
+};
+
+struct BitOpAnd { static word_t f(word_t a, word_t b) { return a & b; }; };
+struct BitOpOr { static word_t f(word_t a, word_t b) { return a | b; }; };
+struct BitOpXor { static word_t f(word_t a, word_t b) { return a ^ b; }; };
+
+inline BitRef bitexpr(const BitArray& ba) {
+    return BitRef(ba);
+}
+
+template <typename E>
+BitNot<E> operator~(const BitExpr<E>& e) {
+    return BitNot<E>(e.self());
+}
+
+template <typename L, typename R>
+BitBinary<L, R, BitOpAnd> operator&(const BitExpr<L>& l, const BitExpr<R>& r) {
+    return BitBinary<L, R, BitOpAnd>(l.self(), r.self());
+}
+
+template <typename L, typename R>
+BitBinary<L, R, BitOpOr> operator|(const BitExpr<L>& l, const BitExpr<R>& r) {
+    return BitBinary<L, R, BitOpOr>(l.self(), r.self());
+}
+
+template <typename L, typename R>
+BitBinary<L, R, BitOpXor> operator^(const BitExpr<L>& l, const BitExpr<R>& r) {
+    return BitBinary<L, R, BitOpXor>(l.self(), r.self());
+}
+
+// Mask of the valid bits in the last word (~ sets the padding bits)
+inline word_t bitexpr_tail_mask(const uint32_t num_b) {
+    return get_idx(num_b) ? bitmask(get_idx(num_b)) : ~(word_t)0;
+}
+
+// Number of set bits in the expression result
+template <typename E>
+uint32_t popcount(const BitExpr<E>& e) {
+
+    uint32_t num_b = e.num_bits();
+    uint32_t num_w = (num_b + WBITS - 1) / WBITS;
+    uint32_t count = 0;
+
+    if (num_w == 0)
+        return 0;
+
+    for (uint32_t w = 0; w + 1 < num_w; w++)
+        count += popcount(e.word(w));
+
+    return count + popcount(e.word(num_w - 1) & bitexpr_tail_mask(num_b));
+}
+
+// Whether any bit is set in the expression result (stops at the first one)
+template <typename E>
+bool any(const BitExpr<E>& e) {
+
+    uint32_t num_b = e.num_bits();
+    uint32_t num_w = (num_b + WBITS - 1) / WBITS;
+
+    if (num_w == 0)
+        return false;
+
+    for (uint32_t w = 0; w + 1 < num_w; w++)
+        if (e.word(w))
+            return true;
+
+    return (e.word(num_w - 1) & bitexpr_tail_mask(num_b)) != 0;
+}
+
+// Writes the expression result into this BitArray, resizing if needed
+template <typename E>
+BitArray& BitArray::assign(const BitExpr<E>& e) {
+
+    uint32_t n = e.num_bits();
+
+    if (n != num_b)
+        resize(n);
+
+    if (words.empty())
+        return *this;
+
+    uint32_t num_w = (uint32_t)words.size();
+
+    // Each word only depends on the same word of the operands, so this
+    // BitArray may also appear in the expression
+    for (uint32_t w = 0; w + 1 < num_w; w++)
+        words[w] = e.word(w);
+
+    words[num_w - 1] = e.word(num_w - 1) & bitexpr_tail_mask(n);
+
+    return *this;
+}
+
 } // namespace BrainBlocks
 
 #endif // BITARRAY_HPP
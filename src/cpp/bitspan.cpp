@@ -0,0 +1,269 @@
+// =============================================================================
+// bitspan.cpp
+// =============================================================================
+#include "bitspan.hpp"
+#include <cassert>
+
+using namespace BrainBlocks;
+
+// =============================================================================
+// # BitSpan
+//
+// A non-owning view of a range of bits inside a BitArray or any word array,
+// such as one child's segment of a BlockInput state or one label's range of a
+// PatternClassifier output.  A BitSpan is just a pointer, a bit offset and a
+// length, so slicing costs nothing and writes go straight to the underlying
+// words.  Algorithms that take a BitSpan also accept a whole BitArray, which
+// converts implicitly.  The view is invalidated if the BitArray is resized.
+//
+// ## Example
+//
+// bitarray: {00000000111100000000000000000000}
+// BitSpan span(bitarray, 6, 8);
+// span:           {00111100}
+// span.num_set(): 4
+// span.set_bit(0);
+// bitarray: {00000010111100000000000000000000}
+// =============================================================================
+
+// =============================================================================
+// # Constructors
+//
+// Constructs a BitSpan over a whole BitArray, a range of a BitArray, or a
+// range of a word array.
+// =============================================================================
+BitSpan::BitSpan(BitArray& ba)
+: words(ba.words.data()), off(0), len(ba.num_b) {}
+
+BitSpan::BitSpan(BitArray& ba, const uint32_t beg, const uint32_t len)
+: words(ba.words.data()), off(beg), len(len) {
+
+    assert(beg + len <= ba.num_b);
+}
+
+BitSpan::BitSpan(word_t* words, const uint32_t beg, const uint32_t len)
+: words(words), off(beg), len(len) {}
+
+// =============================================================================
+// # Span
+//
+// Returns a view of len bits starting at bit beg of this span.
+// =============================================================================
+BitSpan BitSpan::span(const uint32_t beg, const uint32_t len) const {
+
+    assert(beg + len <= this->len);
+
+    return BitSpan(words, off + beg, len);
+}
+
+// =============================================================================
+// # Get Word
+//
+// Returns WBITS bits of the span starting at bit i * WBITS as one word.  Bits
+// past the end of the span are returned as 0.
+//
+// ## Example
+//
+// span (offset 6, length 8) over {00000010111100000000000000000000}
+// get_word(0): {10111100000000000000000000000000}
+// =============================================================================
+word_t BitSpan::get_word(const uint32_t i) const {
+
+    uint32_t beg = i * WBITS;
+    assert(beg < len);
+
+    uint32_t pos = off + beg;
+    uint32_t rem = len - beg; // bits left in the span
+    uint32_t w = get_wrd(pos);
+    uint32_t s = get_idx(pos);
+    word_t word = words[w] >> s;
+
+    // Pull the high bits from the next word if needed
+    if (s > 0 && rem > WBITS - s)
+        word |= words[w + 1] << (WBITS - s);
+
+    if (rem < WBITS)
+        word &= bitmask(rem);
+
+    return word;
+}
+
+// =============================================================================
+// # Put Word
+//
+// Writes WBITS bits of the span starting at bit i * WBITS from one word.  Bits
+// of word past the end of the span are ignored.
+// =============================================================================
+void BitSpan::put_word(const uint32_t i, const word_t word) const {
+
+    uint32_t beg = i * WBITS;
+    assert(beg < len);
+
+    uint32_t pos = off + beg;
+    uint32_t rem = len - beg;
+    uint32_t n = rem < WBITS ? rem : WBITS; // bits to write
+    uint32_t w = get_wrd(pos);
+    uint32_t s = get_idx(pos);
+    word_t mask = bitmask(n);
+    word_t val = word & mask;
+
+    // Low part goes into word w
+    words[w] = (words[w] & ~(mask << s)) | (val << s);
+
+    // High part spills into word w + 1
+    if (s > 0 && n > WBITS - s) {
+        uint32_t hs = WBITS - s;
+        words[w + 1] = (words[w + 1] & ~(mask >> hs)) | (val >> hs);
+    }
+}
+
+// =============================================================================
+// # Set All
+//
+// Sets all bits in the span to 1.
+// =============================================================================
+void BitSpan::set_all() const {
+
+    for (uint32_t i = 0; i < num_words(); i++)
+        put_word(i, ~(word_t)0);
+}
+
+// =============================================================================
+// # Clear All
+//
+// Sets all bits in the span to 0.
+// =============================================================================
+void BitSpan::clear_all() const {
+
+    for (uint32_t i = 0; i < num_words(); i++)
+        put_word(i, 0);
+}
+
+// =============================================================================
+// # Copy From
+//
+// Copies the bits of an equally sized span into this span.  The spans must not
+// overlap.
+// =============================================================================
+void BitSpan::copy_from(const BitSpan& src) const {
+
+    assert(src.len == len);
+
+    for (uint32_t i = 0; i < num_words(); i++)
+        put_word(i, src.get_word(i));
+}
+
+// =============================================================================
+// # Get Acts
+//
+// Returns the indices (relative to the span) of all set bits.
+// =============================================================================
+std::vector<uint32_t> BitSpan::get_acts() const {
+
+    std::vector<uint32_t> acts;
+
+    for (uint32_t i = 0; i < num_words(); i++) {
+        word_t word = get_word(i);
+
+        while (word) {
+            acts.push_back(i * WBITS + trailing_zeros(word));
+            word &= word - 1;
+        }
+    }
+
+    return acts;
+}
+
+// =============================================================================
+// # Number of Set
+//
+// Returns the number of set bits in the span.
+// =============================================================================
+uint32_t BitSpan::num_set() const {
+
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < num_words(); i++)
+        count += popcount(get_word(i));
+
+    return count;
+}
+
+// =============================================================================
+// # Number of Similar
+//
+// Returns the number of bits set in both this span and an equally sized span.
+// Word-aligned spans are counted directly on the underlying words.
+// =============================================================================
+uint32_t BitSpan::num_similar(const BitSpan& in) const {
+
+    assert(in.len == len);
+
+    uint32_t count = 0;
+    uint32_t num_w = num_words();
+
+    if (num_w == 0)
+        return 0;
+
+    // Fast path for word-aligned spans
+    if (get_idx(off) == 0 && get_idx(in.off) == 0) {
+        const word_t* a = &words[get_wrd(off)];
+        const word_t* b = &in.words[get_wrd(in.off)];
+
+        for (uint32_t w = 0; w + 1 < num_w; w++)
+            count += popcount(a[w] & b[w]);
+
+        word_t last = a[num_w - 1] & b[num_w - 1];
+
+        if (get_idx(len))
+            last &= bitmask(get_idx(len));
+
+        return count + popcount(last);
+    }
+
+    for (uint32_t i = 0; i < num_w; i++)
+        count += popcount(get_word(i) & in.get_word(i));
+
+    return count;
+}
+
+// =============================================================================
+// # Find Next Set Bit
+//
+// Finds the index of the next set bit from a bit offset within the span,
+// wrapping around to offset-1 like BitArray::find_next_set_bit.  Returns false
+// if no bits are set.
+// =============================================================================
+bool BitSpan::find_next_set_bit(const uint32_t beg, uint32_t* result) const {
+
+    assert(beg < len);
+
+    uint32_t bw = beg / WBITS;
+    word_t word = get_word(bw) & ~bitmask(get_idx(beg));
+
+    // Search from beg to the end of the span
+    for (uint32_t i = bw; i < num_words(); i++) {
+        if (i > bw)
+            word = get_word(i);
+
+        if (word) {
+            *result = i * WBITS + trailing_zeros(word);
+            return true;
+        }
+    }
+
+    // Wrap around and search from the start of the span to beg
+    for (uint32_t i = 0; i <= bw; i++) {
+        word = get_word(i);
+
+        if (i == bw)
+            word &= bitmask(get_idx(beg));
+
+        if (word) {
+            *result = i * WBITS + trailing_zeros(word);
+            return true;
+        }
+    }
+
+    return false;
+}
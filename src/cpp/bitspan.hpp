@@ -0,0 +1,77 @@
+// =============================================================================
+// bitspan.hpp
+// =============================================================================
+#ifndef BITSPAN_HPP
+#define BITSPAN_HPP
+
+#include "bitarray.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace BrainBlocks {
+
+class BitSpan {
+
+public:
+
+    // Constructors
+    BitSpan(BitArray& ba);
+    BitSpan(BitArray& ba, const uint32_t beg, const uint32_t len);
+    BitSpan(word_t* words, const uint32_t beg, const uint32_t len);
+
+    // Get a sub-range of this span
+    BitSpan span(const uint32_t beg, const uint32_t len) const;
+
+    // Access and manipulate a single bit
+    uint8_t get_bit(const uint32_t b) const {
+        uint32_t pos = off + b;
+        return (words[get_wrd(pos)] >> get_idx(pos)) & 1;
+    };
+
+    void set_bit(const uint32_t b) const {
+        uint32_t pos = off + b;
+        words[get_wrd(pos)] |= (word_t)1 << get_idx(pos);
+    };
+
+    void clear_bit(const uint32_t b) const {
+        uint32_t pos = off + b;
+        words[get_wrd(pos)] &= ~((word_t)1 << get_idx(pos));
+    };
+
+    // Start loading the word holding a bit (see prefetch_line)
+    void prefetch_bit(const uint32_t b) const {
+        prefetch_line(&words[get_wrd(off + b)]);
+    };
+
+    // Access and manipulate all bits
+    void set_all() const;
+    void clear_all() const;
+    void copy_from(const BitSpan& src) const;
+    std::vector<uint32_t> get_acts() const;
+
+    // Get count of bits
+    uint32_t num_set() const;
+    uint32_t num_similar(const BitSpan& in) const;
+
+    // Find indices of set bits
+    bool find_next_set_bit(const uint32_t beg, uint32_t* result) const;
+
+    // Access and manipulate WBITS bits at a time (chunk i = bits i*WBITS...)
+    word_t get_word(const uint32_t i) const;
+    void put_word(const uint32_t i, const word_t word) const;
+
+    // Get Information
+    uint32_t num_bits() const { return len; };
+    uint32_t num_words() const { return (len + WBITS - 1) / WBITS; };
+    uint32_t offset() const { return off; };
+
+private:
+
+    word_t* words; // first word of the underlying array
+    uint32_t off;  // bit offset of the span in the underlying array
+    uint32_t len;  // number of bits in the span
+};
+
+} // namespace BrainBlocks
+
+#endif // BITSPAN_HPP
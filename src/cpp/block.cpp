@@ -5,7 +5,7 @@
 
 using namespace BrainBlocks;
 
-uint32_t Block::next_id = 0;
+std::atomic<uint32_t> Block::next_id(0);
 
 // =============================================================================
 // # Constructor
@@ -109,9 +109,9 @@ void Block::store() {}
 //
 // Returns an estimate of the number of bytes used by the block.
 // =============================================================================
-uint32_t Block::memory_usage() {
+uint64_t Block::memory_usage() {
 
-    uint32_t bytes = 0;
+    uint64_t bytes = 0;
 
     bytes += sizeof(id);
     bytes += sizeof(init_flag);
@@ -4,6 +4,7 @@
 #ifndef BLOCK_HPP
 #define BLOCK_HPP
 
+#include <atomic>
 #include <cstdint>
 #include <random>
 #include <cstdio>
@@ -31,7 +32,7 @@ public:
     virtual void decode();
     virtual void learn();
     virtual void store();
-    virtual uint32_t memory_usage();
+    virtual uint64_t memory_usage();
 
     // Public functions
     void feedforward(bool learn_flag=false);
@@ -39,7 +40,7 @@ public:
 
 protected:
 
-    static uint32_t next_id;
+    static std::atomic<uint32_t> next_id;
     uint32_t id = 0xffffffff;
     bool init_flag = false;
     std::mt19937 rng;
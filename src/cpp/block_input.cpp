@@ -6,7 +6,7 @@
 
 using namespace BrainBlocks;
 
-uint32_t BlockInput::next_id = 0;
+std::atomic<uint32_t> BlockInput::next_id(0);
 
 // =============================================================================
 // # Constructor
@@ -189,14 +189,34 @@ bool BlockInput::children_changed() {
     return changed;
 }
 
+// =============================================================================
+// # Child Span
+//
+// Returns a view of the bits in the state BitArray that hold a child's
+// history, so a child's segment can be read or written without a copy.
+//
+// ## Example
+//
+// input.state: {11000000 000011110000 ...}
+// input.child_span(1): {000011110000}
+// =============================================================================
+BitSpan BlockInput::child_span(const uint32_t c) {
+
+    assert(c < children.size());
+
+    uint32_t num_b = children[c]->state.num_bits();
+
+    return BitSpan(state, word_offsets[c] * WBITS, num_b);
+}
+
 // =============================================================================
 // # Memory Usage
 //
 // Returns an estimate of the number of bytes used by the BlockInput.
 // =============================================================================
-uint32_t BlockInput::memory_usage() {
+uint64_t BlockInput::memory_usage() {
 
-    uint32_t bytes = 0;
+    uint64_t bytes = 0;
     uint32_t num_c = (uint32_t)children.size();
 
     bytes += state.memory_usage();
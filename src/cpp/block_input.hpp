@@ -5,7 +5,9 @@
 #define BLOCK_INPUT_HPP
 
 #include "bitarray.hpp"
+#include "bitspan.hpp"
 #include "block_output.hpp"
+#include <atomic>
 #include <cstdint>
 #include <vector>
 
@@ -22,7 +24,8 @@ public:
     void pull();
     void push();
     bool children_changed();
-    uint32_t memory_usage();
+    uint64_t memory_usage();
+    BitSpan child_span(const uint32_t c);
 
     uint32_t num_children() { return (uint32_t)children.size(); };
 
@@ -30,7 +33,7 @@ public:
 
 private:
 
-    static uint32_t next_id;
+    static std::atomic<uint32_t> next_id;
     uint32_t id = 0xffffffff;
 
     // Child connection vectors
@@ -3,17 +3,37 @@
 // =============================================================================
 #include "block_memory.hpp"
 #include "utils.hpp"
+#include <algorithm> // for sort and unique
 #include <cassert>
 #include <cstring> // for memset
 #include <cstdio>
 #include <iostream>
+#include <stdexcept> // for length_error
+#include <unordered_set>
+
+#define BLOCK_MEMORY_MAGIC 0x4D4D4242 // "BBMM"
+#define BLOCK_MEMORY_VERSION 2
+#define BLOCK_MEMORY_LAYOUT 1 // a dendrite layout table follows the data
 
 using namespace BrainBlocks;
 
+std::atomic<uint64_t> BlockMemory::next_version(0);
+
+// Prefetches every 64-byte cache line overlapping num_bytes at ptr
+static void prefetch_range(const void* ptr, const size_t num_bytes) {
+
+    uintptr_t beg = (uintptr_t)ptr & ~(uintptr_t)63;
+    uintptr_t end = (uintptr_t)ptr + num_bytes;
+
+    for (uintptr_t p = beg; p < end; p += 64)
+        prefetch_line((const void*)p);
+}
+
 // =============================================================================
 // # Initialize
 //
-// Initializes BlockMemory based on parameters.
+// Initializes BlockMemory based on parameters.  Throws std::length_error if
+// the receptor arrays would be too large (see check_sizes).
 // =============================================================================
 void BlockMemory::init(
     const uint32_t num_i,   // number of inputs
@@ -37,16 +57,16 @@ void BlockMemory::init(
     this->num_i = num_i;
     this->num_d = num_d;
     this->num_rpd = num_rpd;
-    this->num_r = num_d * num_rpd;
-    this->perm_thr = perm_thr;
-    this->perm_inc = perm_inc;
-    this->perm_dec = perm_dec;
+    this->num_r = (uint64_t)num_d * num_rpd;
     this->pct_learn = pct_learn;
+    setup_perms(perm_thr, perm_inc, perm_dec);
+    check_sizes();
+    setup_slots();
+    reset_tiers();
 
     // Resize data arrays based on parameters
     state.resize(num_d);
-    r_addrs.resize(num_r);
-    r_perms.resize(num_r);
+    resize_slots(r_addrs, r_perms, num_d);
     lmask.resize(num_rpd);
 
     // Setup learning mask
@@ -57,6 +77,7 @@ void BlockMemory::init(
     memset(r_perms.data(), 0, r_perms.size() * sizeof(r_perms[0]));
 
     init_flag = true;
+    touch();
 }
 
 // =============================================================================
@@ -84,6 +105,7 @@ void BlockMemory::init_conn(
         d_conns[d].resize(num_i);
 
     init_flag = true;
+    touch();
     conns_flag = true;
 }
 
@@ -128,20 +150,30 @@ void BlockMemory::init_pooled(
     assert(perm_inc <= PERM_MAX);
     assert(perm_dec <= PERM_MAX);
 
+    // Get the number of input bits each dendrite samples from
+    uint32_t num_f = num_i;
+
+    if (pool_cap > 0 && pool_field > 0 && pool_field < num_i)
+        num_f = pool_field;
+
     // Setup parameters
     this->num_i = num_i;
     this->num_d = num_d;
-    this->num_rpd = (uint32_t)(num_i * pct_pool);
-    this->num_r = num_d * num_rpd;
-    this->perm_thr = perm_thr;
-    this->perm_inc = perm_inc;
-    this->perm_dec = perm_dec;
+    this->num_rpd = (uint32_t)(num_f * pct_pool);
+
+    if (pool_cap > 0 && num_rpd > pool_cap)
+        this->num_rpd = pool_cap;
+
+    this->num_r = (uint64_t)num_d * num_rpd;
     this->pct_learn = pct_learn;
+    setup_perms(perm_thr, perm_inc, perm_dec);
+    check_sizes();
+    setup_slots();
+    reset_tiers();
 
     // Resize data arrays based on parameters
     state.resize(num_d);
-    r_addrs.resize(num_r);
-    r_perms.resize(num_r);
+    resize_slots(r_addrs, r_perms, num_d);
     lmask.resize(num_rpd);
 
     // Setup learning mask
@@ -149,6 +181,14 @@ void BlockMemory::init_pooled(
 
     // Setup data arrays using pooled
     uint32_t num_init = (uint32_t)(num_rpd * pct_conn);
+
+    if (pool_cap > 0) {
+        init_capped(num_f, num_init, rng);
+        init_flag = true;
+        touch();
+        return;
+    }
+
     std::vector<uint32_t> rand_addrs(num_i);
 
     for (uint32_t i = 0; i < num_i; i++)
@@ -157,26 +197,103 @@ void BlockMemory::init_pooled(
     // Loop through each dendrite
     for (uint32_t d = 0; d < num_d; d++) {
 
-        uint32_t j = 0;
-        uint32_t r_beg = d * num_rpd;
-        uint32_t r_end = r_beg + num_rpd;
+        uint32_t* addrs = dendrite_addrs(d);
+        uint8_t* perms = dendrite_perms(d);
 
         utils_shuffle(rand_addrs, num_i, rng);
 
         // Loop through each receptor on the dendrite
-        for (uint32_t r = r_beg; r < r_end; r++) {
-            r_addrs[r] = rand_addrs[j];
+        for (uint32_t j = 0; j < num_rpd; j++) {
+            addrs[j] = rand_addrs[j];
 
             if (j < num_init)
-                r_perms[r] = perm_thr;
+                set_perm(perms, j, this->perm_thr);
             else
-                r_perms[r] = perm_thr - 1;
-
-            j++;
+                set_perm(perms, j, this->perm_thr - 1);
         }
+
+        recount(d);
     }
 
     init_flag = true;
+    touch();
+}
+
+// =============================================================================
+// # Initialize Capped
+//
+// Defines the receptors of capped pools (see set_pool_cap).  Each dendrite
+// samples num_rpd distinct addresses from its field of num_f input bits with
+// Floyd's algorithm, so the cost is O(num_rpd) per dendrite instead of
+// O(num_i).  When the field is narrower than the input it is centered on the
+// dendrite's evenly spaced position in the input and wraps around the ends.
+// Addresses are sorted within the field and a random num_init of them start
+// connected.
+//
+// ## Example
+//
+// memory.set_pool_cap(4, 8);
+// memory.init_pooled(32, 4, 0.8, 0.5, 0.3, 20, 2, 1, rng);
+//
+// d=1 field: {00000000111111110000000000000000} centered on bit 12
+//     addrs: {09 11 12 14}
+//     perms: {20 19 20 19}
+// =============================================================================
+void BlockMemory::init_capped(
+    const uint32_t num_f,    // number of input bits in each dendrite's field
+    const uint32_t num_init, // number of initially connected receptors
+    std::mt19937& rng)
+{
+
+    assert(num_rpd <= num_f);
+
+    std::unordered_set<uint32_t> picked;
+    std::vector<uint32_t> offs(num_rpd);
+    std::vector<uint32_t> init_perms(num_rpd);
+
+    picked.reserve(num_rpd * 2);
+
+    for (uint32_t j = 0; j < num_rpd; j++)
+        init_perms[j] = j < num_init ? perm_thr : perm_thr - 1;
+
+    // Loop through each dendrite
+    for (uint32_t d = 0; d < num_d; d++) {
+
+        uint32_t* addrs = dendrite_addrs(d);
+        uint8_t* perms = dendrite_perms(d);
+
+        // Get the first input bit of the dendrite's field
+        uint32_t beg = 0;
+
+        if (num_f < num_i) {
+            uint64_t center = ((2 * (uint64_t)d + 1) * num_i) / (2 * num_d);
+            beg = (uint32_t)((center + num_i - num_f / 2) % num_i);
+        }
+
+        // Sample distinct field offsets
+        picked.clear();
+
+        for (uint32_t t = num_f - num_rpd, j = 0; t < num_f; t++, j++) {
+            uint32_t r = rng() % (t + 1);
+
+            if (!picked.insert(r).second) {
+                r = t;
+                picked.insert(r);
+            }
+
+            offs[j] = r;
+        }
+
+        std::sort(offs.begin(), offs.end());
+        utils_shuffle(init_perms, num_rpd, rng);
+
+        for (uint32_t j = 0; j < num_rpd; j++) {
+            addrs[j] = (uint32_t)(((uint64_t)beg + offs[j]) % num_i);
+            set_perm(perms, j, (uint8_t)init_perms[j]);
+        }
+
+        recount(d);
+    }
 }
 
 // =============================================================================
@@ -199,6 +316,11 @@ void BlockMemory::init_pooled_conn(
     init_pooled(num_i, num_d, pct_pool, pct_conn, pct_learn, perm_thr, perm_inc,
                 perm_dec, rng);
 
+    // Capped pools skip the num_i-bit connection arrays so memory and overlap
+    // cost scale with the cap.  The *_conn functions then use the receptors.
+    if (pool_cap > 0)
+        return;
+
     d_conns.resize(num_d);
 
     for (uint32_t d = 0; d < num_d; d++) {
@@ -207,29 +329,297 @@ void BlockMemory::init_pooled_conn(
     }
 
     init_flag = true;
+    touch();
     conns_flag = true;
 }
 
+// =============================================================================
+// # Set Permanence Bits
+//
+// Sets the receptor permanence precision used by the next initialization.
+// Permanences are stored packed: 8 bits (0 to 99, the default), 4 bits (0 to
+// 15) or 2 bits (0 to 3).  Lower precisions halve or quarter r_perms memory and
+// bandwidth.  The perm_thr, perm_inc and perm_dec parameters given to the
+// initializers keep their 0 to 99 meaning and are rescaled as follows:
+//
+// scale    = perm_max / 99                        (15/99 or 3/99)
+// perm_thr = round(perm_thr * scale)
+// perm_inc = floor(perm_inc * scale) + 1 with probability frac(perm_inc * scale)
+// perm_dec = floor(perm_dec * scale) + 1 with probability frac(perm_dec * scale)
+//
+// Stochastic rounding of the steps preserves the expected drift of each
+// receptor, and so the inc/dec ratio, even when a step is smaller than one
+// quantization level.
+//
+// ## Example
+//
+// memory.set_perm_bits(PERM_BITS_4);
+// memory.init_pooled(32, 8, 0.8, 0.5, 0.3, 20, 2, 1, rng);
+//
+// perm_thr: 3 (20 * 15/99 = 3.03)
+// perm_inc: 0 + 1 with probability 0.303 (2 * 15/99)
+// perm_dec: 0 + 1 with probability 0.152 (1 * 15/99)
+// =============================================================================
+void BlockMemory::set_perm_bits(const uint8_t perm_bits) {
+
+    assert(perm_bits == PERM_BITS_8 ||
+           perm_bits == PERM_BITS_4 ||
+           perm_bits == PERM_BITS_2);
+
+    this->perm_bits = perm_bits;
+}
+
+// =============================================================================
+// # Check Sizes
+//
+// Receptor offsets are 64-bit, so num_d * num_rpd may exceed 2^32 receptors,
+// but a dendrite's record (slot_words) and permanence row (perm_stride) are
+// 32-bit and the receptor arrays must fit this host's address space.  Throws
+// std::length_error before anything is allocated if they do not.
+// =============================================================================
+void BlockMemory::check_sizes() {
+
+    uint64_t stride = ((uint64_t)num_rpd + perm_jmask) >> perm_jshift;
+    uint64_t words = num_rpd;
+    uint64_t num_p = (uint64_t)num_d * stride;
+
+    if (ilv_flag) {
+        uint64_t align = RECORD_ALIGN / sizeof(uint32_t);
+        words = (1 + num_rpd + (stride + 3) / 4 + align - 1) / align * align;
+        num_p = 0;
+    }
+
+    if (words > UINT32_MAX || stride > UINT32_MAX)
+        throw std::length_error(
+            "BlockMemory: too many receptors per dendrite");
+
+    uint64_t num_w = (uint64_t)num_d * words;
+
+    if (num_w > (uint64_t)r_addrs.max_size() ||
+        num_p > (uint64_t)r_perms.max_size() ||
+        num_w * sizeof(uint32_t) > (uint64_t)SIZE_MAX - num_p)
+        throw std::length_error(
+            "BlockMemory: receptor arrays exceed the address space");
+}
+
+// =============================================================================
+// # Set Pool Cap
+//
+// Caps the receptors per dendrite used by the next init_pooled.  Without a cap
+// each dendrite gets num_i * pct_pool receptors, which grows with input width.
+// With a cap each dendrite gets min(num_f * pct_pool, max_rpd) receptors
+// sampled sparsely from a field of num_f input bits, where num_f is field if
+// given (a local receptive field) and num_i otherwise.  Capped memories do not
+// keep connection BitArrays, so memory and overlap cost follow the cap rather
+// than the input width.  A max_rpd of 0 turns the cap off.
+//
+// ## Example
+//
+// memory.set_pool_cap(128, 4096);
+// memory.init_pooled_conn(100000, 1000, 0.8, 0.5, 0.3, 20, 2, 1, rng);
+//
+// num_rpd: 128 (instead of 80000)
+// =============================================================================
+void BlockMemory::set_pool_cap(const uint32_t max_rpd, const uint32_t field) {
+
+    this->pool_cap = max_rpd;
+    this->pool_field = field;
+}
+
+// =============================================================================
+// # Set Interleaved
+//
+// Selects the receptor layout used by the next initialization.  By default
+// addresses and permanences live in two separate arrays, so reading one
+// receptor touches two distant cache lines.  Interleaved memories store each
+// dendrite as one record aligned to RECORD_ALIGN bytes instead: a header word
+// with the number of connected receptors, the addresses, then the packed
+// permanences.  Overlaps of dendrites without connected receptors return
+// after one load and scans stop once every connected receptor is seen.
+// Padding records to whole cache lines costs up to RECORD_ALIGN - 1 bytes per
+// dendrite, which memory_usage() and num_record_bytes() report.  Saved files
+// use the same format for both layouts.
+//
+// ## Example
+//
+// memory.set_interleaved(true);
+// memory.init_pooled(1024, 100, 0.0625, 0.5, 1.0, 20, 2, 1, rng);
+//
+// num_rpd: 64, perm_stride: 64 bytes
+//
+// record: |conns|addrs[0..63]|perms[0..63]|padding|
+// bytes:  |  4  |    256     |     64     |   60  |  = 384 = 6 cache lines
+// =============================================================================
+void BlockMemory::set_interleaved(const bool flag) {
+
+    this->ilv_flag = flag;
+}
+
+// =============================================================================
+// # Setup Slots
+//
+// Computes the r_addrs words used by each hot dendrite slot.
+// =============================================================================
+void BlockMemory::setup_slots() {
+
+    if (!ilv_flag) {
+        slot_words = num_rpd;
+        return;
+    }
+
+    uint32_t align = RECORD_ALIGN / sizeof(uint32_t);
+    uint32_t words = 1 + num_rpd + (perm_stride + 3) / 4;
+
+    slot_words = (words + align - 1) / align * align;
+}
+
 // =============================================================================
 // # Save
 //
-// Saves memories.
+// Saves memories behind a header describing their shape and permanence
+// precision, so load() can reject files that do not match.  Receptor addresses
+// are written in dendrite order followed by permanences, whatever the
+// in-memory layout (see set_interleaved).  A memory with a non-default
+// dendrite layout (see relayout and update_tiers) is followed by its layout
+// table, the dendrites in physical order.
+//
+// header: magic, version, flags, perm_bits, num_d, num_rpd (uint32)
+//  addrs: num_d * num_rpd uint32
+//  perms: num_d * perm_stride bytes
+//  order: num_d uint32 (if BLOCK_MEMORY_LAYOUT)
 // =============================================================================
 void BlockMemory::save(FILE* fptr) {
 
-    std::fwrite(r_addrs.data(), sizeof(r_addrs[0]), r_addrs.size(), fptr);
-    std::fwrite(r_perms.data(), sizeof(r_perms[0]), r_perms.size(), fptr);
+    uint32_t header[6] = {
+        BLOCK_MEMORY_MAGIC, BLOCK_MEMORY_VERSION,
+        d_slots.empty() ? 0u : BLOCK_MEMORY_LAYOUT,
+        perm_bits, num_d, num_rpd};
+
+    std::fwrite(header, sizeof(header[0]), 6, fptr);
+
+    if (d_slots.empty() && !ilv_flag) {
+        std::fwrite(r_addrs.data(), sizeof(r_addrs[0]), r_addrs.size(), fptr);
+        std::fwrite(r_perms.data(), sizeof(r_perms[0]), r_perms.size(), fptr);
+        return;
+    }
+
+    // Write tiered and interleaved memories in dendrite order without thawing
+    const uint32_t* addrs;
+    const uint8_t* perms;
+
+    for (uint32_t d = 0; d < num_d; d++) {
+        view(d, addrs, perms);
+        std::fwrite(addrs, sizeof(addrs[0]), num_rpd, fptr);
+    }
+
+    for (uint32_t d = 0; d < num_d; d++) {
+        view(d, addrs, perms);
+        std::fwrite(perms, sizeof(perms[0]), perm_stride, fptr);
+    }
+
+    if (d_slots.empty())
+        return;
+
+    // Write dendrites in physical order (cold dendrites last)
+    std::vector<uint32_t> order(num_d);
+
+    for (uint32_t d = 0; d < num_d; d++)
+        order[d] = d;
+
+    std::stable_sort(order.begin(), order.end(),
+        [this](uint32_t a, uint32_t b) { return d_slots[a] < d_slots[b]; });
+
+    std::fwrite(order.data(), sizeof(order[0]), num_d, fptr);
 }
 
 // =============================================================================
 // # Load
 //
-// Loads memories.
+// Loads memories written by save(), restoring the dendrite layout if one was
+// saved.  Returns false and leaves the memory and file position unchanged if
+// the file's permanence precision, number of dendrites or receptors per
+// dendrite differ from this memory's, its version is unknown or it ends
+// early.  Files without a header, written before it existed, hold 8-bit
+// permanences and are only read into 8-bit memories.  The file is read into
+// temporary arrays before the memory is changed.  Cold dendrites are loaded
+// hot.
 // =============================================================================
-void BlockMemory::load(FILE* fptr) {
+bool BlockMemory::load(FILE* fptr) {
+
+    assert(init_flag);
+
+    uint32_t header[6] = {0, 0, 0, 0, 0, 0};
+    long beg = std::ftell(fptr);
+
+    if (std::fread(header, sizeof(header[0]), 3, fptr) != 3 ||
+        header[0] != BLOCK_MEMORY_MAGIC) {
+        std::fseek(fptr, beg, SEEK_SET);
+        header[2] = 0;
+
+        if (perm_bits != PERM_BITS_8)
+            return false;
+    }
+    else if (header[1] != BLOCK_MEMORY_VERSION ||
+             std::fread(&header[3], sizeof(header[0]), 3, fptr) != 3 ||
+             header[3] != perm_bits ||
+             header[4] != num_d ||
+             header[5] != num_rpd) {
+        std::fseek(fptr, beg, SEEK_SET);
+        return false;
+    }
+
+    std::vector<uint32_t> addrs((size_t)num_r);
+    std::vector<uint8_t> perms((size_t)num_d * perm_stride);
+    std::vector<uint32_t> order;
 
-    std::fread(r_addrs.data(), sizeof(r_addrs[0]), r_addrs.size(), fptr);
-    std::fread(r_perms.data(), sizeof(r_perms[0]), r_perms.size(), fptr);
+    bool ok =
+        std::fread(addrs.data(), sizeof(addrs[0]), addrs.size(), fptr) ==
+            addrs.size() &&
+        std::fread(perms.data(), sizeof(perms[0]), perms.size(), fptr) ==
+            perms.size();
+
+    // The layout table must list every dendrite once
+    if (ok && (header[2] & BLOCK_MEMORY_LAYOUT)) {
+        std::vector<uint8_t> seen(num_d, 0);
+        order.resize(num_d);
+
+        ok = std::fread(order.data(), sizeof(order[0]), num_d, fptr) == num_d;
+
+        for (uint32_t i = 0; ok && i < num_d; i++) {
+            ok = order[i] < num_d && !seen[order[i]];
+
+            if (ok)
+                seen[order[i]] = 1;
+        }
+    }
+
+    if (!ok) {
+        std::fseek(fptr, beg, SEEK_SET);
+        return false;
+    }
+
+    reset_tiers();
+    resize_slots(r_addrs, r_perms, num_d);
+
+    // Scatter the split arrays into the in-memory layout
+    for (uint32_t d = 0; d < num_d; d++) {
+        memcpy(dendrite_addrs(d), &addrs[(size_t)d * num_rpd],
+               num_rpd * sizeof(addrs[0]));
+        memcpy(dendrite_perms(d), &perms[(size_t)d * perm_stride],
+               perm_stride);
+        recount(d);
+    }
+
+    if (!order.empty())
+        apply_layout(order);
+
+    if (conns_flag)
+        for (uint32_t d = 0; d < num_d; d++)
+            update_conns(d);
+
+    touch();
+
+    return true;
 }
 
 // =============================================================================
@@ -247,11 +637,11 @@ void BlockMemory::clear() {
 //
 // Returns an estimate of the number of bytes used.
 // =============================================================================
-uint32_t BlockMemory::memory_usage() {
+uint64_t BlockMemory::memory_usage() {
 
     assert(init_flag);
 
-    uint32_t bytes = 0;
+    uint64_t bytes = 0;
 
     bytes += state.memory_usage();
     bytes += sizeof(init_flag);
@@ -263,12 +653,21 @@ uint32_t BlockMemory::memory_usage() {
     bytes += sizeof(perm_inc);
     bytes += sizeof(perm_dec);
     bytes += sizeof(pct_learn);
-    bytes += (sizeof(r_addrs[0]) * num_r);
-    bytes += (sizeof(r_perms[0]) * num_r);
+    bytes += sizeof(perm_bits);
+    bytes += sizeof(ilv_flag);
+    bytes += sizeof(slot_words);
+    bytes += (sizeof(r_addrs[0]) * (uint64_t)r_addrs.size());
+    bytes += (sizeof(r_perms[0]) * (uint64_t)r_perms.size());
     bytes += lmask.memory_usage();
+    bytes += (sizeof(d_slots[0]) * (uint64_t)d_slots.size());
+    bytes += (sizeof(d_hits[0]) * (uint64_t)d_hits.size());
+    bytes += (sizeof(d_cold[0]) * (uint64_t)d_cold.size());
 
-    if (conns_flag)
-        bytes += (d_conns[0].memory_usage() * num_d);
+    for (uint32_t d = 0; d < d_cold.size(); d++)
+        bytes += d_cold[d].capacity();
+
+    for (uint32_t d = 0; d < d_conns.size(); d++)
+        bytes += d_conns[d].memory_usage();
 
     return bytes;
 }
@@ -277,7 +676,11 @@ uint32_t BlockMemory::memory_usage() {
 // # Overlap
 //
 // Computes a particular dendrite's overlap value by comparing the input
-// BitArray with the dendrite's receptors.
+// BitArray with the dendrite's receptors.  The input may also be a BitSpan over
+// part of a larger BitArray, in which case receptor addresses are relative to
+// the start of the span.  With hit_flag false the access is not counted for
+// tiering or tracing, so several threads may overlap one shared memory (see
+// SequenceLearner::backfill).
 //
 // The overlap score is incremented if these conditions are met:
 //
@@ -298,21 +701,48 @@ uint32_t BlockMemory::memory_usage() {
 //
 //  overlap: 3
 // =============================================================================
-uint32_t BlockMemory::overlap(const uint32_t d, BitArray& input) {
+uint32_t BlockMemory::overlap(
+        const uint32_t d,
+        const BitSpan& input,
+        const bool hit_flag) {
 
     assert(init_flag);
     assert(d < num_d);
 
     uint32_t overlap = 0;
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
+    const uint32_t* addrs;
+    const uint8_t* perms;
+
+    if (hit_flag)
+        hit(d);
+
+    // Interleaved records know their connected receptor count
+    if (ilv_flag && !is_cold(d)) {
+        const uint32_t* rec = &r_addrs[slot(d) * slot_words];
+        uint32_t num_left = rec[0];
+
+        addrs = rec + 1;
+        perms = (const uint8_t*)(addrs + num_rpd);
+
+        // Stop once every connected receptor has been checked
+        for (uint32_t j = 0; num_left > 0 && j < num_rpd; j++) {
+            if (get_perm(perms, j) >= perm_thr) {
+                overlap += input.get_bit(addrs[j]);
+                num_left--;
+            }
+        }
+
+        return overlap;
+    }
+
+    view(d, addrs, perms);
 
     // For each receptor on the dendrite
-    for (uint32_t r = r_beg; r < r_end; r++) {
+    for (uint32_t j = 0; j < num_rpd; j++) {
 
         // If receptor is connected and it's connected bit is active
         // Then increment overlap score
-        if (r_perms[r] >= perm_thr && input.get_bit(r_addrs[r]))
+        if (get_perm(perms, j) >= perm_thr && input.get_bit(addrs[j]))
             overlap++;
     }
 
@@ -322,15 +752,40 @@ uint32_t BlockMemory::overlap(const uint32_t d, BitArray& input) {
 // =============================================================================
 // # Overlap (Connections)
 //
-// See overlap function for description.
+// See overlap function for description.  Memories with capped pools keep no
+// connection BitArrays, so this and the other *_conn functions fall back to
+// the receptor versions for them.  Cold dendrites drop their connection
+// BitArray (see update_tiers) and count their sorted receptors instead, each
+// connected address once.
 // =============================================================================
-uint32_t BlockMemory::overlap_conn(const uint32_t d, BitArray& input) {
+uint32_t BlockMemory::overlap_conn(const uint32_t d, const BitSpan& input) {
 
     assert(init_flag);
-    assert(conns_flag);
     assert(d < num_d);
 
-    return d_conns[d].num_similar(input);
+    if (!conns_flag)
+        return overlap(d, input);
+
+    hit(d);
+
+    if (!is_cold(d))
+        return BitSpan(d_conns[d]).num_similar(input);
+
+    uint32_t overlap = 0;
+    uint32_t prev = UINT32_MAX;
+    const uint32_t* addrs;
+    const uint8_t* perms;
+
+    view(d, addrs, perms);
+
+    for (uint32_t j = 0; j < num_rpd; j++) {
+        if (get_perm(perms, j) >= perm_thr && addrs[j] != prev) {
+            overlap += input.get_bit(addrs[j]);
+            prev = addrs[j];
+        }
+    }
+
+    return overlap;
 }
 
 // =============================================================================
@@ -349,7 +804,7 @@ uint32_t BlockMemory::overlap_conn(const uint32_t d, BitArray& input) {
 // - Active: Increment permanence if input bit at the receptor address is 1
 // - Inactive: Decrement permanence if input bit at the receptor address is 0
 // - Minumum permanence value is 0
-// - Maximum permanence value is 99
+// - Maximum permanence value is 99 (or 15/3 for 4/2-bit permanences)
 //
 // ## Example
 //
@@ -364,37 +819,48 @@ uint32_t BlockMemory::overlap_conn(const uint32_t d, BitArray& input) {
 // =============================================================================
 void BlockMemory::learn(
     const uint32_t d,
-    BitArray& input,
+    const BitSpan& input,
     std::mt19937& rng)
 {
 
     assert(init_flag);
     assert(d < num_d);
 
+    touch();
+    hit(d);
+    thaw(d);
+
     // Shuffle the learning mask
     if (pct_learn < 1.0)
         lmask.random_shuffle(rng);
 
-    // Get dendrite's receptor boundaries
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
-    uint32_t l = 0;
+    // Get dendrite's receptors
+    uint32_t* addrs = dendrite_addrs(d);
+    uint8_t* perms = dendrite_perms(d);
+    int32_t num_conn = 0; // change in connected receptors
 
     // Loop through each receptor
-    for (uint32_t r = r_beg; r < r_end; r++) {
+    for (uint32_t j = 0; j < num_rpd; j++) {
 
         // If learning mask is set
-        if (lmask.get_bit(l++)) {
+        if (lmask.get_bit(j)) {
+            int32_t perm = get_perm(perms, j);
+            num_conn -= perm >= perm_thr;
 
             // Increment permanence if receptor's input is active
-            if (input.get_bit(r_addrs[r]) > 0)
-                r_perms[r] = utils_min(r_perms[r] + perm_inc, PERM_MAX);
+            if (input.get_bit(addrs[j]) > 0)
+                perm = utils_min(perm + step_inc(rng), (int32_t)perm_max);
 
             // Decrement permanence if receptor's input is inactive
             else
-                r_perms[r] = utils_max(r_perms[r] - perm_dec, PERM_MIN);
+                perm = utils_max(perm - step_dec(rng), PERM_MIN);
+
+            set_perm(perms, j, (uint8_t)perm);
+            num_conn += perm >= perm_thr;
         }
     }
+
+    add_conns(d, num_conn);
 }
 
 // =============================================================================
@@ -404,16 +870,17 @@ void BlockMemory::learn(
 // =============================================================================
 void BlockMemory::learn_conn(
     const uint32_t d,
-    BitArray& input,
+    const BitSpan& input,
     std::mt19937& rng)
 {
 
     assert(init_flag);
-    assert(conns_flag);
     assert(d < num_d);
 
     learn(d, input, rng);
-    update_conns(d);
+
+    if (conns_flag)
+        update_conns(d);
 }
 
 // =============================================================================
@@ -451,45 +918,54 @@ void BlockMemory::learn_move(
     assert(init_flag);
     assert(d < num_d);
 
-    uint32_t l = 0;
+    touch();
+    hit(d);
+    thaw(d);
+
     uint32_t next_addr = 0;
 
     // Shuffle the learning mask
     if (pct_learn < 1.0)
         lmask.random_shuffle(rng);
 
-    // Get dendrite's receptor boundaries
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
+    // Get dendrite's receptors
+    uint32_t* addrs = dendrite_addrs(d);
+    uint8_t* perms = dendrite_perms(d);
+    int32_t num_conn = 0; // change in connected receptors
 
     // FIXME: available input bits here are selected from already connected receptors.
     // FIXME: should sample over unconnected input space
 
-    // Get available input bits
-    BitArray available = input;
+    // Get available input bits (reuses the scratch BitArray's words)
+    available.assign(bitexpr(input));
 
     // clear bits we are already have receptors
-    for (uint32_t r = r_beg; r < r_end; r++) {
-        if (r_perms[r] > 0)
-            available.clear_bit(r_addrs[r]);
+    for (uint32_t j = 0; j < num_rpd; j++) {
+        if (get_perm(perms, j) > 0)
+            available.clear_bit(addrs[j]);
     }
 
     // Loop through each receptor
-    for (uint32_t r = r_beg; r < r_end; r++) {
+    for (uint32_t j = 0; j < num_rpd; j++) {
 
         // If learning mask is set
-        if (lmask.get_bit(l++)) {
+        if (lmask.get_bit(j)) {
+            int32_t perm = get_perm(perms, j);
 
             // If receptor permanence is above zero then perform normal learning
-            if (r_perms[r] > 0) {
+            if (perm > 0) {
+                num_conn -= perm >= perm_thr;
 
                 // Increment permanence if receptor's input is active
-                if (input.get_bit(r_addrs[r]) > 0)
-                    r_perms[r] = utils_min(r_perms[r] + perm_inc, PERM_MAX);
+                if (input.get_bit(addrs[j]) > 0)
+                    perm = utils_min(perm + step_inc(rng), (int32_t)perm_max);
 
                 // Decrement permanence if receptor's input is inactive
                 else
-                    r_perms[r] = utils_max(r_perms[r] - perm_dec, PERM_MIN);
+                    perm = utils_max(perm - step_dec(rng), PERM_MIN);
+
+                set_perm(perms, j, (uint8_t)perm);
+                num_conn += perm >= perm_thr;
             }
 
             // If receptor permanence is below zero then move address to an
@@ -500,12 +976,15 @@ void BlockMemory::learn_move(
                 if (!pass)
                     continue;
 
-                r_addrs[r] = next_addr;
-                r_perms[r] = perm_thr;
+                addrs[j] = next_addr;
+                set_perm(perms, j, perm_thr);
                 available.clear_bit(next_addr);
+                num_conn += perm < perm_thr;
         }
         }
     }
+
+    add_conns(d, num_conn);
 }
 
 // =============================================================================
@@ -520,11 +999,12 @@ void BlockMemory::learn_move_conn(
 {
 
     assert(init_flag);
-    assert(conns_flag);
     assert(d < num_d);
 
     learn_move(d, input, rng);
-    update_conns(d);
+
+    if (conns_flag)
+        update_conns(d);
 }
 
 // =============================================================================
@@ -546,33 +1026,44 @@ void BlockMemory::learn_move_conn(
 // =============================================================================
 void BlockMemory::punish(
     const uint32_t d,
-    BitArray& input,
+    const BitSpan& input,
     std::mt19937& rng)
 {
 
     assert(init_flag);
     assert(d < num_d);
 
+    touch();
+    hit(d);
+    thaw(d);
+
     // Shuffle the learning mask
     if (pct_learn < 1.0)
         lmask.random_shuffle(rng);
 
-    // Get dendrite's receptor boundaries
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
-    uint32_t l = 0;
+    // Get dendrite's receptors
+    uint32_t* addrs = dendrite_addrs(d);
+    uint8_t* perms = dendrite_perms(d);
+    int32_t num_conn = 0; // change in connected receptors
 
     // Loop through each receptor
-    for (uint32_t r = r_beg; r < r_end; r++) {
+    for (uint32_t j = 0; j < num_rpd; j++) {
 
         // If receptor learning mask is set
-        if (lmask.get_bit(l++)) {
+        if (lmask.get_bit(j)) {
 
             // Decrement permanence by perm_inc if receptor's input is active
-            if (input.get_bit(r_addrs[r]) > 0)
-                r_perms[r] = utils_max(r_perms[r] - perm_inc, PERM_MIN);
+            if (input.get_bit(addrs[j]) > 0) {
+                int32_t perm = get_perm(perms, j);
+                num_conn -= perm >= perm_thr;
+                perm = utils_max(perm - step_inc(rng), PERM_MIN);
+                set_perm(perms, j, (uint8_t)perm);
+                num_conn += perm >= perm_thr;
+            }
         }
     }
+
+    add_conns(d, num_conn);
 }
 
 // =============================================================================
@@ -582,159 +1073,909 @@ void BlockMemory::punish(
 // =============================================================================
 void BlockMemory::punish_conn(
     const uint32_t d,
-    BitArray& input,
+    const BitSpan& input,
     std::mt19937& rng)
 {
 
     assert(init_flag);
-    assert(conns_flag);
     assert(d < num_d);
 
     punish(d, input, rng);
-    update_conns(d);
+
+    if (conns_flag)
+        update_conns(d);
 }
 
 // =============================================================================
-// # Print Receptor Addresses Dendrite
+// # Merge
 //
-// Prints the receptor addresses on a particular dendrite.
+// Merges the permanences of replicas trained in parallel back into this
+// memory.  Every replica must be a copy of this memory taken before training
+// and must not move receptors, so receptor j of dendrite d refers to the same
+// input address everywhere.  Connections are rebuilt if they are used.
+//
+// ## Modes
+//
+// MERGE_AVERAGE: p = round(mean(p_k))
+//   MERGE_DELTA: p = clamp(p + sum(p_k - p), 0, perm_max)
+//
+// ## Example
+//
+// base perm: 20, replica perms: {22, 18, 26}
+//
+// MERGE_AVERAGE: p = 22
+//   MERGE_DELTA: p = 20 + (2 - 2 + 6) = 26
 // =============================================================================
-void BlockMemory::print_addrs(const uint32_t d) {
+void BlockMemory::merge(
+        std::vector<BlockMemory*>& replicas,
+        const uint8_t mode) {
 
     assert(init_flag);
-    assert(d < num_d);
+    assert(replicas.size() > 0);
+    assert(mode == MERGE_AVERAGE || mode == MERGE_DELTA);
 
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
+    int32_t num_k = (int32_t)replicas.size();
 
-    std::cout << "{";
+    for (uint32_t k = 0; k < replicas.size(); k++) {
+        assert(replicas[k]->num_r == num_r);
+        assert(replicas[k]->perm_bits == perm_bits);
+        replicas[k]->decompress_all();
+    }
 
-    for (uint32_t r = r_beg; r < r_end; r++) {
-        std::cout << r_addrs[r];
+    decompress_all();
 
-        if (r < r_end - 1)
-            std::cout << ", ";
-    }
+    touch();
 
-    std::cout << "}" << std::endl;
-}
+    // Loop through each dendrite
+    for (uint32_t d = 0; d < num_d; d++) {
+        uint8_t* perms = dendrite_perms(d);
 
-// =============================================================================
-// # Print Receptor Permanences Dendrite
-//
-// Prints the receptor permanences on a particular dendrite.
-// =============================================================================
-void BlockMemory::print_perms(const uint32_t d) {
+        // Loop through each receptor on the dendrite
+        for (uint32_t j = 0; j < num_rpd; j++) {
+            int32_t base = get_perm(perms, j);
+            int32_t sum = 0;
 
-    assert(init_flag);
-    assert(d < num_d);
+            for (int32_t k = 0; k < num_k; k++) {
+                uint8_t* k_perms = replicas[k]->dendrite_perms(d);
+                sum += get_perm(k_perms, j);
+            }
 
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
+            int32_t p;
 
-    std::cout << "{";
+            if (mode == MERGE_AVERAGE)
+                p = (sum + num_k / 2) / num_k;
+            else
+                p = base + sum - num_k * base;
 
-    for (uint32_t r = r_beg; r < r_end; r++) {
-        std::cout << (uint32_t)r_perms[r];
+            if (p < PERM_MIN)
+                p = PERM_MIN;
 
-        if (r < r_end - 1)
-            std::cout << ", ";
-    }
+            if (p > perm_max)
+                p = perm_max;
 
-    std::cout << "}" << std::endl;
+            set_perm(perms, j, (uint8_t)p);
+        }
+
+        recount(d);
+
+        if (conns_flag)
+            update_conns(d);
+    }
 }
 
 // =============================================================================
-// # Print Receptor Connections Dendrite
+// # Prefetch
 //
-// Prints the receptor connections on a particular dendrite.
+// Starts loading a dendrite's receptor addresses and permanences into cache
+// without counting an access.  Issue it a few dendrites ahead of overlap() so
+// the loads of several dendrites are in flight at once.  Cold dendrites are
+// skipped.
 // =============================================================================
-void BlockMemory::print_conns(const uint32_t d) {
+void BlockMemory::prefetch(const uint32_t d) {
 
-    assert(init_flag);
-    assert(conns_flag);
     assert(d < num_d);
 
-    d_conns[d].print_bits();
+    if (is_cold(d))
+        return;
+
+    // Interleaved records are one range: header, addresses and permanences
+    if (ilv_flag) {
+        prefetch_range(&r_addrs[slot(d) * slot_words],
+                       (1 + num_rpd) * sizeof(uint32_t) + perm_stride);
+        return;
+    }
+
+    prefetch_range(dendrite_addrs(d), num_rpd * sizeof(uint32_t));
+    prefetch_range(dendrite_perms(d), perm_stride);
 }
 
 // =============================================================================
-// # Get Dendrite Addresses
+// # Prefetch Inputs
 //
-// Returns the receptor addresses of a particular dendrite.
+// Starts loading the input words under a dendrite's connected receptors, the
+// random reads overlap() will make.  Reads the dendrite's receptors, so issue
+// prefetch(d) well before this.  Cold dendrites are skipped.
 // =============================================================================
-std::vector<uint32_t> BlockMemory::addrs(const uint32_t d) {
+void BlockMemory::prefetch_inputs(const uint32_t d, const BitSpan& input) {
 
-    assert(init_flag);
     assert(d < num_d);
 
-    uint32_t i = 0;
-    std::vector<uint32_t> addrs(num_rpd);
+    if (is_cold(d))
+        return;
 
-    // Get dendrite's receptor boundaries
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
+    const uint32_t* addrs = dendrite_addrs(d);
+    const uint8_t* perms = dendrite_perms(d);
 
-    // For each receptor on the dendrite
-    for (uint32_t r = r_beg; r < r_end; r++)
-        addrs[i++] = r_addrs[r];
+    if (ilv_flag && addrs[-1] == 0)
+        return;
 
-    return addrs;
+    for (uint32_t j = 0; j < num_rpd; j++)
+        if (get_perm(perms, j) >= perm_thr)
+            input.prefetch_bit(addrs[j]);
 }
 
 // =============================================================================
-// # Get Dendrite Permanences
+// # Set Tiering
 //
-// Returns the receptor permanences of a particular dendrite.
+// Turns hot/cold tiering on or off.  While on, overlap(), overlap_conn() and
+// the learning functions count accesses per dendrite for update_tiers(), and
+// kernels that compute overlaps another way call count_hits().  Turning it off
+// decompresses every cold dendrite.  Cold dendrites of memories with
+// connection BitArrays also drop their BitArray.
 // =============================================================================
-std::vector<uint8_t> BlockMemory::perms(const uint32_t d) {
+void BlockMemory::set_tiering(const bool flag) {
 
     assert(init_flag);
-    assert(d < num_d);
-
-    uint32_t i = 0;
-    std::vector<uint8_t> perms(num_rpd);
 
-    // Get dendrite's receptor boundaries
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
+    if (!flag)
+        decompress_all();
 
-    // For each receptor on the dendrite
-    for (uint32_t r = r_beg; r < r_end; r++)
-        perms[i++] = r_perms[r];
-
-    return perms;
+    tier_flag = flag;
+    d_hits.assign(flag ? num_d : 0, 0);
 }
 
 // =============================================================================
-// # Get Dendrite Connections
+// # Count Hits
 //
-// Returns the receptor connections of a particular dendrite.
+// Counts one access of every dendrite, for tiering and tracing, on behalf of
+// code that computes all overlaps without calling overlap() (see OverlapTuner).
 // =============================================================================
-std::vector<uint8_t> BlockMemory::conns(const uint32_t d) {
+void BlockMemory::count_hits() {
 
     assert(init_flag);
-    assert(d < num_d);
 
-    uint32_t i = 0;
-    std::vector<uint8_t> conns(num_i);
+    if (!tier_flag && !trace_flag)
+        return;
+
+    for (uint32_t d = 0; d < num_d; d++)
+        hit(d);
+}
+
+// =============================================================================
+// # Update Tiers
+//
+// Moves dendrites between a hot tier and a compressed cold tier based on how
+// often they were accessed since the last update, and returns the number of
+// cold dendrites.  Dendrites with fewer than min_hits accesses become cold and
+// cold dendrites with at least min_hits accesses become hot again.
+//
+// Hot dendrites stay uncompressed in r_addrs and r_perms, compacted into
+// contiguous slots, so the hot path is unchanged apart from one slot lookup.
+// Cold dendrites are stored as sorted varint delta addresses followed by their
+// packed permanences, usually a few bits per receptor instead of 32+.  Reads
+// of a cold dendrite (overlap, getters, save) decode it into a per-thread
+// scratch buffer.  Writes (learn, learn_move, punish) decompress it into a new
+// hot slot.  Receptors of a dendrite come back sorted by address, which does
+// not change overlaps.
+//
+// ## Example
+//
+// memory.set_tiering(true);
+//
+// (run the learner for a while)
+//
+// memory.update_tiers(1);
+//
+// hits: {12  0  3  0  0  7}
+// slot: { 0  C  1  C  C  2}   C = COLD_SLOT
+// =============================================================================
+uint32_t BlockMemory::update_tiers(const uint32_t min_hits) {
+
+    assert(init_flag);
+    assert(tier_flag);
+
+    if (d_slots.empty()) {
+        d_slots.resize(num_d);
+        d_cold.resize(num_d);
+
+        for (uint32_t d = 0; d < num_d; d++)
+            d_slots[d] = d;
+    }
+
+    // Keep hot dendrites in their current physical order (see relayout)
+    std::vector<uint32_t> order(num_d);
+
+    for (uint32_t d = 0; d < num_d; d++)
+        order[d] = d;
+
+    std::stable_sort(order.begin(), order.end(),
+        [this](uint32_t a, uint32_t b) { return d_slots[a] < d_slots[b]; });
+
+    // Compress hot dendrites that were rarely accessed and drop their
+    // connection BitArrays (see overlap_conn)
+    for (uint32_t d = 0; d < num_d; d++) {
+        if (!is_cold(d) && d_hits[d] < min_hits) {
+            encode_cold(d);
+
+            if (conns_flag)
+                d_conns[d].erase();
+        }
+    }
+
+    // Compact the remaining hot dendrites and decompress busy cold ones
+    addr_vector hot_addrs;
+    std::vector<uint8_t> hot_perms;
+    uint32_t num_hot = 0;
+
+    for (uint32_t d = 0; d < num_d; d++)
+        if (d_hits[d] >= min_hits)
+            num_hot++;
+
+    resize_slots(hot_addrs, hot_perms, num_hot);
+    num_hot = 0;
+
+    std::vector<uint32_t> thawed;
+
+    for (uint32_t i = 0; i < num_d; i++) {
+        uint32_t d = order[i];
+
+        // Release the slots of newly compressed dendrites
+        if (d_hits[d] < min_hits) {
+            d_slots[d] = COLD_SLOT;
+            continue;
+        }
+
+        if (is_cold(d)) {
+            decode_slot(hot_addrs, hot_perms, num_hot, d);
+            std::vector<uint8_t>().swap(d_cold[d]);
+            num_cold_d--;
+            thawed.push_back(d);
+        }
+        else
+            copy_slot(hot_addrs, hot_perms, num_hot, d);
+
+        d_slots[d] = num_hot++;
+    }
+
+    r_addrs.swap(hot_addrs);
+    r_perms.swap(hot_perms);
+    d_hits.assign(num_d, 0);
+
+    // Rebuild the connection BitArrays of dendrites that became hot
+    if (conns_flag)
+        for (uint32_t i = 0; i < thawed.size(); i++)
+            update_conns(thawed[i]);
+
+    return num_cold_d;
+}
+
+// =============================================================================
+// # Decompress All
+//
+// Decompresses every cold dendrite and restores the untiered layout where
+// dendrite d occupies slot d.  Access counting continues if tiering is on.
+// =============================================================================
+void BlockMemory::decompress_all() {
+
+    if (d_slots.empty())
+        return;
+
+    addr_vector all_addrs;
+    std::vector<uint8_t> all_perms;
+    std::vector<uint32_t> thawed;
+
+    resize_slots(all_addrs, all_perms, num_d);
+
+    for (uint32_t d = 0; d < num_d; d++) {
+        if (is_cold(d)) {
+            decode_slot(all_addrs, all_perms, d, d);
+            thawed.push_back(d);
+        }
+        else
+            copy_slot(all_addrs, all_perms, d, d);
+    }
+
+    r_addrs.swap(all_addrs);
+    r_perms.swap(all_perms);
+    d_slots.clear();
+    d_cold.clear();
+    num_cold_d = 0;
+
+    if (conns_flag)
+        for (uint32_t i = 0; i < thawed.size(); i++)
+            update_conns(thawed[i]);
+}
+
+// =============================================================================
+// # Reset Tiers
+//
+// Drops the tiered layout before the receptor arrays are rebuilt.
+// =============================================================================
+void BlockMemory::reset_tiers() {
+
+    d_slots.clear();
+    d_cold.clear();
+    num_cold_d = 0;
+
+    if (tier_flag)
+        d_hits.assign(num_d, 0);
+}
+
+// =============================================================================
+// # Thaw
+//
+// Decompresses a cold dendrite into a new hot slot so it can be modified.
+// =============================================================================
+void BlockMemory::thaw(const uint32_t d) {
+
+    if (!is_cold(d))
+        return;
+
+    size_t s = r_addrs.size() / slot_words;
+
+    resize_slots(r_addrs, r_perms, s + 1);
+    decode_slot(r_addrs, r_perms, s, d);
+
+    std::vector<uint8_t>().swap(d_cold[d]);
+    d_slots[d] = (uint32_t)s;
+    num_cold_d--;
+
+    if (conns_flag)
+        update_conns(d);
+}
+
+// =============================================================================
+// # View
+//
+// Gets read-only pointers to a dendrite's addresses and packed permanences.
+// Cold dendrites are decoded into a per-thread scratch buffer that stays valid
+// until the next view() of a cold dendrite on the same thread.
+// =============================================================================
+void BlockMemory::view(
+    const uint32_t d,
+    const uint32_t*& addrs,
+    const uint8_t*& perms)
+{
+
+    if (!is_cold(d)) {
+        addrs = dendrite_addrs(d);
+        perms = dendrite_perms(d);
+        return;
+    }
+
+    static thread_local std::vector<uint32_t> cold_addrs;
+    static thread_local std::vector<uint8_t> cold_perms;
+
+    cold_addrs.resize(num_rpd);
+    cold_perms.resize(perm_stride);
+    decode_cold(d, cold_addrs.data(), cold_perms.data());
+
+    addrs = cold_addrs.data();
+    perms = cold_perms.data();
+}
+
+// =============================================================================
+// # Encode Cold
+//
+// Compresses a hot dendrite into d_cold[d]: receptors sorted by address, the
+// address deltas as LEB128 varints, then the permanences packed at perm_bits
+// in the same order.  The dendrite's hot slot is released by update_tiers().
+//
+// ## Example
+//
+// addrs: {40 03 17 18}    perms: {20 19 21 00}
+// sorted: {03 17 18 40}   perms: {19 21 00 20}
+// deltas: {03 14 01 22}   (one byte each)
+// =============================================================================
+void BlockMemory::encode_cold(const uint32_t d) {
+
+    const uint32_t* addrs = dendrite_addrs(d);
+    const uint8_t* perms = dendrite_perms(d);
+
+    std::vector<std::pair<uint32_t, uint8_t>> recs(num_rpd);
+
+    for (uint32_t j = 0; j < num_rpd; j++)
+        recs[j] = std::make_pair(addrs[j], get_perm(perms, j));
+
+    std::sort(recs.begin(), recs.end());
+
+    std::vector<uint8_t>& blob = d_cold[d];
+    uint32_t prev = 0;
+
+    blob.clear();
+
+    for (uint32_t j = 0; j < num_rpd; j++) {
+        uint32_t delta = recs[j].first - prev;
+        prev = recs[j].first;
+
+        while (delta >= 0x80) {
+            blob.push_back((uint8_t)(delta | 0x80));
+            delta >>= 7;
+        }
+
+        blob.push_back((uint8_t)delta);
+    }
+
+    size_t beg = blob.size();
+    blob.resize(beg + perm_stride, 0);
+
+    for (uint32_t j = 0; j < num_rpd; j++)
+        set_perm(&blob[beg], j, recs[j].second);
+
+    blob.shrink_to_fit();
+    num_cold_d++;
+}
+
+// =============================================================================
+// # Decode Cold
+//
+// Decompresses d_cold[d] into num_rpd addresses and perm_stride bytes of
+// packed permanences.
+// =============================================================================
+void BlockMemory::decode_cold(
+    const uint32_t d,
+    uint32_t* addrs,
+    uint8_t* perms)
+{
+
+    const uint8_t* p = d_cold[d].data();
+    uint32_t prev = 0;
+
+    for (uint32_t j = 0; j < num_rpd; j++) {
+        uint32_t delta = 0;
+        uint32_t shift = 0;
+
+        while (*p & 0x80) {
+            delta |= (uint32_t)(*p++ & 0x7f) << shift;
+            shift += 7;
+        }
+
+        delta |= (uint32_t)(*p++) << shift;
+        prev += delta;
+        addrs[j] = prev;
+    }
+
+    memcpy(perms, p, perm_stride);
+}
+
+// =============================================================================
+// # Copy Slot
+//
+// Copies hot dendrite d into slot s of another pair of receptor arrays.
+// =============================================================================
+void BlockMemory::copy_slot(
+    addr_vector& addrs,
+    std::vector<uint8_t>& perms,
+    const size_t s,
+    const uint32_t d)
+{
+
+    if (ilv_flag) {
+        memcpy(&addrs[s * slot_words], &r_addrs[slot(d) * slot_words],
+               slot_words * sizeof(addrs[0]));
+        return;
+    }
+
+    memcpy(slot_addrs(addrs, s), dendrite_addrs(d), num_rpd * sizeof(addrs[0]));
+    memcpy(slot_perms(addrs, perms, s), dendrite_perms(d), perm_stride);
+}
+
+// =============================================================================
+// # Decode Slot
+//
+// Decompresses cold dendrite d into slot s of a pair of receptor arrays.
+// =============================================================================
+void BlockMemory::decode_slot(
+    addr_vector& addrs,
+    std::vector<uint8_t>& perms,
+    const size_t s,
+    const uint32_t d)
+{
+
+    uint8_t* s_perms = slot_perms(addrs, perms, s);
+
+    decode_cold(d, slot_addrs(addrs, s), s_perms);
+
+    if (ilv_flag)
+        addrs[s * slot_words] = count_conns(s_perms);
+}
+
+// =============================================================================
+// # Count Connections
+//
+// Returns the number of connected receptors in a dendrite's permanences.
+// =============================================================================
+uint32_t BlockMemory::count_conns(const uint8_t* perms) {
+
+    uint32_t num_conn = 0;
+
+    for (uint32_t j = 0; j < num_rpd; j++)
+        num_conn += get_perm(perms, j) >= perm_thr;
+
+    return num_conn;
+}
+
+// =============================================================================
+// # Set Tracing
+//
+// Turns recording of a co-activation trace on or off.  While on, every step
+// marked with trace_step() records the dendrites accessed by overlap() and the
+// learning functions, until max_trace accesses have been recorded.  The trace
+// drives relayout() and layout_report().
+// =============================================================================
+void BlockMemory::set_tracing(const bool flag, const uint32_t max_trace) {
+
+    assert(init_flag);
+
+    trace_flag = flag;
+    trace_max = flag ? max_trace : 0;
+    trace_epoch = 1;
+    trace.clear();
+    trace_begs.assign(flag ? 1 : 0, 0);
+    d_stamps.assign(flag ? num_d : 0, 0);
+}
+
+// =============================================================================
+// # Relayout
+//
+// Permutes the physical storage of hot dendrites so dendrites that were
+// accessed in the same traced step sit next to each other.  Dendrite ids do
+// not change: a logical to physical slot table maps each id to its storage.
+// Steps are visited in order and each dendrite is placed the first time it is
+// seen, so recurring co-active groups (the columns of a sequence, co-winning
+// pooler statelets) end up contiguous.  Dendrites never traced keep their
+// relative order after the traced ones.  merge() and decompress_all() restore
+// the default layout.
+//
+// ## Example
+//
+// trace: step 0: {7 2 9}  step 1: {2 4}  step 2: {9 7 5}
+//
+// slots before: {0 1 2 3 4 5 6 7 8 9}  (dendrite d in slot d)
+// order after:  {7 2 9 4 5 0 1 3 6 8}  (dendrites by slot)
+// =============================================================================
+void BlockMemory::relayout() {
+
+    assert(init_flag);
+
+    std::vector<uint8_t> placed(num_d, 0);
+    std::vector<uint32_t> order;
+
+    order.reserve(num_d);
+
+    for (uint32_t i = 0; i < trace.size(); i++) {
+        uint32_t d = trace[i];
+
+        if (!placed[d]) {
+            placed[d] = 1;
+            order.push_back(d);
+        }
+    }
+
+    // Keep the relative order of untraced dendrites
+    std::vector<uint32_t> rest;
+
+    for (uint32_t d = 0; d < num_d; d++)
+        if (!placed[d])
+            rest.push_back(d);
+
+    if (!d_slots.empty()) {
+        std::stable_sort(rest.begin(), rest.end(),
+            [this](uint32_t a, uint32_t b) { return d_slots[a] < d_slots[b]; });
+    }
+
+    order.insert(order.end(), rest.begin(), rest.end());
+
+    apply_layout(order);
+}
+
+// =============================================================================
+// # Layout Report
+//
+// Measures the locality of the current layout over the recorded trace: the
+// mean number of distinct cache lines and pages of r_addrs and r_perms touched
+// per traced step.  Compare reports before and after relayout().  Cold
+// dendrites are not counted.
+// =============================================================================
+LayoutReport BlockMemory::layout_report() {
+
+    assert(init_flag);
+
+    LayoutReport report;
+    std::vector<uint64_t> lines;
+    std::vector<uint64_t> pages;
+    uint64_t lines_sum = 0;
+    uint64_t pages_sum = 0;
+
+    // Bit 63 separates the permanence array from the address array
+    const uint64_t perm_tag = (uint64_t)1 << 63;
+
+    for (uint32_t k = 0; k < trace_begs.size(); k++) {
+        uint32_t beg = trace_begs[k];
+        uint32_t end = k + 1 < trace_begs.size() ?
+            trace_begs[k + 1] : (uint32_t)trace.size();
+
+        if (beg == end)
+            continue;
+
+        lines.clear();
+        pages.clear();
+
+        for (uint32_t i = beg; i < end; i++) {
+            uint32_t d = trace[i];
+
+            if (is_cold(d))
+                continue;
+
+            uint64_t a_beg = (uint64_t)slot(d) * slot_words * sizeof(uint32_t);
+            uint64_t a_end = a_beg + num_rpd * sizeof(r_addrs[0]) - 1;
+            uint64_t p_beg = (uint64_t)slot(d) * perm_stride;
+            uint64_t p_end = p_beg + perm_stride - 1;
+
+            // Interleaved records hold the header, addresses and permanences
+            if (ilv_flag)
+                a_end += sizeof(r_addrs[0]) + perm_stride;
+
+            for (uint64_t l = a_beg >> 6; l <= a_end >> 6; l++)
+                lines.push_back(l);
+
+            for (uint64_t p = a_beg >> 12; p <= a_end >> 12; p++)
+                pages.push_back(p);
+
+            if (ilv_flag)
+                continue;
+
+            for (uint64_t l = p_beg >> 6; l <= p_end >> 6; l++)
+                lines.push_back(l | perm_tag);
+
+            for (uint64_t p = p_beg >> 12; p <= p_end >> 12; p++)
+                pages.push_back(p | perm_tag);
+        }
+
+        std::sort(lines.begin(), lines.end());
+        std::sort(pages.begin(), pages.end());
+        lines_sum += std::unique(lines.begin(), lines.end()) - lines.begin();
+        pages_sum += std::unique(pages.begin(), pages.end()) - pages.begin();
+        report.num_steps++;
+    }
+
+    if (report.num_steps > 0) {
+        report.lines_per_step = (double)lines_sum / report.num_steps;
+        report.pages_per_step = (double)pages_sum / report.num_steps;
+    }
+
+    return report;
+}
+
+// =============================================================================
+// # Apply Layout
+//
+// Moves hot dendrites into slots following order, a permutation of all
+// dendrite ids.  Cold dendrites stay cold.
+// =============================================================================
+void BlockMemory::apply_layout(const std::vector<uint32_t>& order) {
+
+    assert(order.size() == num_d);
+
+    if (d_slots.empty()) {
+        d_slots.resize(num_d);
+        d_cold.resize(num_d);
+
+        for (uint32_t d = 0; d < num_d; d++)
+            d_slots[d] = d;
+    }
+
+    uint32_t num_hot = num_d - num_cold_d;
+    addr_vector new_addrs;
+    std::vector<uint8_t> new_perms;
+    uint32_t s = 0;
+
+    resize_slots(new_addrs, new_perms, num_hot);
+
+    for (uint32_t i = 0; i < num_d; i++) {
+        uint32_t d = order[i];
+        assert(d < num_d);
+
+        if (is_cold(d))
+            continue;
+
+        copy_slot(new_addrs, new_perms, s++, d);
+    }
+
+    assert(s == num_hot);
+
+    // Assign slots after copying since copying reads the old slots
+    s = 0;
+
+    for (uint32_t i = 0; i < num_d; i++)
+        if (!is_cold(order[i]))
+            d_slots[order[i]] = s++;
+
+    r_addrs.swap(new_addrs);
+    r_perms.swap(new_perms);
+}
+
+// =============================================================================
+// # Print Receptor Addresses Dendrite
+//
+// Prints the receptor addresses on a particular dendrite.
+// =============================================================================
+void BlockMemory::print_addrs(const uint32_t d) {
+
+    assert(init_flag);
+    assert(d < num_d);
+
+    const uint32_t* addrs;
+    const uint8_t* perms;
+
+    view(d, addrs, perms);
+
+    std::cout << "{";
+
+    for (uint32_t j = 0; j < num_rpd; j++) {
+        std::cout << addrs[j];
+
+        if (j < num_rpd - 1)
+            std::cout << ", ";
+    }
+
+    std::cout << "}" << std::endl;
+}
+
+// =============================================================================
+// # Print Receptor Permanences Dendrite
+//
+// Prints the receptor permanences on a particular dendrite.
+// =============================================================================
+void BlockMemory::print_perms(const uint32_t d) {
+
+    assert(init_flag);
+    assert(d < num_d);
+
+    const uint32_t* addrs;
+    const uint8_t* perms;
+
+    view(d, addrs, perms);
+
+    std::cout << "{";
+
+    for (uint32_t j = 0; j < num_rpd; j++) {
+        std::cout << (uint32_t)get_perm(perms, j);
+
+        if (j < num_rpd - 1)
+            std::cout << ", ";
+    }
+
+    std::cout << "}" << std::endl;
+}
+
+// =============================================================================
+// # Print Receptor Connections Dendrite
+//
+// Prints the receptor connections on a particular dendrite.
+// =============================================================================
+void BlockMemory::print_conns(const uint32_t d) {
+
+    assert(init_flag);
+    assert(conns_flag);
+    assert(d < num_d);
+
+    d_conns[d].print_bits();
+}
+
+// =============================================================================
+// # Get Dendrite Addresses
+//
+// Returns the receptor addresses of a particular dendrite.
+// =============================================================================
+std::vector<uint32_t> BlockMemory::addrs(const uint32_t d) {
+
+    assert(init_flag);
+    assert(d < num_d);
+
+    const uint32_t* d_addrs;
+    const uint8_t* d_perms;
+
+    view(d, d_addrs, d_perms);
+
+    return std::vector<uint32_t>(d_addrs, d_addrs + num_rpd);
+}
+
+// =============================================================================
+// # Get Dendrite Permanences
+//
+// Returns the receptor permanences of a particular dendrite.  Permanences are
+// returned at the stored precision (see set_perm_bits).
+// =============================================================================
+std::vector<uint8_t> BlockMemory::perms(const uint32_t d) {
+
+    assert(init_flag);
+    assert(d < num_d);
+
+    std::vector<uint8_t> perms(num_rpd);
+    const uint32_t* d_addrs;
+    const uint8_t* d_perms;
+
+    view(d, d_addrs, d_perms);
+
+    // For each receptor on the dendrite
+    for (uint32_t j = 0; j < num_rpd; j++)
+        perms[j] = get_perm(d_perms, j);
+
+    return perms;
+}
+
+// =============================================================================
+// # Get Dendrite Connections
+//
+// Returns the receptor connections of a particular dendrite.
+// =============================================================================
+std::vector<uint8_t> BlockMemory::conns(const uint32_t d) {
+
+    assert(init_flag);
+    assert(d < num_d);
+
+    std::vector<uint8_t> conns(num_i);
 
     // Zero conns vector
     memset(conns.data(), 0, conns.size() * sizeof(conns[0]));
 
-    // Get dendrite's receptor boundaries
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
+    // Get dendrite's receptors
+    const uint32_t* addrs;
+    const uint8_t* perms;
+
+    view(d, addrs, perms);
 
     // For each receptor on the dendrite
-    for (uint32_t r = r_beg; r < r_end; r++) {
-        if (r_perms[r] >= perm_thr)
-            conns[r_addrs[r]] = 1;
+    for (uint32_t j = 0; j < num_rpd; j++) {
+        if (get_perm(perms, j) >= perm_thr)
+            conns[addrs[j]] = 1;
     }
 
     return conns;
 }
 
+// =============================================================================
+// # Get Dendrite Connected Addresses
+//
+// Returns the sorted, unique addresses of a particular dendrite's connected
+// receptors.
+// =============================================================================
+std::vector<uint32_t> BlockMemory::conn_addrs(const uint32_t d) {
+
+    assert(init_flag);
+    assert(d < num_d);
+
+    std::vector<uint32_t> conns;
+
+    // Get dendrite's receptors
+    const uint32_t* addrs;
+    const uint8_t* perms;
+
+    view(d, addrs, perms);
+
+    // For each receptor on the dendrite
+    for (uint32_t j = 0; j < num_rpd; j++) {
+        if (get_perm(perms, j) >= perm_thr)
+            conns.push_back(addrs[j]);
+    }
+
+    std::sort(conns.begin(), conns.end());
+    conns.erase(std::unique(conns.begin(), conns.end()), conns.end());
+
+    return conns;
+}
+
 // =============================================================================
 // # Update Connections Dendrite
 //
@@ -745,13 +1986,54 @@ void BlockMemory::update_conns(const uint32_t d) {
     assert(init_flag);
     assert(d < num_d);
 
+    // Cold dendrites keep no connection BitArray
+    if (is_cold(d)) {
+        d_conns[d].erase();
+        return;
+    }
+
+    if (d_conns[d].num_bits() != num_i)
+        d_conns[d].resize(num_i);
+
     d_conns[d].clear_all();
 
-    uint32_t r_beg = d * num_rpd;
-    uint32_t r_end = r_beg + num_rpd;
+    const uint32_t* addrs;
+    const uint8_t* perms;
 
-    for (uint32_t r = r_beg; r < r_end; r++) {
-        if (r_perms[r] >= perm_thr)
-            d_conns[d].set_bit(r_addrs[r]);
+    view(d, addrs, perms);
+
+    for (uint32_t j = 0; j < num_rpd; j++) {
+        if (get_perm(perms, j) >= perm_thr)
+            d_conns[d].set_bit(addrs[j]);
     }
 }
+
+// =============================================================================
+// # Setup Permanences
+//
+// Rescales the permanence parameters (0 to 99) to the permanence precision and
+// sizes the packed permanence rows.  See set_perm_bits for the mapping.
+// =============================================================================
+void BlockMemory::setup_perms(
+    const uint8_t perm_thr, // permanence threshold (0 to 99)
+    const uint8_t perm_inc, // permanence increment (0 to 99)
+    const uint8_t perm_dec) // permanence decrement (0 to 99)
+{
+
+    uint32_t perms_per_byte = 8 / perm_bits;
+
+    perm_max = (perm_bits == PERM_BITS_8) ? PERM_MAX : (1 << perm_bits) - 1;
+    perm_jmask = perms_per_byte - 1;
+    perm_jshift = (perms_per_byte == 4) ? 2 : (perms_per_byte == 2) ? 1 : 0;
+    perm_stride = (num_rpd + perm_jmask) >> perm_jshift;
+
+    double scale = (double)perm_max / (double)PERM_MAX;
+    double inc = perm_inc * scale;
+    double dec = perm_dec * scale;
+
+    this->perm_thr = (uint8_t)(perm_thr * scale + 0.5);
+    this->perm_inc = (uint8_t)inc;
+    this->perm_dec = (uint8_t)dec;
+    this->inc_frac = (uint32_t)((inc - this->perm_inc) * 4294967295.0);
+    this->dec_frac = (uint32_t)((dec - this->perm_dec) * 4294967295.0);
+}
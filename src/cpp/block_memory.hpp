@@ -5,6 +5,9 @@
 #define BLOCK_MEMORY_HPP
 
 #include "bitarray.hpp"
+#include "bitspan.hpp"
+#include "utils.hpp"
+#include <atomic>
 #include <cstdint>
 #include <vector>
 #include <random>
@@ -12,8 +15,30 @@
 #define PERM_MIN 0
 #define PERM_MAX 99
 
+// Supported receptor permanence precisions (bits per permanence)
+#define PERM_BITS_8 8 // 0 to 99, one permanence per byte
+#define PERM_BITS_4 4 // 0 to 15, two permanences per byte
+#define PERM_BITS_2 2 // 0 to 3, four permanences per byte
+
+// Replica merge modes
+#define MERGE_AVERAGE 0 // mean of replica permanences
+#define MERGE_DELTA 1   // base plus summed replica changes, saturated
+
+// Dendrite slot marking a compressed (cold) dendrite
+#define COLD_SLOT 0xFFFFFFFF
+
+// Alignment of receptor arrays and interleaved dendrite records (bytes)
+#define RECORD_ALIGN 64
+
 namespace BrainBlocks {
 
+// Locality of the receptor arrays over a co-activation trace (see relayout)
+struct LayoutReport {
+    uint32_t num_steps = 0;      // number of traced steps
+    double lines_per_step = 0.0; // mean distinct 64-byte lines touched
+    double pages_per_step = 0.0; // mean distinct 4096-byte pages touched
+};
+
 class BlockMemory {
 
 public:
@@ -59,29 +84,35 @@ public:
         const uint8_t perm_dec,
         std::mt19937& rng);
 
+    // Setup functions (call before initializing)
+    void set_perm_bits(const uint8_t perm_bits);
+    void set_pool_cap(const uint32_t max_rpd, const uint32_t field=0);
+    void set_interleaved(const bool flag);
+
     // Misc. functions
     void save(FILE* fptr);
-    void load(FILE* fptr);
+    bool load(FILE* fptr);
     void clear();
-    uint32_t memory_usage();
+    uint64_t memory_usage();
 
     // Core functions
     uint32_t overlap(
         const uint32_t d,
-        BitArray& input);
+        const BitSpan& input,
+        const bool hit_flag=true);
 
     uint32_t overlap_conn(
         const uint32_t d,
-        BitArray& input);
+        const BitSpan& input);
 
     void learn(
         const uint32_t d,
-        BitArray& input,
+        const BitSpan& input,
         std::mt19937& rng);
 
     void learn_conn(
         const uint32_t d,
-        BitArray& input,
+        const BitSpan& input,
         std::mt19937& rng);
 
     void learn_move(
@@ -96,14 +127,40 @@ public:
 
     void punish(
         const uint32_t d,
-        BitArray& input,
+        const BitSpan& input,
         std::mt19937& rng);
 
     void punish_conn(
         const uint32_t d,
-        BitArray& input,
+        const BitSpan& input,
         std::mt19937& rng);
 
+    void merge(
+        std::vector<BlockMemory*>& replicas,
+        const uint8_t mode=MERGE_AVERAGE);
+
+    // Prefetching (see SequenceLearner::set_prefetch)
+    void prefetch(const uint32_t d);
+    void prefetch_inputs(const uint32_t d, const BitSpan& input);
+
+    // Hot/cold tiers
+    void set_tiering(const bool flag);
+    uint32_t update_tiers(const uint32_t min_hits);
+    void count_hits();
+    void decompress_all();
+
+    // Dendrite layout
+    void set_tracing(const bool flag, const uint32_t max_trace=1048576);
+    void relayout();
+    LayoutReport layout_report();
+
+    inline void trace_step() {
+        if (trace_flag && trace.size() < trace_max) {
+            trace_epoch++;
+            trace_begs.push_back((uint32_t)trace.size());
+        }
+    };
+
     // Printers
     void print_addrs(const uint32_t d);
     void print_perms(const uint32_t d);
@@ -113,14 +170,152 @@ public:
     std::vector<uint32_t> addrs(const uint32_t d);
     std::vector<uint8_t> perms(const uint32_t d);
     std::vector<uint8_t> conns(const uint32_t d);
+    std::vector<uint32_t> conn_addrs(const uint32_t d);
+    uint32_t num_inputs() { return num_i; };
     uint32_t num_dendrites() { return num_d; };
+    uint64_t num_receptors() { return num_r; };
+    uint32_t num_cold() { return num_cold_d; };
+    uint8_t num_perm_bits() { return perm_bits; };
+    uint32_t num_receptors_per_dendrite() { return num_rpd; };
+    uint32_t num_record_bytes() {
+        return slot_words * sizeof(uint32_t) + (ilv_flag ? 0 : perm_stride);
+    };
+    bool is_interleaved() { return ilv_flag; };
+    uint64_t version() { return mem_version; };
 
     // Dendrite activations (0=inactive, 1=active)
     BitArray state;
 
 private:
 
+    typedef std::vector<uint32_t,
+        utils_aligned_allocator<uint32_t, RECORD_ALIGN>> addr_vector;
+
     void update_conns(const uint32_t d);
+    void setup_slots();
+    void copy_slot(
+        addr_vector& addrs,
+        std::vector<uint8_t>& perms,
+        const size_t s,
+        const uint32_t d);
+    void decode_slot(
+        addr_vector& addrs,
+        std::vector<uint8_t>& perms,
+        const size_t s,
+        const uint32_t d);
+    uint32_t count_conns(const uint8_t* perms);
+    void check_sizes();
+    void init_capped(
+        const uint32_t num_f,
+        const uint32_t num_init,
+        std::mt19937& rng);
+    void reset_tiers();
+    void thaw(const uint32_t d);
+    void view(const uint32_t d, const uint32_t*& addrs, const uint8_t*& perms);
+    void encode_cold(const uint32_t d);
+    void decode_cold(const uint32_t d, uint32_t* addrs, uint8_t* perms);
+    void apply_layout(const std::vector<uint32_t>& order);
+    void setup_perms(
+        const uint8_t perm_thr,
+        const uint8_t perm_inc,
+        const uint8_t perm_dec);
+
+    // Hot dendrite storage slot (offsets are 64-bit, num_r may exceed 2^32)
+    inline size_t slot(const uint32_t d) {
+        return d_slots.empty() ? d : d_slots[d];
+    };
+
+    // Receptors of slot s in a pair of receptor arrays (see set_interleaved)
+    inline uint32_t* slot_addrs(addr_vector& addrs, const size_t s) {
+        return &addrs[s * slot_words + (ilv_flag ? 1 : 0)];
+    };
+
+    inline uint8_t* slot_perms(
+        addr_vector& addrs,
+        std::vector<uint8_t>& perms,
+        const size_t s) {
+        if (ilv_flag)
+            return (uint8_t*)&addrs[s * slot_words + 1 + num_rpd];
+        return &perms[s * perm_stride];
+    };
+
+    inline void resize_slots(
+        addr_vector& addrs,
+        std::vector<uint8_t>& perms,
+        const size_t n) {
+        addrs.resize(n * slot_words);
+        perms.resize(ilv_flag ? 0 : n * perm_stride);
+    };
+
+    // Receptors of a hot dendrite
+    inline uint32_t* dendrite_addrs(const uint32_t d) {
+        return slot_addrs(r_addrs, slot(d));
+    };
+
+    inline uint8_t* dendrite_perms(const uint32_t d) {
+        return slot_perms(r_addrs, r_perms, slot(d));
+    };
+
+    // Updates a hot dendrite's connected count (interleaved records only)
+    inline void add_conns(const uint32_t d, const int32_t n) {
+        if (ilv_flag)
+            r_addrs[slot(d) * slot_words] += n;
+    };
+
+    inline void recount(const uint32_t d) {
+        if (ilv_flag)
+            r_addrs[slot(d) * slot_words] = count_conns(dendrite_perms(d));
+    };
+
+    // Tier helpers (see update_tiers)
+    inline bool is_cold(const uint32_t d) {
+        return !d_slots.empty() && d_slots[d] == COLD_SLOT;
+    };
+
+    inline void hit(const uint32_t d) {
+        if (tier_flag && d_hits[d] < UINT32_MAX)
+            d_hits[d]++;
+
+        if (trace_flag && d_stamps[d] != trace_epoch &&
+            trace.size() < trace_max) {
+            d_stamps[d] = trace_epoch;
+            trace.push_back(d);
+        }
+    };
+
+    // Packed permanence access (j is the receptor index on the dendrite)
+    inline uint8_t get_perm(const uint8_t* perms, const uint32_t j) {
+        if (perm_bits == PERM_BITS_8)
+            return perms[j];
+        uint32_t shift = (j & perm_jmask) * perm_bits;
+        return (perms[j >> perm_jshift] >> shift) & perm_max;
+    };
+
+    inline void set_perm(uint8_t* perms, const uint32_t j, const uint8_t p) {
+        if (perm_bits == PERM_BITS_8) {
+            perms[j] = p;
+            return;
+        }
+        uint32_t shift = (j & perm_jmask) * perm_bits;
+        uint8_t& byte = perms[j >> perm_jshift];
+        byte &= (uint8_t)~(perm_max << shift);
+        byte |= (uint8_t)((p & perm_max) << shift);
+    };
+
+    // Stochastically rounded permanence steps (see setup_perms)
+    inline uint8_t step_inc(std::mt19937& rng) {
+        return perm_inc + ((inc_frac > 0 && rng() < inc_frac) ? 1 : 0);
+    };
+
+    inline uint8_t step_dec(std::mt19937& rng) {
+        return perm_dec + ((dec_frac > 0 && rng() < dec_frac) ? 1 : 0);
+    };
+
+    // Marks the memories as changed (see version)
+    inline void touch() { mem_version = ++next_version; };
+
+    static std::atomic<uint64_t> next_version;
+    uint64_t mem_version = 0; // changes whenever addresses or perms change
 
     // Flags
     bool init_flag = false;
@@ -130,17 +325,50 @@ private:
     uint32_t num_i;   // number of inputs
     uint32_t num_d;   // number of dendrites
     uint32_t num_rpd; // number of receptors per dendrite
-    uint32_t num_r;   // number of receptors
+    uint64_t num_r;   // number of receptors
     uint8_t perm_thr; // receptor permanence threshold
     uint8_t perm_inc; // receptor permanence increment
     uint8_t perm_dec; // receptor permanence decrement
     double pct_learn; // learning percentage
 
+    // Capped pools (see set_pool_cap)
+    uint32_t pool_cap = 0;   // maximum receptors per dendrite (0 is uncapped)
+    uint32_t pool_field = 0; // input bits per dendrite field (0 is all)
+
+    // Hot/cold tiers (see update_tiers)
+    bool tier_flag = false;
+    uint32_t num_cold_d = 0;                 // number of cold dendrites
+    std::vector<uint32_t> d_slots;           // hot slot or COLD_SLOT
+    std::vector<uint32_t> d_hits;            // accesses since last update
+    std::vector<std::vector<uint8_t>> d_cold; // compressed cold dendrites
+
+    // Interleaved records (see set_interleaved)
+    bool ilv_flag = false;
+    uint32_t slot_words = 0; // r_addrs words per hot dendrite slot
+
+    // Co-activation trace (see relayout)
+    bool trace_flag = false;
+    uint32_t trace_max = 0;           // maximum traced accesses
+    uint32_t trace_epoch = 0;         // current traced step
+    std::vector<uint32_t> d_stamps;   // last traced step of each dendrite
+    std::vector<uint32_t> trace;      // accessed dendrites grouped by step
+    std::vector<uint32_t> trace_begs; // start of each step in trace
+
+    // Permanence precision
+    uint8_t perm_bits = PERM_BITS_8; // bits per permanence
+    uint8_t perm_max = PERM_MAX;     // maximum permanence value
+    uint32_t perm_jshift = 0;        // receptor index to byte index shift
+    uint32_t perm_jmask = 0;         // receptor index to byte position mask
+    uint32_t perm_stride = 0;        // bytes of permanences per dendrite
+    uint32_t inc_frac = 0;           // fractional increment (x 2^32)
+    uint32_t dec_frac = 0;           // fractional decrement (x 2^32)
+
     // Arrays
-    std::vector<uint32_t> r_addrs; // receptor addresses
-    std::vector<uint8_t>  r_perms; // receptor permancences
+    addr_vector r_addrs;           // receptor addresses (or records)
+    std::vector<uint8_t>  r_perms; // receptor permancences (packed)
     std::vector<BitArray> d_conns; // dendrite connections (optional)
     BitArray lmask;                // learning mask
+    BitArray available;            // learn_move scratch (unused input bits)
 };
 
 } // namespace BrainBlocks
@@ -6,7 +6,7 @@
 
 using namespace BrainBlocks;
 
-uint32_t BlockOutput::next_id = 0;
+std::atomic<uint32_t> BlockOutput::next_id(0);
 
 // =============================================================================
 // Constructor
@@ -147,9 +147,9 @@ void BlockOutput::store() {
 //
 // Returns an estimate of the number of bytes used by the BlockOutput.
 // =============================================================================
-uint32_t BlockOutput::memory_usage() {
+uint64_t BlockOutput::memory_usage() {
 
-    uint32_t bytes = 0;
+    uint64_t bytes = 0;
     uint32_t num_t = (uint32_t)history.size();
 
     bytes += state.memory_usage();
@@ -6,6 +6,7 @@
 
 #include "bitarray.hpp"
 #include <vector>
+#include <atomic>
 #include <cstdint>
 
 #define CURR 0
@@ -23,7 +24,7 @@ public:
     void clear();
     void step();
     void store();
-    uint32_t memory_usage();
+    uint64_t memory_usage();
 
     // Getters
     bool has_changed() { return changed_flag; };
@@ -40,7 +41,7 @@ private:
     // Get history index based on time step
     int idx(const int ts);
 
-    static uint32_t next_id;
+    static std::atomic<uint32_t> next_id;
     uint32_t id = 0xffffffff;
     uint32_t curr_idx = 0xffffffff;
     bool changed_flag = false;
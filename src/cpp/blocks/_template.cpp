@@ -181,9 +181,9 @@ void Template::store() {
 //
 // Returns an estimate of the number of bytes used by the block.
 // =============================================================================
-uint32_t Template::memory_usage() {
+uint64_t Template::memory_usage() {
 
-    uint32_t bytes = 0;
+    uint64_t bytes = 0;
 
     //bytes += input.memory_usage();
     //bytes += output.memory_usage();
@@ -37,7 +37,7 @@ public:
     void decode() override;
     void learn() override;
     void store() override;
-    uint32_t memory_usage() override;
+    uint64_t memory_usage() override;
 
     // Public functions
     // void public_function();
@@ -67,9 +67,9 @@ void BlankBlock::store() {
 //
 // Returns an estimate of the number of bytes used by the block.
 // =============================================================================
-uint32_t BlankBlock::memory_usage() {
+uint64_t BlankBlock::memory_usage() {
 
-    uint32_t bytes = 0;
+    uint64_t bytes = 0;
 
     bytes += output.memory_usage();
 
@@ -22,7 +22,7 @@ public:
     void clear() override;
     void step() override;
     void store() override;
-    uint32_t memory_usage() override;
+    uint64_t memory_usage() override;
 
     // Block IO and Memory
     BlockOutput output;
@@ -3,6 +3,7 @@
 // =============================================================================
 #include "context_learner.hpp"
 #include "../utils.hpp"
+#include <stdexcept> // for length_error
 
 using namespace BrainBlocks;
 
@@ -15,7 +16,8 @@ using namespace BrainBlocks;
 // =============================================================================
 // # Constructor
 //
-// Constructs a ContextLearner.
+// Constructs a ContextLearner.  Throws std::length_error if the number of
+// dendrites, num_c * num_spc * num_dps, does not fit in 32 bits.
 // =============================================================================
 ContextLearner::ContextLearner(
     const uint32_t num_c,    // number of column
@@ -36,6 +38,12 @@ ContextLearner::ContextLearner(
     assert(num_rpd > 0);
     assert(d_thresh < num_rpd);
 
+    // Dendrite indices are 32-bit (receptor offsets are 64-bit)
+    if ((uint64_t)num_c * num_spc > UINT32_MAX ||
+        (uint64_t)num_c * num_spc * num_dps > UINT32_MAX)
+        throw std::length_error(
+            "ContextLearner: num_c * num_spc * num_dps exceeds 2^32 - 1");
+
     this->num_c = num_c;
     this->num_spc = num_spc;
     this->num_dps = num_dps;
@@ -123,7 +131,11 @@ bool ContextLearner::load(const char* file) {
         init();
 
     // Load items
-    memory.load(fptr);
+    if (!memory.load(fptr)) {
+        std::fclose(fptr);
+        return false;
+    }
+
     d_used.load(fptr);
     std::fread(next_sd.data(), sizeof(next_sd[0]), next_sd.size(), fptr);
 
@@ -185,7 +197,7 @@ void ContextLearner::encode() {
         // Clear data
         pct_anom = 0.0;
 	output.state.clear_all();
-        memory.state.clear_all();
+        memory.state.clear_tracked();
 
         // For every active column
         for (uint32_t k = 0; k < input_acts.size(); k++) {
@@ -263,7 +275,7 @@ void ContextLearner::recognition(const uint32_t c) {
             // If dendrite overlap is above the threshold
             if (overlap >= d_thresh) {
                 uint32_t s = d / num_dps;
-                memory.state.set_bit(d); // activate the dendrite
+                memory.state.set_bit_tracked(d); // activate the dendrite
                 output.state.set_bit(s); // activate the dendrite's statelet
                 surprise_flag = false;
             }
@@ -305,7 +317,7 @@ void ContextLearner::set_next_available_dendrite(const uint32_t s) {
     uint32_t d_next = d_beg + next_sd[s];
 
     // Activate random statelet's next available dendrite
-    memory.state.set_bit(d_next);
+    memory.state.set_bit_tracked(d_next);
 
     // Update random statelet's next available dendrite
     if(next_sd[s] < num_dps - 1)
@@ -77,6 +77,43 @@ void DiscreteTransformer::encode() {
     value_prev = value;
 }
 
+// =============================================================================
+// # Encode Batch
+//
+// Encodes a batch of values into outputs, one BitArray per value, exactly as
+// set_value() followed by feedforward() would.  The BlockOutput history and
+// the current value are left untouched.
+//
+// ## Example
+//
+// num_v: 4, num_s: 8 (num_as: 2)
+//
+// values: {0, 3}
+//
+// outputs[0]: {11000000}
+// outputs[1]: {00000011}
+// =============================================================================
+void DiscreteTransformer::encode_batch(
+        const std::vector<uint32_t>& values,
+        std::vector<BitArray>& outputs) {
+
+    outputs.resize(values.size());
+
+    for (uint32_t t = 0; t < values.size(); t++) {
+
+        assert(values[t] < num_v);
+
+        double percent = (double)values[t] / (double)(num_v - 1);
+        uint32_t beg = (uint32_t)((double)dif_s * percent);
+
+        if (outputs[t].num_bits() != num_s)
+            outputs[t].resize(num_s);
+
+        outputs[t].clear_all();
+        outputs[t].set_range(beg, num_as);
+    }
+}
+
 // =============================================================================
 // # Decode
 //
@@ -7,6 +7,8 @@
 #include "../block.hpp"
 #include "../block_output.hpp"
 
+#include <vector>
+
 namespace BrainBlocks {
 
 class DiscreteTransformer final : public Block {
@@ -26,6 +28,11 @@ public:
     void decode() override;
     void store() override;
 
+    // Encodes many values at once without touching the BlockOutput
+    void encode_batch(
+        const std::vector<uint32_t>& values,
+        std::vector<BitArray>& outputs);
+
     // Getters and setters
     void set_value(const uint32_t val) { value = val; };
     uint32_t get_value() { return value; };
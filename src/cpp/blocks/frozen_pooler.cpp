@@ -0,0 +1,351 @@
+// =============================================================================
+// frozen_pooler.cpp
+// =============================================================================
+#include "frozen_pooler.hpp"
+#include "../utils.hpp"
+#include <cstring> // for memset
+
+#define FROZEN_POOLER_MAGIC 0x50464242 // "BBFP"
+#define FROZEN_POOLER_VERSION 1
+
+using namespace BrainBlocks;
+
+// =============================================================================
+// # FrozenPooler
+//
+// Inference-only form of a trained PatternPooler, PatternClassifier or
+// PatternClassifierDynamic.  It holds a FrozenMemory instead of a BlockMemory
+// and can only encode.  Classifier label assignments can be attached so the
+// frozen block also returns label probabilities.
+//
+// ## Example
+//
+// PatternClassifier pc(...);         // train as usual
+// ...
+// FrozenPooler fp(num_s, num_as);
+// pc.freeze(fp);                     // export the trained classifier
+// fp.save("model.bin");              // deploy
+// ...
+// FrozenPooler fp(num_s, num_as);    // on the edge device
+// fp.input.add_child(&st.output, 0);
+// fp.load("model.bin");
+// fp.feedforward();
+// probs = fp.get_probabilities();
+// =============================================================================
+
+// =============================================================================
+// # Constructor
+//
+// Constructs a FrozenPooler.
+// =============================================================================
+FrozenPooler::FrozenPooler(
+    const uint32_t num_s,  // number of statelets
+    const uint32_t num_as, // number of active statelets
+    const uint32_t num_t)  // number of BlockOutput time steps (optional)
+: Block() {
+
+    assert(num_s > 0);
+    assert(num_as > 0);
+
+    this->num_s = num_s;
+    this->num_as = num_as;
+
+    overlaps.resize(num_s);
+    templaps.resize(num_s);
+    s_labels.resize(num_s);
+
+    // Setup output
+    output.setup(num_t, num_s);
+}
+
+// =============================================================================
+// # Initialize
+//
+// Checks the frozen memory matches the BlockInput.  A FrozenPooler must be
+// frozen from a trained block or loaded from a file before it is initialized.
+// =============================================================================
+void FrozenPooler::init() {
+
+    assert(memory.num_dendrites() == num_s);
+    assert(memory.num_inputs() == input.state.num_bits());
+
+    init_flag = true;
+}
+
+// =============================================================================
+// # Save
+//
+// Saves frozen memories and label assignments after a magic number, version
+// and the number of statelets.
+// =============================================================================
+bool FrozenPooler::save(const char* file) {
+
+    FILE* fptr;
+    uint32_t header[3] = {FROZEN_POOLER_MAGIC, FROZEN_POOLER_VERSION, num_s};
+
+    // Check if block has been frozen
+    if (memory.num_dendrites() != num_s)
+        return false;
+
+    // Check if file can be opened
+    if ((fptr = std::fopen(file, "wb")) == NULL)
+        return false;
+
+    // Save header
+    std::fwrite(header, sizeof(header[0]), 3, fptr);
+
+    // Save labels
+    uint32_t num_l = (uint32_t)labels.size();
+    std::fwrite(&num_l, sizeof(num_l), 1, fptr);
+    std::fwrite(labels.data(), sizeof(labels[0]), num_l, fptr);
+
+    for (uint32_t s = 0; s < num_s; s++) {
+        uint32_t num_sl = (uint32_t)s_labels[s].size();
+        std::fwrite(&num_sl, sizeof(num_sl), 1, fptr);
+        std::fwrite(s_labels[s].data(), sizeof(uint32_t), num_sl, fptr);
+    }
+
+    // Save items
+    memory.save(fptr);
+
+    // Close file pointer
+    std::fclose(fptr);
+
+    return true;
+}
+
+// =============================================================================
+// # Load
+//
+// Loads frozen memories and label assignments.  Returns false and leaves the
+// block unchanged if the magic number or version is unknown, the file ends
+// early, a count needs more bytes than the file holds, a label index is out of
+// range, or the frozen memories do not match the block.
+// =============================================================================
+bool FrozenPooler::load(const char* file) {
+
+    FILE* fptr;
+
+    // Check if file can be opened
+    if ((fptr = std::fopen(file, "rb")) == NULL)
+        return false;
+
+    uint32_t header[3] = {0, 0, 0};
+    uint32_t num_l = 0;
+    std::vector<uint32_t> f_labels;
+    std::vector<std::vector<uint32_t>> f_s_labels(num_s);
+    FrozenMemory f_memory;
+
+    bool ok =
+        std::fread(header, sizeof(header[0]), 3, fptr) == 3 &&
+        header[0] == FROZEN_POOLER_MAGIC &&
+        header[1] == FROZEN_POOLER_VERSION &&
+        header[2] == num_s &&
+        std::fread(&num_l, sizeof(num_l), 1, fptr) == 1 &&
+        (uint64_t)num_l * sizeof(uint32_t) <= utils_bytes_left(fptr);
+
+    // Load labels
+    if (ok) {
+        f_labels.resize(num_l);
+        ok = std::fread(f_labels.data(), sizeof(f_labels[0]), num_l, fptr) ==
+             num_l;
+    }
+
+    // Each statelet lists distinct label indices
+    for (uint32_t s = 0; ok && s < num_s; s++) {
+        uint32_t num_sl = 0;
+
+        ok = std::fread(&num_sl, sizeof(num_sl), 1, fptr) == 1 &&
+             num_sl <= num_l;
+
+        if (ok) {
+            f_s_labels[s].resize(num_sl);
+            ok = std::fread(f_s_labels[s].data(), sizeof(uint32_t), num_sl,
+                            fptr) == num_sl;
+        }
+
+        for (uint32_t i = 0; ok && i < num_sl; i++)
+            ok = f_s_labels[s][i] < num_l;
+    }
+
+    // Load items
+    ok = ok && f_memory.load(fptr);
+
+    // Close file pointer
+    std::fclose(fptr);
+
+    // Check if frozen memories match the block
+    if (!ok ||
+        f_memory.num_dendrites() != num_s ||
+        f_memory.num_inputs() != input.state.num_bits())
+        return false;
+
+    labels.swap(f_labels);
+    s_labels.swap(f_s_labels);
+    memory = f_memory;
+
+    init();
+
+    return true;
+}
+
+// =============================================================================
+// # Clear
+//
+// Clears BlockInput and BlockOutput states.
+// =============================================================================
+void FrozenPooler::clear() {
+
+    input.clear();
+    output.clear();
+}
+
+// =============================================================================
+// # Step
+//
+// Updates BlockOutput history current index.
+// =============================================================================
+void FrozenPooler::step() {
+
+    output.step();
+}
+
+// =============================================================================
+// # Pull
+//
+// Updates BlockInput state(s) from child BlockOutput histories.
+// =============================================================================
+void FrozenPooler::pull() {
+
+    input.pull();
+}
+
+// =============================================================================
+// # Encode
+//
+// Converts BlockInput state(s) into BlockOutput state(s).
+// =============================================================================
+void FrozenPooler::encode() {
+
+    assert(init_flag);
+
+    // Clear data
+    output.state.clear_all();
+
+    // Overlap each statelet
+    for (uint32_t s = 0; s < num_s; s++) {
+        overlaps[s] = memory.overlap(s, input.state);
+        templaps[s] = overlaps[s];
+    }
+
+    // Activate statelets with k-highest overlap
+    for (uint32_t k = 0; k < num_as; k++) {
+        uint32_t max_val = 0;
+        uint32_t max_idx = 0;
+
+        // Find statelet with highest overlap
+        for (uint32_t s = 0; s < num_s; s++) {
+            if (templaps[s] > max_val) {
+                max_val = templaps[s];
+                max_idx = s;
+            }
+        }
+
+        // Activate statelet with highest overlap
+        output.state.set_bit(max_idx);
+        templaps[max_idx] = 0;
+    }
+}
+
+// =============================================================================
+// # Store
+//
+// Copy BlockOutput state into current index of BlockOutput history.
+// =============================================================================
+void FrozenPooler::store() {
+
+    output.store();
+}
+
+// =============================================================================
+// # Memory Usage
+//
+// Returns an estimate of the number of bytes used by the block.
+// =============================================================================
+uint64_t FrozenPooler::memory_usage() {
+
+    uint64_t bytes = 0;
+
+    bytes += Block::memory_usage();
+    bytes += input.memory_usage();
+    bytes += output.memory_usage();
+    bytes += memory.memory_usage();
+    bytes += (uint64_t)(labels.size() * sizeof(labels[0]));
+
+    for (uint32_t s = 0; s < num_s; s++)
+        bytes += (uint64_t)(s_labels[s].size() * sizeof(uint32_t));
+
+    return bytes;
+}
+
+// =============================================================================
+// # Freeze
+//
+// Converts a trained BlockMemory into the block's FrozenMemory.
+// =============================================================================
+void FrozenPooler::freeze(BlockMemory& memory) {
+
+    assert(memory.num_dendrites() == num_s);
+
+    this->memory.init(memory);
+
+    labels.clear();
+
+    for (uint32_t s = 0; s < num_s; s++)
+        s_labels[s].clear();
+}
+
+// =============================================================================
+// # Add Label
+//
+// Assigns a label to a collection of statelets.
+// =============================================================================
+void FrozenPooler::add_label(
+    const uint32_t label,               // label value
+    const std::vector<uint32_t>& acts)  // statelets assigned to the label
+{
+
+    uint32_t idx = (uint32_t)labels.size();
+
+    labels.push_back(label);
+
+    for (uint32_t k = 0; k < acts.size(); k++) {
+        assert(acts[k] < num_s);
+        s_labels[acts[k]].push_back(idx);
+    }
+}
+
+// =============================================================================
+// # Get Probabilities
+//
+// Returns array of probability scores for each stored label.
+// =============================================================================
+std::vector<double> FrozenPooler::get_probabilities() {
+
+    double prob_inc = 1.0 / (double)num_as;
+    std::vector<uint32_t> output_acts = output.state.get_acts();
+    std::vector<double> probs(labels.size());
+
+    // Zero probabilities
+    memset(probs.data(), 0, probs.size() * sizeof(probs[0]));
+
+    // Increment probabilities based on output activations
+    for (uint32_t k = 0; k < output_acts.size(); k++) {
+        std::vector<uint32_t>& lbls = s_labels[output_acts[k]];
+
+        for (uint32_t i = 0; i < lbls.size(); i++)
+            probs[lbls[i]] += prob_inc;
+    }
+
+    return probs;
+}
@@ -0,0 +1,64 @@
+// =============================================================================
+// frozen_pooler.hpp
+// =============================================================================
+#ifndef FROZEN_POOLER_HPP
+#define FROZEN_POOLER_HPP
+
+#include "../block.hpp"
+#include "../block_input.hpp"
+#include "../block_memory.hpp"
+#include "../block_output.hpp"
+#include "../frozen_memory.hpp"
+
+#include <vector>
+
+namespace BrainBlocks {
+
+class FrozenPooler final : public Block {
+
+public:
+
+    // Constructor
+    FrozenPooler(
+        const uint32_t num_s,
+        const uint32_t num_as,
+        const uint32_t num_t=2);
+
+    // Overrided functions
+    void init() override;
+    bool save(const char* file) override;
+    bool load(const char* file) override;
+    void clear() override;
+    void step() override;
+    void pull() override;
+    void encode() override;
+    void store() override;
+    uint64_t memory_usage() override;
+
+    // Export functions
+    void freeze(BlockMemory& memory);
+    void add_label(const uint32_t label, const std::vector<uint32_t>& acts);
+
+    // Getters
+    std::vector<uint32_t> get_labels() { return labels; };
+    std::vector<double> get_probabilities();
+
+    // Block IO and memory variables
+    BlockInput input;
+    BlockOutput output;
+    FrozenMemory memory;
+
+private:
+
+    uint32_t num_s;  // number of statelets
+    uint32_t num_as; // number of active statelets
+
+    std::vector<uint32_t> overlaps; // overlaps
+    std::vector<uint32_t> templaps; // temporary overlaps
+    std::vector<uint32_t> labels;   // stored labels (optional)
+    std::vector<std::vector<uint32_t>> s_labels; // statelet label indices
+};
+
+} // namespace BrainBlocks
+
+#endif // FROZEN_POOLER_HPP
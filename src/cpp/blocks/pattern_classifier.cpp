@@ -2,8 +2,10 @@
 // pattern_classifier.cpp
 // =============================================================================
 #include "pattern_classifier.hpp"
+#include "../parallel_fit.hpp"
 #include "../utils.hpp"
-#include <cstring> // for memset
+#include "blank_block.hpp"
+#include <memory>
 #include <iostream>
 
 using namespace BrainBlocks;
@@ -52,6 +54,7 @@ PatternClassifier::PatternClassifier(
     overlaps.resize(num_s);
     templaps.resize(num_s);
     s_labels.resize(num_s);
+    votes.resize(num_l);
 
     // Setup statelet labels
     for (uint32_t s = 0; s < num_s; s++) {
@@ -128,7 +131,10 @@ bool PatternClassifier::load(const char* file) {
         init();
 
     // Load items
-    memory.load(fptr);
+    if (!memory.load(fptr)) {
+        std::fclose(fptr);
+        return false;
+    }
 
     // Close file pointer
     std::fclose(fptr);
@@ -177,6 +183,16 @@ void PatternClassifier::encode() {
 
     assert(init_flag);
 
+    uint64_t fp = 0;
+
+    // Reuse the output of a previously encoded identical input
+    if (cache.capacity() > 0) {
+        fp = input.state.fingerprint();
+
+        if (cache.fetch(fp, input.state, memory.version(), output.state))
+            return;
+    }
+
     // Clear data
     output.state.clear_all();
 
@@ -212,6 +228,9 @@ void PatternClassifier::encode() {
         output.state.set_bit(max_idx);
         templaps[max_idx] = 0;
     }
+
+    if (cache.capacity() > 0)
+        cache.insert(fp, input.state, memory.version(), output.state);
 }
 
 // =============================================================================
@@ -283,15 +302,125 @@ std::vector<uint32_t> PatternClassifier::get_labels() {
 std::vector<double> PatternClassifier::get_probabilities() {
 
     double prob_inc = 1.0 / (double)num_as;
-    std::vector<uint32_t> output_acts = output.state.get_acts();
     std::vector<double> probs(num_l);
 
-    // Zero probabilities
-    memset(probs.data(), 0, probs.size() * sizeof(probs[0]));
+    get_votes(votes.data());
 
-    // Increment probabilities based on output activations
-    for (uint32_t i = 0; i < output_acts.size(); i++)
-        probs[s_labels[output_acts[i]]] += prob_inc;
+    for (uint32_t l = 0; l < num_l; l++)
+        probs[l] = (double)votes[l] * prob_inc;
 
     return probs;
 }
+
+// =============================================================================
+// # Get Votes
+//
+// Writes the number of active output statelets of each label into votes, which
+// must hold num_l values, and returns the label with the most votes.  Labels
+// own contiguous ranges of num_spl statelets, so each count is a ranged
+// popcount of the output state and no active list is built.  Statelets left
+// over after the last label's range belong to label 0.
+//
+// ## Example
+//
+// num_l: 2, num_spl: 4
+// output.state: {0110 1011}
+//
+// label = pc.get_votes(votes)
+// votes: {2, 3}
+// label: 1
+// =============================================================================
+uint32_t PatternClassifier::get_votes(uint32_t* votes) {
+
+    uint32_t max_label = 0;
+    uint32_t max_votes = 0;
+    uint32_t num_ls = num_l * num_spl;
+
+    for (uint32_t l = 0; l < num_l; l++)
+        votes[l] = output.state.num_set(l * num_spl, num_spl);
+
+    if (num_ls < num_s)
+        votes[0] += output.state.num_set(num_ls, num_s - num_ls);
+
+    for (uint32_t l = 0; l < num_l; l++) {
+        if (votes[l] > max_votes) {
+            max_votes = votes[l];
+            max_label = l;
+        }
+    }
+
+    return max_label;
+}
+
+// =============================================================================
+// # Fit Parallel
+//
+// Trains on pre-encoded inputs and their labels using num_threads replicas of
+// this block, each fed by its own BlankBlock.  Replicas start from this
+// block's memory and are merged back every merge_every samples (see
+// parallel_fit).  Every input must have as many bits as this block's input.
+// =============================================================================
+void PatternClassifier::fit_parallel(
+        std::vector<BitArray>& inputs,
+        std::vector<uint32_t>& labels,
+        const uint32_t num_threads,
+        const uint32_t num_epochs,
+        const uint32_t merge_every,
+        const uint8_t merge_mode) {
+
+    assert(init_flag);
+    assert(num_threads > 0);
+    assert(labels.size() == inputs.size());
+
+    uint32_t num_i = input.state.num_bits();
+    std::vector<std::unique_ptr<BlankBlock>> feeds;
+    std::vector<std::unique_ptr<PatternClassifier>> reps;
+    std::vector<BlockMemory*> mems;
+
+    for (uint32_t i = 0; i < inputs.size(); i++) {
+        assert(inputs[i].num_bits() == num_i);
+        assert(labels[i] < num_l);
+    }
+
+    // Setup replicas
+    for (uint32_t r = 0; r < num_threads; r++) {
+        feeds.emplace_back(new BlankBlock(num_i));
+        reps.emplace_back(new PatternClassifier(
+            num_l, num_s, num_as, perm_thr, perm_inc, perm_dec, pct_pool,
+            pct_conn, pct_learn, 2, rng()));
+        reps[r]->input.add_child(&feeds[r]->output, 0);
+        reps[r]->init();
+        mems.push_back(&reps[r]->memory);
+    }
+
+    // Train replicas
+    parallel_fit(
+        memory, mems, (uint32_t)inputs.size(), num_epochs, merge_every,
+        merge_mode, [&](const uint32_t r, const uint32_t i) {
+            feeds[r]->output.state = inputs[i];
+            feeds[r]->feedforward();
+            reps[r]->set_label(labels[i]);
+            reps[r]->feedforward(true);
+        });
+}
+
+// =============================================================================
+// # Freeze
+//
+// Exports the trained block and its statelet labels into an inference-only
+// FrozenPooler.
+// =============================================================================
+void PatternClassifier::freeze(FrozenPooler& frozen) {
+
+    assert(init_flag);
+
+    frozen.freeze(memory);
+
+    std::vector<std::vector<uint32_t>> l_acts(num_l);
+
+    for (uint32_t s = 0; s < num_s; s++)
+        l_acts[s_labels[s]].push_back(s);
+
+    for (uint32_t l = 0; l < num_l; l++)
+        frozen.add_label(l, l_acts[l]);
+}
@@ -8,6 +8,8 @@
 #include "../block_input.hpp"
 #include "../block_memory.hpp"
 #include "../block_output.hpp"
+#include "../encode_cache.hpp"
+#include "frozen_pooler.hpp"
 
 #include <vector>
 
@@ -45,18 +47,35 @@ public:
     void store() override;
     // TODO: void bytes_used() override;
 
+    // Training functions
+    void fit_parallel(
+        std::vector<BitArray>& inputs,
+        std::vector<uint32_t>& labels,
+        const uint32_t num_threads,
+        const uint32_t num_epochs=1,
+        const uint32_t merge_every=1024,
+        const uint8_t merge_mode=MERGE_AVERAGE);
+
+    // Export functions
+    void freeze(FrozenPooler& frozen);
+
     // Setters
     void set_label(const uint32_t label) { this->label = label; };
 
     // Getters
     std::vector<uint32_t> get_labels();
     std::vector<double> get_probabilities();
+    uint32_t get_votes(uint32_t* votes);
+    uint32_t num_labels() { return num_l; };
 
     // Block IO and memory variables
     BlockInput input;
     BlockOutput output;
     BlockMemory memory;
 
+    // Optional cache of encoded outputs (see EncodeCache, disabled by default)
+    EncodeCache cache;
+
 private:
 
     uint32_t label;   // input label
@@ -74,6 +93,7 @@ private:
     std::vector<uint32_t> overlaps; // overlaps
     std::vector<uint32_t> templaps; // temporary overlaps
     std::vector<uint32_t> s_labels; // statelet labels
+    std::vector<uint32_t> votes;    // label votes
 };
 
 } // namespace BrainBlocks
@@ -2,7 +2,10 @@
 // pattern_classifier_dynamic.cpp
 // =============================================================================
 #include "pattern_classifier_dynamic.hpp"
+#include "../parallel_fit.hpp"
 #include "../utils.hpp"
+#include "blank_block.hpp"
+#include <memory>
 
 using namespace BrainBlocks;
 
@@ -47,6 +50,7 @@ PatternClassifierDynamic::PatternClassifierDynamic(
 
     overlaps.resize(num_s);
     templaps.resize(num_s);
+    s_labels.resize(num_s);
 
     // Setup output
     output.setup(num_t, num_s);
@@ -112,7 +116,10 @@ bool PatternClassifierDynamic::load(const char* file) {
         init();
 
     // Load items
-    memory.load(fptr);
+    if (!memory.load(fptr)) {
+        std::fclose(fptr);
+        return false;
+    }
 
     // Close file pointer
     std::fclose(fptr);
@@ -161,6 +168,16 @@ void PatternClassifierDynamic::encode() {
 
     assert(init_flag);
 
+    uint64_t fp = 0;
+
+    // Reuse the output of a previously encoded identical input
+    if (cache.capacity() > 0) {
+        fp = input.state.fingerprint();
+
+        if (cache.fetch(fp, input.state, memory.version(), output.state))
+            return;
+    }
+
     // Clear data
     output.state.clear_all();
 
@@ -196,6 +213,9 @@ void PatternClassifierDynamic::encode() {
         output.state.set_bit(max_idx);
         templaps[max_idx] = 0;
     }
+
+    if (cache.capacity() > 0)
+        cache.insert(fp, input.state, memory.version(), output.state);
 }
 
 // =============================================================================
@@ -207,25 +227,18 @@ void PatternClassifierDynamic::learn() {
 
     assert(init_flag);
 
-    uint32_t idx = 0xFFFFFFFF;
+    uint32_t idx;
 
     // Check if label exists in stored labels
-    for (uint32_t l = 0; l < labels.size(); l++)
-        if (label == labels[l])
-            idx = l;
+    auto it = l_idxs.find(label);
 
     // If label is unrecognized
-    if (idx == 0xFFFFFFFF) {
+    if (it == l_idxs.end()) {
         pct_anom = 1.0;
-        idx = (uint32_t)labels.size();
-
-        // Add new item to arrays
-        labels.push_back(label);
-        counts.push_back(0);
-        l_states.emplace_back(BitArray(num_s));
-
-        // Randomly assign labels to statelets
-        l_states[idx].random_set_num(rng, num_spl);
+        idx = add_label(label);
+    }
+    else {
+        idx = it->second;
     }
 
     std::vector<uint32_t> output_acts = output.state.get_acts();
@@ -273,22 +286,31 @@ std::vector<double> PatternClassifierDynamic::get_probabilities() {
     uint32_t total_count = 0;
     uint32_t max_count = 0;
     uint32_t num_l = (uint32_t)labels.size();
-    std::vector<double> probs(num_l);
+    std::vector<double> probs(num_l, 0.0);
+
+    counts.assign(num_l, 0);
 
-    // Loop through stored labels
-    for (uint32_t l = 0; l < num_l; l++) {
+    // Loop through active output statelets
+    for (uint32_t w = 0; w < output.state.num_words(); w++) {
+        word_t word = output.state.words[w];
 
-        probs[l] = 0.0;
+        while (word) {
+            uint32_t s = w * WBITS + (uint32_t)trailing_zeros(word);
+            word &= word - 1;
 
-        // Get count of active output statelets of the label state
-        counts[l] = l_states[l].num_similar(output.state);
+            // Count the statelet for every label that owns it
+            for (uint32_t i = 0; i < s_labels[s].size(); i++) {
+                uint32_t l = s_labels[s][i];
+                counts[l]++;
 
-        // Update total count
-        total_count += counts[l];
+                // Store highest count
+                if (counts[l] > max_count)
+                    max_count = counts[l];
+            }
 
-        // Store highest count
-        if (counts[l] > max_count)
-            max_count = counts[l];
+            // Update total count
+            total_count += (uint32_t)s_labels[s].size();
+        }
     }
 
     // Update abnormality score based on highest count value
@@ -302,3 +324,110 @@ std::vector<double> PatternClassifierDynamic::get_probabilities() {
 
     return probs;
 }
+
+// =============================================================================
+// # Add Label
+//
+// Stores a new label, randomly assigns it num_spl statelets, and indexes those
+// statelets so probabilities can be gathered from the active statelets alone.
+// Returns the new label index.
+// =============================================================================
+uint32_t PatternClassifierDynamic::add_label(const uint32_t label) {
+
+    uint32_t idx = (uint32_t)labels.size();
+
+    // Add new item to arrays
+    labels.push_back(label);
+    counts.push_back(0);
+    l_states.emplace_back(BitArray(num_s));
+    l_idxs[label] = idx;
+
+    // Randomly assign labels to statelets
+    l_states[idx].random_set_num(rng, num_spl);
+
+    std::vector<uint32_t> acts = l_states[idx].get_acts();
+
+    for (uint32_t k = 0; k < acts.size(); k++)
+        s_labels[acts[k]].push_back(idx);
+
+    return idx;
+}
+
+// =============================================================================
+// # Fit Parallel
+//
+// Trains on pre-encoded inputs and their labels using num_threads replicas of
+// this block, each fed by its own BlankBlock.  Replicas start from this
+// block's memory and are merged back every merge_every samples (see
+// parallel_fit).  Every input must have as many bits as this block's input.
+//
+// Unseen labels are added here in order of first appearance before any
+// replica is made, so all replicas share the same label statelets.
+// =============================================================================
+void PatternClassifierDynamic::fit_parallel(
+        std::vector<BitArray>& inputs,
+        std::vector<uint32_t>& labels,
+        const uint32_t num_threads,
+        const uint32_t num_epochs,
+        const uint32_t merge_every,
+        const uint8_t merge_mode) {
+
+    assert(init_flag);
+    assert(num_threads > 0);
+    assert(labels.size() == inputs.size());
+
+    uint32_t num_i = input.state.num_bits();
+    std::vector<std::unique_ptr<BlankBlock>> feeds;
+    std::vector<std::unique_ptr<PatternClassifierDynamic>> reps;
+    std::vector<BlockMemory*> mems;
+
+    // Add unseen labels
+    for (uint32_t i = 0; i < inputs.size(); i++) {
+        assert(inputs[i].num_bits() == num_i);
+
+        if (l_idxs.find(labels[i]) == l_idxs.end())
+            add_label(labels[i]);
+    }
+
+    // Setup replicas
+    for (uint32_t r = 0; r < num_threads; r++) {
+        feeds.emplace_back(new BlankBlock(num_i));
+        reps.emplace_back(new PatternClassifierDynamic(
+            num_s, num_as, num_spl, perm_thr, perm_inc, perm_dec, pct_pool,
+            pct_conn, pct_learn, 2, rng()));
+        reps[r]->input.add_child(&feeds[r]->output, 0);
+        reps[r]->init();
+        reps[r]->labels = this->labels;
+        reps[r]->counts = counts;
+        reps[r]->l_states = l_states;
+        reps[r]->l_idxs = l_idxs;
+        reps[r]->s_labels = s_labels;
+        mems.push_back(&reps[r]->memory);
+    }
+
+    // Train replicas
+    parallel_fit(
+        memory, mems, (uint32_t)inputs.size(), num_epochs, merge_every,
+        merge_mode, [&](const uint32_t r, const uint32_t i) {
+            feeds[r]->output.state = inputs[i];
+            feeds[r]->feedforward();
+            reps[r]->set_label(labels[i]);
+            reps[r]->feedforward(true);
+        });
+}
+
+// =============================================================================
+// # Freeze
+//
+// Exports the trained block and its label statelets into an inference-only
+// FrozenPooler.
+// =============================================================================
+void PatternClassifierDynamic::freeze(FrozenPooler& frozen) {
+
+    assert(init_flag);
+
+    frozen.freeze(memory);
+
+    for (uint32_t l = 0; l < labels.size(); l++)
+        frozen.add_label(labels[l], l_states[l].get_acts());
+}
@@ -8,7 +8,10 @@
 #include "../block_input.hpp"
 #include "../block_memory.hpp"
 #include "../block_output.hpp"
+#include "../encode_cache.hpp"
+#include "frozen_pooler.hpp"
 
+#include <unordered_map>
 #include <vector>
 
 namespace BrainBlocks {
@@ -45,12 +48,25 @@ public:
     void store() override;
     // TODO: void bytes_used() override;
 
+    // Training functions
+    void fit_parallel(
+        std::vector<BitArray>& inputs,
+        std::vector<uint32_t>& labels,
+        const uint32_t num_threads,
+        const uint32_t num_epochs=1,
+        const uint32_t merge_every=1024,
+        const uint8_t merge_mode=MERGE_AVERAGE);
+
+    // Export functions
+    void freeze(FrozenPooler& frozen);
+
     // Setters
     void set_label(const uint32_t label) { this->label = label; };
 
     // Getters
     double get_anomaly_score() { return pct_anom; };
     std::vector<uint32_t> get_labels() { return labels; };
+    std::vector<BitArray> get_label_states() { return l_states; };
     std::vector<double> get_probabilities();
 
     // Block IO and memory variables
@@ -58,8 +74,13 @@ public:
     BlockOutput output;
     BlockMemory memory;
 
+    // Optional cache of encoded outputs (see EncodeCache, disabled by default)
+    EncodeCache cache;
+
 private:
 
+    uint32_t add_label(const uint32_t label);
+
     uint32_t label;   // input label
     uint32_t num_s;   // number of statelets
     uint32_t num_as;  // number of active statelets
@@ -77,6 +98,8 @@ private:
     std::vector<uint32_t> labels;
     std::vector<uint32_t> counts;
     std::vector<BitArray> l_states;
+    std::unordered_map<uint32_t, uint32_t> l_idxs;  // label to label index
+    std::vector<std::vector<uint32_t>> s_labels;    // statelet to label idxs
 };
 
 } // namespace BrainBlocks
@@ -2,7 +2,11 @@
 // pattern_pooler.cpp
 // =============================================================================
 #include "pattern_pooler.hpp"
+#include "../parallel_fit.hpp"
 #include "../utils.hpp"
+#include "blank_block.hpp"
+#include <algorithm>
+#include <memory>
 
 using namespace BrainBlocks;
 
@@ -65,6 +69,17 @@ void PatternPooler::init() {
         perm_dec, rng);
 
     init_flag = true;
+
+    // Pick the overlap kernel on synthetic inputs (see set_autotune)
+    if (tune_pct > 0.0) {
+        std::mt19937 tune_rng(0); // keeps the block's rng sequence unchanged
+        std::vector<BitArray> samples(tune_num, BitArray(num_i));
+
+        for (uint32_t t = 0; t < tune_num; t++)
+            samples[t].random_set_pct(tune_rng, tune_pct);
+
+        tuner.tune(memory, samples);
+    }
 }
 
 // =============================================================================
@@ -86,6 +101,7 @@ bool PatternPooler::save(const char* file) {
 
     // Save items
     memory.save(fptr);
+    tuner.save(fptr);
 
     // Close file pointer
     std::fclose(fptr);
@@ -111,7 +127,12 @@ bool PatternPooler::load(const char* file) {
         init();
 
     // Load items
-    memory.load(fptr);
+    if (!memory.load(fptr)) {
+        std::fclose(fptr);
+        return false;
+    }
+
+    tuner.load(fptr);
 
     // Close file pointer
     std::fclose(fptr);
@@ -129,6 +150,7 @@ void PatternPooler::clear() {
     input.clear();
     output.clear();
     memory.clear();
+    winners.clear();
 }
 
 // =============================================================================
@@ -162,42 +184,33 @@ void PatternPooler::encode() {
 
     // If any BlockInput children have changed
     if (always_update || input.children_changed()) {
+        uint64_t fp = 0;
+
+        // Group dendrite accesses of this step in the memory's trace
+        memory.trace_step();
+
+        // Reuse the output of a previously encoded identical input
+        if (cache.capacity() > 0) {
+            fp = input.state.fingerprint();
+
+            if (cache.fetch(fp, input.state, memory.version(), output.state)) {
+                winners = output.state.get_acts();
+                return;
+            }
+        }
 
         // Clear data
         output.state.clear_all();
 
         // Overlap each statelet
-        for (uint32_t s = 0; s < num_s; s++) {
-            overlaps[s] = memory.overlap_conn(s, input.state);
-            templaps[s] = overlaps[s];
-        }
+        tuner.overlap_all(memory, input.state, overlaps);
+        std::copy(overlaps.begin(), overlaps.end(), templaps.begin());
 
         // Activate statelets with k-highest overlap
-        for (uint32_t k = 0; k < num_as; k++) {
-	    //uint32_t beg_idx = utils_rand_uint(0, num_s - 1);
-            uint32_t beg_idx = 0;
-            uint32_t max_val = 0;
-            uint32_t max_idx = beg_idx;
-
-            // Loop through statelets
-            for (uint32_t i = 0; i < num_s; i++) {
-
-                // Account for random start location and wrap if necessary
-                //uint32_t j = i + beg_idx;
-                //uint32_t s = (j < num_s) ? j : (j - num_s);
-                uint32_t s = i;
-
-                // Find statelet with highest overlap
-                if (templaps[s] > max_val) {
-                    max_val = templaps[s];
-                    max_idx = s;
-		}
-            }
+        activate_winners(templaps, output.state, winners);
 
-            // Activate statelet with highest overlap
-            output.state.set_bit(max_idx);
-            templaps[max_idx] = 0;
-        }
+        if (cache.capacity() > 0)
+            cache.insert(fp, input.state, memory.version(), output.state);
     }
 }
 
@@ -221,6 +234,140 @@ void PatternPooler::learn() {
     }
 }
 
+// =============================================================================
+// # Encode Batch
+//
+// Encodes a batch of inputs into outputs, one BitArray per input, exactly as
+// feedforward() without learning would.  Each statelet's connections are
+// overlapped against every input in turn, so BlockMemory is walked once per
+// batch instead of once per time step.  The BlockOutput history is left
+// untouched; feed the outputs to stateful blocks in order (e.g. through a
+// BlankBlock).
+//
+// ## Example
+//
+// inputs: {x0, x1, x2}
+//
+// overlaps: s0: {x0, x1, x2}, s1: {x0, x1, x2}, ... (one pass over memory)
+// outputs:  {top num_as of x0, top num_as of x1, top num_as of x2}
+// =============================================================================
+void PatternPooler::encode_batch(
+        std::vector<BitArray>& inputs,
+        std::vector<BitArray>& outputs) {
+
+    assert(init_flag);
+
+    uint32_t num_x = (uint32_t)inputs.size();
+    std::vector<uint32_t> batch_overlaps((size_t)num_x * num_s);
+
+    for (uint32_t t = 0; t < num_x; t++)
+        assert(inputs[t].num_bits() == input.state.num_bits());
+
+    // Overlap each statelet with every input while its connections are cached
+    for (uint32_t s = 0; s < num_s; s++)
+        for (uint32_t t = 0; t < num_x; t++)
+            batch_overlaps[(size_t)t * num_s + s] =
+                memory.overlap_conn(s, inputs[t]);
+
+    std::vector<uint32_t> acts;
+    outputs.resize(num_x);
+
+    // Activate statelets with k-highest overlap for each input
+    for (uint32_t t = 0; t < num_x; t++) {
+        std::copy(
+            batch_overlaps.begin() + (size_t)t * num_s,
+            batch_overlaps.begin() + (size_t)(t + 1) * num_s,
+            templaps.begin());
+
+        if (outputs[t].num_bits() != num_s)
+            outputs[t].resize(num_s);
+
+        outputs[t].clear_all();
+        activate_winners(templaps, outputs[t], acts);
+    }
+}
+
+// =============================================================================
+// # Autotune
+//
+// Times the overlap kernels on recorded inputs, selects the fastest for
+// encode() and returns it (see OverlapTuner::tune).  Set learn_flag if the
+// block will keep learning.  The selection is saved with the block.
+//
+// ## Example
+//
+// pp.autotune(recorded_inputs);
+//
+// pp.tuner.get_timings(): {4.1e-05, 2.3e-05, 6.0e-06, 3.2e-06}
+// pp.tuner.get_kernel():  KERNEL_SLICED
+// =============================================================================
+uint8_t PatternPooler::autotune(
+        std::vector<BitArray>& inputs,
+        const bool learn_flag) {
+
+    if (!init_flag)
+        init();
+
+    for (uint32_t t = 0; t < inputs.size(); t++)
+        assert(inputs[t].num_bits() == input.state.num_bits());
+
+    return tuner.tune(memory, inputs, learn_flag);
+}
+
+// =============================================================================
+// # Set Autotune
+//
+// Makes init() autotune the overlap kernels on num_samples random inputs with
+// pct_active of their bits set.  A pct_active of 0 turns it off.
+// =============================================================================
+void PatternPooler::set_autotune(
+        const double pct_active,
+        const uint32_t num_samples) {
+
+    assert(pct_active >= 0.0 && pct_active <= 1.0);
+    assert(num_samples > 0);
+
+    tune_pct = pct_active;
+    tune_num = num_samples;
+}
+
+// =============================================================================
+// # Activate Winners
+//
+// Sets the bits of the num_as statelets with the highest scores in out and
+// lists them in ascending order in acts.  The scores vector is consumed:
+// winning entries are zeroed as they are chosen.
+// =============================================================================
+void PatternPooler::activate_winners(
+        std::vector<uint32_t>& scores,
+        BitArray& out,
+        std::vector<uint32_t>& acts) {
+
+    acts.clear();
+
+    for (uint32_t k = 0; k < num_as; k++) {
+        uint32_t max_val = 0;
+        uint32_t max_idx = 0;
+
+        // Find statelet with highest score
+        for (uint32_t s = 0; s < num_s; s++) {
+            if (scores[s] > max_val) {
+                max_val = scores[s];
+                max_idx = s;
+            }
+        }
+
+        // Activate statelet with highest score
+        if (!out.get_bit(max_idx))
+            acts.push_back(max_idx);
+
+        out.set_bit(max_idx);
+        scores[max_idx] = 0;
+    }
+
+    std::sort(acts.begin(), acts.end());
+}
+
 // =============================================================================
 // # Store
 //
@@ -230,3 +377,62 @@ void PatternPooler::store() {
 
     output.store();
 }
+
+// =============================================================================
+// # Fit Parallel
+//
+// Trains on pre-encoded inputs using num_threads replicas of this block, each
+// fed by its own BlankBlock.  Replicas start from this block's memory and are
+// merged back every merge_every samples (see parallel_fit).  Every input must
+// have as many bits as this block's input.
+// =============================================================================
+void PatternPooler::fit_parallel(
+        std::vector<BitArray>& inputs,
+        const uint32_t num_threads,
+        const uint32_t num_epochs,
+        const uint32_t merge_every,
+        const uint8_t merge_mode) {
+
+    assert(init_flag);
+    assert(num_threads > 0);
+
+    uint32_t num_i = input.state.num_bits();
+    std::vector<std::unique_ptr<BlankBlock>> feeds;
+    std::vector<std::unique_ptr<PatternPooler>> reps;
+    std::vector<BlockMemory*> mems;
+
+    for (uint32_t i = 0; i < inputs.size(); i++)
+        assert(inputs[i].num_bits() == num_i);
+
+    // Setup replicas
+    for (uint32_t r = 0; r < num_threads; r++) {
+        feeds.emplace_back(new BlankBlock(num_i));
+        reps.emplace_back(new PatternPooler(
+            num_s, num_as, perm_thr, perm_inc, perm_dec, pct_pool, pct_conn,
+            pct_learn, 2, always_update, rng()));
+        reps[r]->input.add_child(&feeds[r]->output, 0);
+        reps[r]->init();
+        mems.push_back(&reps[r]->memory);
+    }
+
+    // Train replicas
+    parallel_fit(
+        memory, mems, (uint32_t)inputs.size(), num_epochs, merge_every,
+        merge_mode, [&](const uint32_t r, const uint32_t i) {
+            feeds[r]->output.state = inputs[i];
+            feeds[r]->feedforward();
+            reps[r]->feedforward(true);
+        });
+}
+
+// =============================================================================
+// # Freeze
+//
+// Exports the trained block into an inference-only FrozenPooler.
+// =============================================================================
+void PatternPooler::freeze(FrozenPooler& frozen) {
+
+    assert(init_flag);
+
+    frozen.freeze(memory);
+}
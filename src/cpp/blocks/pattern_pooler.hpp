@@ -8,6 +8,9 @@
 #include "../block_input.hpp"
 #include "../block_memory.hpp"
 #include "../block_output.hpp"
+#include "../encode_cache.hpp"
+#include "../overlap_tuner.hpp"
+#include "frozen_pooler.hpp"
 
 #include <vector>
 
@@ -45,13 +48,50 @@ public:
     void store() override;
     // TODO: void bytes_used() override;
 
+    // Encodes many inputs at once without touching the BlockOutput
+    void encode_batch(
+        std::vector<BitArray>& inputs,
+        std::vector<BitArray>& outputs);
+
+    // Overlap kernel selection (see OverlapTuner)
+    uint8_t autotune(
+        std::vector<BitArray>& inputs,
+        const bool learn_flag=false);
+
+    void set_autotune(const double pct_active, const uint32_t num_samples=64);
+
+    // Getters
+    const std::vector<uint32_t>& get_winners() { return winners; };
+
+    // Training functions
+    void fit_parallel(
+        std::vector<BitArray>& inputs,
+        const uint32_t num_threads,
+        const uint32_t num_epochs=1,
+        const uint32_t merge_every=1024,
+        const uint8_t merge_mode=MERGE_AVERAGE);
+
+    // Export functions
+    void freeze(FrozenPooler& frozen);
+
     // Block IO and memory variables
     BlockInput input;
     BlockOutput output;
     BlockMemory memory;
 
+    // Optional cache of encoded outputs (see EncodeCache, disabled by default)
+    EncodeCache cache;
+
+    // Overlap kernels used by encode (KERNEL_CONN unless tuned or set)
+    OverlapTuner tuner;
+
 private:
 
+    void activate_winners(
+        std::vector<uint32_t>& scores,
+        BitArray& out,
+        std::vector<uint32_t>& acts);
+
     uint32_t num_s;   // number of statelets
     uint32_t num_as;  // number of active statelets
     uint8_t perm_thr; // permanence threshold
@@ -61,9 +101,12 @@ private:
     double pct_conn;  // percent initially connected
     double pct_learn; // percent learn
     bool always_update; // whether to only update on input changes
+    double tune_pct = 0.0; // input density autotuned at init (0 is off)
+    uint32_t tune_num = 0; // number of synthetic autotune inputs
 
     std::vector<uint32_t> overlaps; // overlaps
     std::vector<uint32_t> templaps; // temporary overlaps
+    std::vector<uint32_t> winners;  // active statelets in output (sorted)
 };
 
 } // namespace BrainBlocks
@@ -83,6 +83,46 @@ void ScalarTransformer::encode() {
     value_prev = value;
 }
 
+// =============================================================================
+// # Encode Batch
+//
+// Encodes a batch of values into outputs, one BitArray per value, exactly as
+// set_value() followed by feedforward() would.  The BlockOutput history and
+// the current value are left untouched, so a stateless stage can encode T
+// future samples ahead of the stateful blocks that consume them in order.
+//
+// ## Example
+//
+// min_val: 0.0, max_val: 1.0, num_s: 8, num_as: 2
+//
+// values: {0.0, 0.5, 1.0}
+//
+// outputs[0]: {11000000}
+// outputs[1]: {00011000}
+// outputs[2]: {00000011}
+// =============================================================================
+void ScalarTransformer::encode_batch(
+        const std::vector<double>& values,
+        std::vector<BitArray>& outputs) {
+
+    outputs.resize(values.size());
+
+    for (uint32_t t = 0; t < values.size(); t++) {
+        double val = values[t];
+
+        if (val < min_val) val = min_val;
+        if (val > max_val) val = max_val;
+        double percent = (val - min_val) / dif_val;
+        uint32_t beg = (uint32_t)((double)dif_s * percent);
+
+        if (outputs[t].num_bits() != num_s)
+            outputs[t].resize(num_s);
+
+        outputs[t].clear_all();
+        outputs[t].set_range(beg, num_as);
+    }
+}
+
 // =============================================================================
 // # Decode
 //
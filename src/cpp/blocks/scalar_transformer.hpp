@@ -7,6 +7,8 @@
 #include "../block.hpp"
 #include "../block_output.hpp"
 
+#include <vector>
+
 namespace BrainBlocks {
 
 class ScalarTransformer final : public Block {
@@ -28,6 +30,11 @@ public:
     void decode() override;
     void store() override;
 
+    // Encodes many values at once without touching the BlockOutput
+    void encode_batch(
+        const std::vector<double>& values,
+        std::vector<BitArray>& outputs);
+
     // Getters and setters
     void set_value(const double val) { value = val; };
     double get_value() { return value; };
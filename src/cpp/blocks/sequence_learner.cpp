@@ -2,7 +2,12 @@
 // sequence_learner.cpp
 // =============================================================================
 #include "sequence_learner.hpp"
+#include "blank_block.hpp"
 #include "../utils.hpp"
+#include <cmath>
+#include <stdexcept> // for length_error
+#include <memory>
+#include <thread>
 
 using namespace BrainBlocks;
 
@@ -38,7 +43,8 @@ using namespace BrainBlocks;
 // =============================================================================
 // # Constructor
 //
-// Constructs a SequenceLearner.
+// Constructs a SequenceLearner.  Throws std::length_error if the number of
+// dendrites, num_c * num_spc * num_dps, does not fit in 32 bits.
 // =============================================================================
 SequenceLearner::SequenceLearner(
     const uint32_t num_c,    // number of columns
@@ -60,6 +66,12 @@ SequenceLearner::SequenceLearner(
     assert(num_rpd > 0);
     assert(d_thresh < num_rpd);
 
+    // Dendrite indices are 32-bit (receptor offsets are 64-bit)
+    if ((uint64_t)num_c * num_spc > UINT32_MAX ||
+        (uint64_t)num_c * num_spc * num_dps > UINT32_MAX)
+        throw std::length_error(
+            "SequenceLearner: num_c * num_spc * num_dps exceeds 2^32 - 1");
+
     this->num_c = num_c;
     this->num_spc = num_spc;
     this->num_dps = num_dps;
@@ -153,7 +165,11 @@ bool SequenceLearner::load(const char* file) {
         init();
 
     // Load items
-    memory.load(fptr);
+    if (!memory.load(fptr)) {
+        std::fclose(fptr);
+        return false;
+    }
+
     d_used.load(fptr);
     std::fread(next_sd.data(), sizeof(next_sd[0]), next_sd.size(), fptr);
 
@@ -207,26 +223,15 @@ void SequenceLearner::encode() {
     assert(init_flag);
 
     // If any BlockInput children have changed
-    if (always_update || input.children_changed() || context.children_changed()) {
+    if (update_needed()) {
 
         // Get active columns
         input_acts = input.state.get_acts();
 
-        // Clear data
-        pct_anom = 0.0;
-	output.state.clear_all();
-        memory.state.clear_all();
+        // Group dendrite accesses of this step in the memory's trace
+        memory.trace_step();
 
-        // For every active column
-        for (uint32_t k = 0; k < input_acts.size(); k++) {
-            uint32_t c = input_acts[k];
-	    surprise_flag = true;
-
-            recognition(c);
-
-            if (surprise_flag)
-                surprise(c);
-        }
+        encode_columns();
     }
 }
 
@@ -240,25 +245,8 @@ void SequenceLearner::learn() {
     assert(init_flag);
 
     // If any BlockInput children have changed
-    if (always_update || input.children_changed() || context.children_changed()) {
-
-        // For every active column
-        for (uint32_t k = 0; k < input_acts.size(); k++) {
-            uint32_t c = input_acts[k];
-            uint32_t d_beg = c * num_dpc;
-            uint32_t d_end = d_beg + num_dpc;
-
-            // For every dendrite on the column
-            for (uint32_t d = d_beg; d < d_end; d++) {
-
-                // Learn and move the dendrite if it is active
-                if (memory.state.get_bit(d)) {
-                    memory.learn_move(d, context.state, rng);
-                    d_used.set_bit(d);
-                }
-            }
-        }
-    }
+    if (update_needed())
+        learn_columns();
 }
 
 // =============================================================================
@@ -271,6 +259,258 @@ void SequenceLearner::store() {
     output.store();
 }
 
+// =============================================================================
+// # Feedforward Acts
+//
+// Performs feedforward() with the active input columns given directly instead
+// of pulled from the input BlockOutput, e.g. the sorted winner list of a
+// PatternPooler (see PatternPooler::get_winners).  This skips copying the
+// input state and re-extracting its active bits.  acts must list the set bits
+// of the connected input in ascending order, so outputs and learning are
+// identical to feedforward().  The input is still checked for changes, but
+// input.state itself is not refreshed.
+//
+// ## Example
+//
+// pp.feedforward(learn);
+// sl.feedforward_acts(pp.get_winners(), learn);
+// =============================================================================
+void SequenceLearner::feedforward_acts(
+        const std::vector<uint32_t>& acts,
+        const bool learn_flag) {
+
+    if (!init_flag)
+        init();
+
+    step();
+    context.pull();
+
+    bool update = update_needed();
+
+    if (update) {
+        input_acts = acts;
+
+        // Group dendrite accesses of this step in the memory's trace
+        memory.trace_step();
+
+        encode_columns();
+    }
+
+    store();
+
+    if (learn_flag && update)
+        learn_columns();
+}
+
+// =============================================================================
+// # Backfill
+//
+// Scores a long historical series of column inputs without learning.  The
+// series is split into one contiguous chunk per thread and each chunk is
+// scored by a replica with an empty output history.  Replicas read this
+// block's receptors and dendrite usage in place and only copy the small
+// per-statelet state (next_sd) and dendrite activations, so K threads do not
+// cost K copies of the memory.  Their overlaps are not counted for tiering or
+// tracing.  A replica begins warmup steps before its chunk so its context can
+// settle, and only scores inside the chunk are kept.  The block itself is left
+// unchanged.
+//
+// Because surprise() still advances the next available dendrites and picks
+// random statelets, chunked scores approximate a single sequential pass.  If
+// divergence is given it receives, for each chunk boundary, the mean absolute
+// difference between the next replica's warm-up scores and the previous
+// chunk's scores over the same samples.  The first num_t - 1 warm-up steps are
+// skipped since their context history is still empty.  Values near 0.0 mean
+// the warm-up was long enough for the chunks to stitch together cleanly.
+//
+// ## Example
+//
+// inputs: 10, num_threads: 2, warmup: 2
+//
+// chunk 0: scores {0, 1, 2, 3, 4}
+// chunk 1: warms up on {3, 4}, scores {5, 6, 7, 8, 9}
+// divergence[0]: mean |warm-up score - chunk 0 score| over {4} (num_t: 2)
+// =============================================================================
+std::vector<double> SequenceLearner::backfill(
+        std::vector<BitArray>& inputs,
+        const uint32_t num_threads,
+        const uint32_t warmup,
+        std::vector<double>* divergence) {
+
+    assert(init_flag);
+    assert(num_threads > 0);
+
+    uint32_t num_i = (uint32_t)inputs.size();
+    uint32_t num_r = num_threads < num_i ? num_threads : num_i;
+    std::vector<double> scores(num_i);
+    std::vector<std::vector<double>> warm(num_r);
+    std::vector<uint32_t> begs(num_r);
+    std::vector<std::unique_ptr<BlankBlock>> feeds;
+    std::vector<std::unique_ptr<SequenceLearner>> reps;
+    std::vector<std::thread> threads;
+
+    for (uint32_t i = 0; i < num_i; i++)
+        assert(inputs[i].num_bits() == num_c);
+
+    // Setup replicas
+    for (uint32_t r = 0; r < num_r; r++) {
+        begs[r] = (uint32_t)((uint64_t)num_i * r / num_r);
+        feeds.emplace_back(new BlankBlock(num_c));
+        reps.emplace_back(new SequenceLearner(
+            num_c, num_spc, num_dps, num_rpd, d_thresh, perm_thr, perm_inc,
+            perm_dec, output.num_t(), always_update));
+        reps[r]->input.add_child(&feeds[r]->output, 0);
+        reps[r]->shared = &memory;
+        reps[r]->shared_used = &d_used;
+        reps[r]->memory.state.resize(num_d);
+        reps[r]->next_sd = next_sd;
+        reps[r]->init_flag = true;
+    }
+
+    // Score each chunk in its own thread
+    for (uint32_t r = 0; r < num_r; r++) {
+        threads.emplace_back([&, r]() {
+            uint32_t c_beg = begs[r];
+            uint32_t c_end = r + 1 < num_r ? begs[r + 1] : num_i;
+            uint32_t w_beg = c_beg > warmup ? c_beg - warmup : 0;
+
+            for (uint32_t i = w_beg; i < c_end; i++) {
+                feeds[r]->output.state = inputs[i];
+                feeds[r]->feedforward();
+                reps[r]->feedforward(false);
+
+                if (i < c_beg)
+                    warm[r].push_back(reps[r]->pct_anom);
+                else
+                    scores[i] = reps[r]->pct_anom;
+            }
+        });
+    }
+
+    for (uint32_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+
+    // Compare warm-up scores against the previous chunk's scores
+    if (divergence != nullptr) {
+        divergence->clear();
+
+        uint32_t skip = output.num_t() - 1;
+
+        for (uint32_t r = 1; r < num_r; r++) {
+            uint32_t num_w = (uint32_t)warm[r].size();
+            uint32_t w_beg = begs[r] - num_w;
+            double sum = 0.0;
+
+            if (num_w <= skip) {
+                divergence->push_back(0.0);
+                continue;
+            }
+
+            for (uint32_t w = skip; w < num_w; w++)
+                sum += std::fabs(warm[r][w] - scores[w_beg + w]);
+
+            divergence->push_back(sum / (num_w - skip));
+        }
+    }
+
+    return scores;
+}
+
+// =============================================================================
+// # Update Needed
+//
+// Returns true if the block should encode and learn this time step.
+// =============================================================================
+bool SequenceLearner::update_needed() {
+
+    return always_update || input.children_changed() ||
+        context.children_changed();
+}
+
+// =============================================================================
+// # Encode Columns
+//
+// Computes the BlockOutput state from the active columns in input_acts.
+//
+// Recognition mostly waits on memory: each used dendrite's receptors, then the
+// random context words under them.  With a prefetch depth of P (see
+// set_prefetch) the columns are pipelined so these loads overlap: while column
+// k is recognized the receptors of column k + P are prefetched.  If inputs are
+// prefetched too, receptors run 2P ahead and the context words under column
+// k + P are prefetched from the receptors already in cache.  Results do not
+// depend on the depth.
+//
+// ## Example
+//
+// set_prefetch(2, true)
+//
+//         k: 0  1  2  3  4 ...
+// receptors: 4  5  6  7  8 ...
+//    inputs: 2  3  4  5  6 ...
+//
+// (receptors of columns 0 to 3 and inputs of 0 to 1 are prefetched first)
+// =============================================================================
+void SequenceLearner::encode_columns() {
+
+    // Clear data
+    pct_anom = 0.0;
+    output.state.clear_all();
+    memory.state.clear_tracked();
+
+    uint32_t num_a = (uint32_t)input_acts.size();
+    uint32_t num_i = prefetch_inputs ? prefetch_depth : 0;
+    uint32_t num_r = prefetch_depth + num_i;
+
+    // Fill the pipeline
+    for (uint32_t k = 0; k < num_r && k < num_a; k++)
+        prefetch_column(input_acts[k], false);
+
+    for (uint32_t k = 0; k < num_i && k < num_a; k++)
+        prefetch_column(input_acts[k], true);
+
+    // For every active column
+    for (uint32_t k = 0; k < num_a; k++) {
+        uint32_t c = input_acts[k];
+        surprise_flag = true;
+
+        if (num_r > 0 && k + num_r < num_a)
+            prefetch_column(input_acts[k + num_r], false);
+
+        if (num_i > 0 && k + num_i < num_a)
+            prefetch_column(input_acts[k + num_i], true);
+
+        recognition(c);
+
+        if (surprise_flag)
+            surprise(c);
+    }
+}
+
+// =============================================================================
+// # Learn Columns
+//
+// Learns the active dendrites on the active columns in input_acts.
+// =============================================================================
+void SequenceLearner::learn_columns() {
+
+    // For every active column
+    for (uint32_t k = 0; k < input_acts.size(); k++) {
+        uint32_t c = input_acts[k];
+        uint32_t d_beg = c * num_dpc;
+        uint32_t d_end = d_beg + num_dpc;
+
+        // For every dendrite on the column
+        for (uint32_t d = d_beg; d < d_end; d++) {
+
+            // Learn and move the dendrite if it is active
+            if (memory.state.get_bit(d)) {
+                memory.learn_move(d, context.state, rng);
+                d_used.set_bit(d);
+            }
+        }
+    }
+}
+
 // =============================================================================
 // # Recognition
 //
@@ -281,19 +521,24 @@ void SequenceLearner::recognition(const uint32_t c) {
     uint32_t d_beg = c * num_dpc;
     uint32_t d_end = d_beg + num_dpc;
 
+    // Backfill replicas read their parent's receptors (see backfill)
+    BlockMemory& r_memory = shared ? *shared : memory;
+    BitArray& r_used = shared ? *shared_used : d_used;
+
     // For every dendrite on the column
     for (uint32_t d = d_beg; d < d_end; d++) {
 
         // If dendrite is used then overlap
-	if (d_used.get_bit(d)) {
+	if (r_used.get_bit(d)) {
 
             // Overlap dendrite with context
-            uint32_t overlap = memory.overlap(d, context.state);
+            uint32_t overlap = r_memory.overlap(
+                d, context.state, shared == nullptr);
 
             // If dendrite overlap is above the threshold
             if (overlap >= d_thresh) {
                 uint32_t s = d / num_dps;
-                memory.state.set_bit(d); // activate the dendrite
+                memory.state.set_bit_tracked(d); // activate the dendrite
                 output.state.set_bit(s); // activate the dendrite's statelet
                 surprise_flag = false;
             }
@@ -301,6 +546,37 @@ void SequenceLearner::recognition(const uint32_t c) {
     }
 }
 
+// =============================================================================
+// # Prefetch Column
+//
+// Prefetches the receptors of a column's used dendrites, or with inputs_flag
+// the context words under their connected receptors (see encode_columns).
+// =============================================================================
+void SequenceLearner::prefetch_column(
+        const uint32_t c,
+        const bool inputs_flag) {
+
+    uint32_t d_beg = c * num_dpc;
+    BlockMemory& r_memory = shared ? *shared : memory;
+    BitSpan used(shared ? *shared_used : d_used, d_beg, num_dpc);
+    BitSpan in(context.state);
+
+    // Visit used dendrites a word of d_used at a time
+    for (uint32_t i = 0; i < used.num_words(); i++) {
+        word_t word = used.get_word(i);
+
+        while (word) {
+            uint32_t d = d_beg + i * WBITS + trailing_zeros(word);
+            word &= word - 1;
+
+            if (inputs_flag)
+                r_memory.prefetch_inputs(d, in);
+            else
+                r_memory.prefetch(d);
+        }
+    }
+}
+
 // =============================================================================
 // Suprise
 //
@@ -351,7 +627,7 @@ void SequenceLearner::set_next_available_dendrite(const uint32_t s) {
     uint32_t d_next = d_beg + next_sd[s];
 
     // Activate random statelet's next available dendrite
-    memory.state.set_bit(d_next);
+    memory.state.set_bit_tracked(d_next);
 
     // Update random statelet's next available dendrite
     if(next_sd[s] < num_dps - 1)
@@ -45,8 +45,27 @@ public:
     void store() override;
     // TODO: void bytes_used() override;
 
+    // Runs feedforward with the active input columns given directly
+    void feedforward_acts(
+        const std::vector<uint32_t>& acts,
+        const bool learn_flag=false);
+
+    // Scores a long series in parallel chunks without learning
+    std::vector<double> backfill(
+        std::vector<BitArray>& inputs,
+        const uint32_t num_threads,
+        const uint32_t warmup=0,
+        std::vector<double>* divergence=nullptr);
+
+    // Prefetches memories this many active columns ahead of recognition
+    void set_prefetch(const uint32_t depth, const bool inputs=false) {
+        prefetch_depth = depth;
+        prefetch_inputs = inputs;
+    };
+
     // Getters
     double get_anomaly_score() { return pct_anom; };
+    uint32_t get_prefetch() { return prefetch_depth; };
 
     // Block IO and memory variables
     BlockInput input;
@@ -56,7 +75,11 @@ public:
 
 private:
 
+    bool update_needed();
+    void encode_columns();
+    void learn_columns();
     void recognition(const uint32_t c);
+    void prefetch_column(const uint32_t c, const bool inputs_flag);
     void surprise(const uint32_t c);
     void set_next_available_dendrite(const uint32_t s);
 
@@ -73,11 +96,18 @@ private:
     uint8_t perm_dec;  // permanence decrement
     double pct_anom;   // anomaly score percentage (0.0 to 1.0)
     bool always_update; // whether to only update on input changes
+    uint32_t prefetch_depth = 0;  // active columns prefetched ahead (0 is off)
+    bool prefetch_inputs = false; // whether context words are prefetched too
 
     bool surprise_flag = false;
     std::vector<uint32_t> input_acts;
     std::vector<uint32_t> next_sd; // next available dendrite on statelets
     BitArray d_used; // (0 = dendrite available, 1 = dendrite in use)
+
+    // Read-only receptors and dendrite usage of a backfill replica's parent
+    // (nullptr uses memory and d_used, see backfill)
+    BlockMemory* shared = nullptr;
+    BitArray* shared_used = nullptr;
 };
 
 } // namespace BrainBlocks
@@ -0,0 +1,162 @@
+// =============================================================================
+// encode_cache.cpp
+// =============================================================================
+#include "encode_cache.hpp"
+#include <cassert>
+
+using namespace BrainBlocks;
+
+// =============================================================================
+// # EncodeCache
+//
+// Bounded least-recently-used cache from block inputs to encoded outputs.
+// Entries are keyed by the input fingerprint (see BitArray::fingerprint) and
+// are only valid for the BlockMemory version they were encoded with.  When
+// the version changes, e.g. because learn() adapted the memories, every entry
+// is dropped on the next fetch.  The cache is intended for inference where
+// inputs repeat (discrete states, quantized values, cyclic patterns).  While
+// learning it is flushed every step and only adds overhead.
+//
+// ## Example
+//
+// uint64_t fp = input.fingerprint();
+//
+// if (!cache.fetch(fp, input, memory.version(), output)) {
+//     ... encode input into output ...
+//     cache.insert(fp, input, memory.version(), output);
+// }
+// =============================================================================
+
+// =============================================================================
+// # Constructor
+//
+// Constructs an EncodeCache holding at most capacity entries (0 = disabled).
+// =============================================================================
+EncodeCache::EncodeCache(const uint32_t capacity) {
+
+    cap = capacity;
+}
+
+// =============================================================================
+// # Resize
+//
+// Sets the maximum number of entries (0 = disabled) and clears the cache.
+// =============================================================================
+void EncodeCache::resize(const uint32_t capacity) {
+
+    cap = capacity;
+    clear();
+}
+
+// =============================================================================
+// # Clear
+//
+// Drops all entries and resets the hit and miss counters.
+// =============================================================================
+void EncodeCache::clear() {
+
+    entries.clear();
+    lookup.clear();
+    hits = 0;
+    misses = 0;
+}
+
+// =============================================================================
+// # Fetch
+//
+// Writes the cached output for input into output and returns true on a hit.
+// Returns false on a miss, leaving output untouched.
+// =============================================================================
+bool EncodeCache::fetch(
+        const uint64_t fp,
+        BitArray& input,
+        const uint64_t version,
+        BitArray& output) {
+
+    if (cap == 0)
+        return false;
+
+    // Drop entries encoded with stale memories
+    if (version != this->version) {
+        entries.clear();
+        lookup.clear();
+        this->version = version;
+    }
+
+    auto it = lookup.find(fp);
+
+    if (it == lookup.end() || it->second->input != input) {
+        misses++;
+        return false;
+    }
+
+    // Move entry to the front of the recently used list
+    entries.splice(entries.begin(), entries, it->second);
+
+    std::vector<uint32_t>& acts = it->second->acts;
+    output.clear_all();
+
+    for (uint32_t k = 0; k < acts.size(); k++)
+        output.set_bit(acts[k]);
+
+    hits++;
+
+    return true;
+}
+
+// =============================================================================
+// # Insert
+//
+// Stores the output encoded from input, evicting the least recently used
+// entry when the cache is full.
+// =============================================================================
+void EncodeCache::insert(
+        const uint64_t fp,
+        BitArray& input,
+        const uint64_t version,
+        BitArray& output) {
+
+    if (cap == 0)
+        return;
+
+    if (version != this->version) {
+        entries.clear();
+        lookup.clear();
+        this->version = version;
+    }
+
+    auto it = lookup.find(fp);
+
+    // Replace an entry with the same fingerprint
+    if (it != lookup.end()) {
+        entries.erase(it->second);
+        lookup.erase(it);
+    }
+
+    // Evict least recently used entry
+    if (lookup.size() >= cap) {
+        lookup.erase(entries.back().fp);
+        entries.pop_back();
+    }
+
+    entries.push_front(Entry{fp, input, output.get_acts()});
+    lookup[fp] = entries.begin();
+}
+
+// =============================================================================
+// # Memory Usage
+//
+// Returns an estimate of the number of bytes used by the EncodeCache.
+// =============================================================================
+uint64_t EncodeCache::memory_usage() {
+
+    uint64_t bytes = sizeof(*this);
+
+    for (Entry& e : entries) {
+        bytes += sizeof(e) + e.input.memory_usage();
+        bytes += (uint64_t)(e.acts.size() * sizeof(uint32_t));
+        bytes += sizeof(uint64_t) + sizeof(void*);
+    }
+
+    return bytes;
+}
@@ -0,0 +1,65 @@
+// =============================================================================
+// encode_cache.hpp
+// =============================================================================
+#ifndef ENCODE_CACHE_HPP
+#define ENCODE_CACHE_HPP
+
+#include "bitarray.hpp"
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace BrainBlocks {
+
+class EncodeCache {
+
+public:
+
+    // Constructor
+    EncodeCache(const uint32_t capacity=0);
+
+    // Misc. functions
+    void resize(const uint32_t capacity);
+    void clear();
+    uint64_t memory_usage();
+
+    // Core functions
+    bool fetch(
+        const uint64_t fp,
+        BitArray& input,
+        const uint64_t version,
+        BitArray& output);
+
+    void insert(
+        const uint64_t fp,
+        BitArray& input,
+        const uint64_t version,
+        BitArray& output);
+
+    // Getters
+    uint32_t capacity() const { return cap; };
+    uint32_t size() const { return (uint32_t)lookup.size(); };
+    uint64_t num_hits() const { return hits; };
+    uint64_t num_misses() const { return misses; };
+
+private:
+
+    struct Entry {
+        uint64_t fp;                // input fingerprint
+        BitArray input;             // input bits (guards collisions)
+        std::vector<uint32_t> acts; // output active statelets
+    };
+
+    uint32_t cap = 0;     // maximum number of entries (0 = disabled)
+    uint64_t version = 0; // BlockMemory version of the cached entries
+    uint64_t hits = 0;    // number of fetch hits
+    uint64_t misses = 0;  // number of fetch misses
+
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> lookup;
+};
+
+} // namespace BrainBlocks
+
+#endif // ENCODE_CACHE_HPP
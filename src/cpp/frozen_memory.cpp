@@ -0,0 +1,261 @@
+// =============================================================================
+// frozen_memory.cpp
+// =============================================================================
+#include "frozen_memory.hpp"
+#include "utils.hpp"
+#include <cassert>
+
+#define FROZEN_MEMORY_MAGIC 0x4D464242 // "BBFM"
+#define FROZEN_MEMORY_VERSION 1
+
+using namespace BrainBlocks;
+
+// =============================================================================
+// # FrozenMemory
+//
+// FrozenMemory is the inference-only form of a trained BlockMemory.  Only the
+// connected structure is kept: receptor addresses, permanences and learning
+// state are dropped.  Each dendrite's connections are stored either as a dense
+// connection BitArray or as a sorted list of connected addresses, whichever
+// form is smaller for the whole memory.
+// =============================================================================
+
+// =============================================================================
+// # Initialize
+//
+// Converts a trained BlockMemory into its minimal inference form.
+//
+// ## Example
+//
+// num_i: 1024, num_d: 512, 40 connected receptors per dendrite
+//
+//  dense bytes: 512 * (1024 / 8)    = 65536
+// sparse bytes: (512 + 1) * 4 + 512 * 40 * 4 = 83972
+//
+// The dense form is chosen.
+// =============================================================================
+void FrozenMemory::init(BlockMemory& memory) {
+
+    num_i = memory.num_inputs();
+    num_d = memory.num_dendrites();
+
+    assert(num_i > 0);
+    assert(num_d > 0);
+
+    // Gather connected addresses of each dendrite
+    d_offs.resize(num_d + 1);
+    c_addrs.clear();
+    d_offs[0] = 0;
+
+    for (uint32_t d = 0; d < num_d; d++) {
+        std::vector<uint32_t> conns = memory.conn_addrs(d);
+        c_addrs.insert(c_addrs.end(), conns.begin(), conns.end());
+        d_offs[d + 1] = (uint32_t)c_addrs.size();
+    }
+
+    // Choose the smaller form
+    uint64_t num_w = (num_i + WBITS - 1) / WBITS;
+    uint64_t dense_bytes = (uint64_t)num_d * num_w * WBYTES;
+    uint64_t sparse_bytes = (d_offs.size() + c_addrs.size()) * sizeof(uint32_t);
+
+    dense_flag = dense_bytes < sparse_bytes;
+
+    if (dense_flag) {
+        d_conns.resize(num_d);
+
+        for (uint32_t d = 0; d < num_d; d++) {
+            d_conns[d].resize(num_i);
+
+            for (uint32_t i = d_offs[d]; i < d_offs[d + 1]; i++)
+                d_conns[d].set_bit(c_addrs[i]);
+        }
+
+        d_offs.clear();
+        d_offs.shrink_to_fit();
+        c_addrs.clear();
+        c_addrs.shrink_to_fit();
+    }
+    else {
+        d_conns.clear();
+        d_conns.shrink_to_fit();
+    }
+
+    init_flag = true;
+}
+
+// =============================================================================
+// # Save
+//
+// Saves frozen memories.  Unlike BlockMemory the file is self-describing so a
+// FrozenMemory can be loaded without the BlockMemory it was created from.
+// The data starts with a magic number and version.
+// =============================================================================
+void FrozenMemory::save(FILE* fptr) {
+
+    assert(init_flag);
+
+    uint32_t header[2] = {FROZEN_MEMORY_MAGIC, FROZEN_MEMORY_VERSION};
+    uint32_t num_c = (uint32_t)c_addrs.size();
+    uint8_t dense = dense_flag ? 1 : 0;
+
+    std::fwrite(header, sizeof(header[0]), 2, fptr);
+    std::fwrite(&dense, sizeof(dense), 1, fptr);
+    std::fwrite(&num_i, sizeof(num_i), 1, fptr);
+    std::fwrite(&num_d, sizeof(num_d), 1, fptr);
+    std::fwrite(&num_c, sizeof(num_c), 1, fptr);
+
+    if (dense_flag) {
+        for (uint32_t d = 0; d < num_d; d++)
+            d_conns[d].save(fptr);
+    }
+    else {
+        std::fwrite(d_offs.data(), sizeof(d_offs[0]), d_offs.size(), fptr);
+        std::fwrite(c_addrs.data(), sizeof(c_addrs[0]), c_addrs.size(), fptr);
+    }
+}
+
+// =============================================================================
+// # Load
+//
+// Loads frozen memories.  Returns false and leaves the memory unchanged if the
+// magic number or version is unknown, the file ends early, the sizes need
+// more bytes than the file holds, or the sparse offsets and addresses are out
+// of range.
+// =============================================================================
+bool FrozenMemory::load(FILE* fptr) {
+
+    uint32_t header[2] = {0, 0};
+    uint32_t n_i = 0;
+    uint32_t n_d = 0;
+    uint32_t num_c = 0;
+    uint8_t dense = 0;
+
+    if (std::fread(header, sizeof(header[0]), 2, fptr) != 2 ||
+        header[0] != FROZEN_MEMORY_MAGIC ||
+        header[1] != FROZEN_MEMORY_VERSION ||
+        std::fread(&dense, sizeof(dense), 1, fptr) != 1 ||
+        std::fread(&n_i, sizeof(n_i), 1, fptr) != 1 ||
+        std::fread(&n_d, sizeof(n_d), 1, fptr) != 1 ||
+        std::fread(&num_c, sizeof(num_c), 1, fptr) != 1)
+        return false;
+
+    uint64_t num_w = ((uint64_t)n_i + WBITS - 1) / WBITS;
+    uint64_t bytes = dense > 0
+        ? (uint64_t)n_d * num_w * WBYTES
+        : ((uint64_t)n_d + 1 + num_c) * sizeof(uint32_t);
+
+    if (bytes > utils_bytes_left(fptr))
+        return false;
+
+    std::vector<BitArray> conns;
+    std::vector<uint32_t> offs;
+    std::vector<uint32_t> addrs;
+
+    if (dense > 0) {
+        conns.resize(n_d);
+
+        for (uint32_t d = 0; d < n_d; d++) {
+            conns[d].resize(n_i);
+
+            if (std::fread(conns[d].words.data(), sizeof(word_t),
+                           conns[d].num_words(), fptr) != conns[d].num_words())
+                return false;
+        }
+    }
+    else {
+        offs.resize((size_t)n_d + 1);
+        addrs.resize(num_c);
+
+        if (std::fread(offs.data(), sizeof(offs[0]), offs.size(), fptr) !=
+                offs.size() ||
+            std::fread(addrs.data(), sizeof(addrs[0]), addrs.size(), fptr) !=
+                addrs.size())
+            return false;
+
+        // Offsets must split the addresses in order
+        if (offs[0] != 0 || offs[n_d] != num_c)
+            return false;
+
+        for (uint32_t d = 0; d < n_d; d++)
+            if (offs[d] > offs[d + 1])
+                return false;
+
+        for (uint32_t c = 0; c < num_c; c++)
+            if (addrs[c] >= n_i)
+                return false;
+    }
+
+    num_i = n_i;
+    num_d = n_d;
+    dense_flag = dense > 0;
+    d_conns.swap(conns);
+    d_offs.swap(offs);
+    c_addrs.swap(addrs);
+    init_flag = true;
+
+    return true;
+}
+
+// =============================================================================
+// # Memory Usage
+//
+// Returns an estimate of the number of bytes used.
+// =============================================================================
+uint64_t FrozenMemory::memory_usage() {
+
+    uint64_t bytes = 0;
+
+    bytes += sizeof(init_flag);
+    bytes += sizeof(dense_flag);
+    bytes += sizeof(num_i);
+    bytes += sizeof(num_d);
+
+    if (dense_flag && num_d > 0)
+        bytes += (uint64_t)d_conns[0].memory_usage() * num_d;
+    else {
+        bytes += (uint64_t)(d_offs.size() * sizeof(d_offs[0]));
+        bytes += (uint64_t)(c_addrs.size() * sizeof(c_addrs[0]));
+    }
+
+    return bytes;
+}
+
+// =============================================================================
+// # Overlap
+//
+// Returns the number of a dendrite's connections attached to active input
+// bits.  Same result as BlockMemory overlap() on the memory it was frozen from.
+// =============================================================================
+uint32_t FrozenMemory::overlap(const uint32_t d, BitArray& input) {
+
+    assert(init_flag);
+    assert(d < num_d);
+
+    if (dense_flag)
+        return d_conns[d].num_similar(input);
+
+    uint32_t overlap = 0;
+
+    for (uint32_t i = d_offs[d]; i < d_offs[d + 1]; i++)
+        overlap += input.get_bit(c_addrs[i]);
+
+    return overlap;
+}
+
+// =============================================================================
+// # Get Dendrite Addresses
+//
+// Returns the connected addresses of a particular dendrite.
+// =============================================================================
+std::vector<uint32_t> FrozenMemory::addrs(const uint32_t d) {
+
+    assert(init_flag);
+    assert(d < num_d);
+
+    if (dense_flag)
+        return d_conns[d].get_acts();
+
+    return std::vector<uint32_t>(
+        c_addrs.begin() + d_offs[d],
+        c_addrs.begin() + d_offs[d + 1]);
+}
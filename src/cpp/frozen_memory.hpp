@@ -0,0 +1,56 @@
+// =============================================================================
+// frozen_memory.hpp
+// =============================================================================
+#ifndef FROZEN_MEMORY_HPP
+#define FROZEN_MEMORY_HPP
+
+#include "bitarray.hpp"
+#include "block_memory.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace BrainBlocks {
+
+class FrozenMemory {
+
+public:
+
+    // Initializers
+    void init(BlockMemory& memory);
+
+    // Misc. functions
+    void save(FILE* fptr);
+    bool load(FILE* fptr);
+    uint64_t memory_usage();
+
+    // Core functions
+    uint32_t overlap(const uint32_t d, BitArray& input);
+
+    // Getters
+    std::vector<uint32_t> addrs(const uint32_t d);
+    uint32_t num_inputs() { return num_i; };
+    uint32_t num_dendrites() { return num_d; };
+    bool is_dense() { return dense_flag; };
+
+private:
+
+    // Flags
+    bool init_flag = false;
+    bool dense_flag = false;
+
+    // Parameters
+    uint32_t num_i = 0; // number of inputs
+    uint32_t num_d = 0; // number of dendrites
+
+    // Arrays (dense form)
+    std::vector<BitArray> d_conns; // dendrite connections
+
+    // Arrays (sparse form)
+    std::vector<uint32_t> d_offs;  // dendrite offsets into c_addrs
+    std::vector<uint32_t> c_addrs; // sorted connected receptor addresses
+};
+
+} // namespace BrainBlocks
+
+#endif // FROZEN_MEMORY_HPP
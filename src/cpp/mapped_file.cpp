@@ -0,0 +1,109 @@
+// =============================================================================
+// mapped_file.cpp
+// =============================================================================
+#include "mapped_file.hpp"
+#include <cstdio>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace BrainBlocks;
+
+// =============================================================================
+// # MappedFile
+//
+// Read-only view of a file's bytes.  On POSIX systems the file is mapped with
+// mmap so pages are only read from disk when touched and are shared between
+// processes.  On Windows the file is read into memory.
+// =============================================================================
+
+// =============================================================================
+// # Destructor
+//
+// Unmaps the file.
+// =============================================================================
+MappedFile::~MappedFile() {
+
+    close();
+}
+
+// =============================================================================
+// # Open
+//
+// Maps a file.  Returns false if the file can not be opened or is empty.
+// =============================================================================
+bool MappedFile::open(const char* file) {
+
+    close();
+
+#if defined(_WIN32)
+    FILE* fptr;
+
+    if ((fptr = std::fopen(file, "rb")) == NULL)
+        return false;
+
+    std::fseek(fptr, 0, SEEK_END);
+    long n = std::ftell(fptr);
+    std::fseek(fptr, 0, SEEK_SET);
+
+    if (n <= 0) {
+        std::fclose(fptr);
+        return false;
+    }
+
+    buffer.resize((size_t)n);
+    len = std::fread(buffer.data(), 1, buffer.size(), fptr);
+    ptr = buffer.data();
+    std::fclose(fptr);
+#else
+    int fd = ::open(file, O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        addr = nullptr;
+        return false;
+    }
+
+    len = (size_t)st.st_size;
+    ptr = (const uint8_t*)addr;
+#endif
+
+    return true;
+}
+
+// =============================================================================
+// # Close
+//
+// Unmaps the file.
+// =============================================================================
+void MappedFile::close() {
+
+#if defined(_WIN32)
+    buffer.clear();
+    buffer.shrink_to_fit();
+#else
+    if (addr != nullptr)
+        munmap(addr, len);
+
+    addr = nullptr;
+#endif
+
+    ptr = nullptr;
+    len = 0;
+}
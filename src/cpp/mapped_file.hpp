@@ -0,0 +1,46 @@
+// =============================================================================
+// mapped_file.hpp
+// =============================================================================
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace BrainBlocks {
+
+class MappedFile {
+
+public:
+
+    // Constructor and destructor
+    MappedFile() {};
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Open and close
+    bool open(const char* file);
+    void close();
+
+    // Getters
+    const uint8_t* data() { return ptr; };
+    size_t size() { return len; };
+    bool is_open() { return ptr != nullptr; };
+
+private:
+
+    const uint8_t* ptr = nullptr; // mapped bytes
+    size_t len = 0;               // number of mapped bytes
+
+#if defined(_WIN32)
+    std::vector<uint8_t> buffer;  // file contents (no mmap available)
+#else
+    void* addr = nullptr;         // mmap address
+#endif
+};
+
+} // namespace BrainBlocks
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,381 @@
+// =============================================================================
+// overlap_tuner.cpp
+// =============================================================================
+#include "overlap_tuner.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstring> // for memset
+
+#define OVERLAP_TUNER_MAGIC 0x544B4242 // "BBKT"
+#define OVERLAP_TUNER_VERSION 1
+
+using namespace BrainBlocks;
+
+// =============================================================================
+// # OverlapTuner
+//
+// Computes the overlaps of every dendrite of a BlockMemory with one input
+// using one of several kernels, and picks the fastest kernel by timing them
+// on sample inputs.  Which kernel wins depends on the number of inputs and
+// dendrites, the receptors per dendrite, the input density and the CPU:
+//
+//   KERNEL_SCAN: visits every receptor, O(num_d * num_rpd)
+//   KERNEL_CONN: ANDs dense connection masks, O(num_d * num_i / 32), needs
+//                connections (init_pooled_conn), otherwise same as SCAN
+//  KERNEL_INDEX: visits the dendrites connected to each active input bit,
+//                O(active bits * connected dendrites per bit)
+// KERNEL_SLICED: adds one num_d-bit mask per active input bit into bit-sliced
+//                counters, O(active bits * num_d / 32)
+//
+// INDEX and SLICED work from structures derived from the memory, rebuilt in
+// O(num_r) whenever the memory version changes, and report their dendrite
+// accesses through BlockMemory::count_hits().  They suit inference; while
+// learning they are rebuilt every step, which tune() accounts for when
+// learn_flag is set.  CONN, INDEX and SLICED count each connected address
+// once, SCAN counts duplicate receptors on the same address separately.
+//
+// ## Example
+//
+// OverlapTuner tuner;
+//
+// tuner.tune(memory, samples);          (times every kernel on the samples)
+// tuner.overlap_all(memory, input, overlaps);
+//
+// timings: {4.1e-05, 2.3e-05, 6.0e-06, 3.2e-06}  (seconds per input)
+//  kernel: KERNEL_SLICED
+// =============================================================================
+
+// =============================================================================
+// # Save
+//
+// Saves the selected kernel.
+//
+// header: magic, version (uint32)
+// kernel: uint32
+// =============================================================================
+void OverlapTuner::save(FILE* fptr) {
+
+    uint32_t data[3] = {
+        OVERLAP_TUNER_MAGIC, OVERLAP_TUNER_VERSION, (uint32_t)kernel};
+
+    std::fwrite(data, sizeof(data[0]), 3, fptr);
+}
+
+// =============================================================================
+// # Load
+//
+// Loads the selected kernel.  Leaves the kernel and file position unchanged
+// if no saved kernel follows, e.g. in files written before the tuner existed.
+// =============================================================================
+void OverlapTuner::load(FILE* fptr) {
+
+    uint32_t data[3] = {0, 0, 0};
+    long beg = std::ftell(fptr);
+
+    if (std::fread(data, sizeof(data[0]), 3, fptr) != 3 ||
+        data[0] != OVERLAP_TUNER_MAGIC) {
+        std::fseek(fptr, beg, SEEK_SET);
+        return;
+    }
+
+    assert(data[1] == OVERLAP_TUNER_VERSION);
+    set_kernel((uint8_t)data[2]);
+}
+
+// =============================================================================
+// # Clear
+//
+// Frees the derived structures.  They are rebuilt on the next use.
+// =============================================================================
+void OverlapTuner::clear() {
+
+    index_version = 0;
+    sliced_version = 0;
+    std::vector<uint32_t>().swap(i_offs);
+    std::vector<uint32_t>().swap(i_dends);
+    std::vector<word_t>().swap(i_masks);
+    std::vector<word_t>().swap(slices);
+}
+
+// =============================================================================
+// # Memory Usage
+//
+// Returns an estimate of the number of bytes used.
+// =============================================================================
+uint64_t OverlapTuner::memory_usage() {
+
+    uint64_t bytes = 0;
+
+    bytes += sizeof(kernel);
+    bytes += sizeof(timings[0]) * (uint64_t)timings.size();
+    bytes += sizeof(i_offs[0]) * (uint64_t)i_offs.size();
+    bytes += sizeof(i_dends[0]) * (uint64_t)i_dends.size();
+    bytes += sizeof(i_masks[0]) * (uint64_t)i_masks.size();
+    bytes += sizeof(slices[0]) * (uint64_t)slices.size();
+    bytes += sizeof(acts[0]) * (uint64_t)acts.size();
+
+    return bytes;
+}
+
+// =============================================================================
+// # Overlap All
+//
+// Computes the overlap of every dendrite with the input using the selected
+// kernel (see set_kernel and tune).
+// =============================================================================
+void OverlapTuner::overlap_all(
+        BlockMemory& memory,
+        BitArray& input,
+        std::vector<uint32_t>& overlaps) {
+
+    overlap_all(memory, kernel, input, overlaps);
+}
+
+// =============================================================================
+// # Overlap All (Kernel)
+//
+// Computes the overlap of every dendrite with the input using a particular
+// kernel.
+// =============================================================================
+void OverlapTuner::overlap_all(
+        BlockMemory& memory,
+        const uint8_t kernel,
+        BitArray& input,
+        std::vector<uint32_t>& overlaps) {
+
+    assert(kernel < NUM_KERNELS);
+    assert(input.num_bits() == memory.num_inputs());
+
+    uint32_t num_d = memory.num_dendrites();
+    overlaps.resize(num_d);
+
+    if (kernel == KERNEL_SCAN) {
+        for (uint32_t d = 0; d < num_d; d++)
+            overlaps[d] = memory.overlap(d, input);
+        return;
+    }
+
+    if (kernel == KERNEL_CONN) {
+        for (uint32_t d = 0; d < num_d; d++)
+            overlaps[d] = memory.overlap_conn(d, input);
+        return;
+    }
+
+    build(memory, kernel);
+    memory.count_hits();
+    acts = input.get_acts();
+
+    // Count connected dendrites of each active input bit
+    if (kernel == KERNEL_INDEX) {
+        std::fill(overlaps.begin(), overlaps.end(), 0);
+
+        for (uint32_t k = 0; k < acts.size(); k++) {
+            uint32_t i = acts[k];
+
+            for (uint32_t j = i_offs[i]; j < i_offs[i + 1]; j++)
+                overlaps[i_dends[j]]++;
+        }
+
+        return;
+    }
+
+    // Add each active input bit's dendrite mask into the counters, a word of
+    // dendrites at a time: slice b holds bit b of every dendrite's count
+    memset(slices.data(), 0, slices.size() * sizeof(slices[0]));
+
+    for (uint32_t k = 0; k < acts.size(); k++) {
+        const word_t* mask = &i_masks[(size_t)acts[k] * num_dw];
+
+        for (uint32_t w = 0; w < num_dw; w++) {
+            word_t carry = mask[w];
+
+            for (uint32_t b = 0; carry; b++) {
+                word_t& slice = slices[(size_t)b * num_dw + w];
+                word_t next = slice & carry;
+                slice ^= carry;
+                carry = next;
+            }
+        }
+    }
+
+    // Gather the counts from the slices
+    std::fill(overlaps.begin(), overlaps.end(), 0);
+
+    for (uint32_t b = 0; b < num_sl; b++) {
+        for (uint32_t w = 0; w < num_dw; w++) {
+            word_t word = slices[(size_t)b * num_dw + w];
+
+            while (word) {
+                overlaps[w * WBITS + trailing_zeros(word)] |= 1 << b;
+                word &= word - 1;
+            }
+        }
+    }
+}
+
+// =============================================================================
+// # Tune
+//
+// Times every kernel on the inputs, selects the fastest and returns it.  With
+// learn_flag the derived structures are rebuilt before every input, as they
+// would be when the memory learns every step.  Timings (seconds per input,
+// best of 3 runs) are kept for get_timings().
+// =============================================================================
+uint8_t OverlapTuner::tune(
+        BlockMemory& memory,
+        std::vector<BitArray>& inputs,
+        const bool learn_flag) {
+
+    assert(inputs.size() > 0);
+
+    std::vector<uint32_t> overlaps;
+    timings.assign(NUM_KERNELS, 0.0);
+
+    for (uint8_t k = 0; k < NUM_KERNELS; k++) {
+        double best = 0.0;
+
+        for (uint32_t r = 0; r < 3; r++) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+
+            for (uint32_t t = 0; t < inputs.size(); t++) {
+                if (learn_flag) {
+                    index_version = 0;
+                    sliced_version = 0;
+                }
+
+                overlap_all(memory, k, inputs[t], overlaps);
+            }
+
+            auto t1 = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> duration = t1 - t0;
+
+            if (r == 0 || duration.count() < best)
+                best = duration.count();
+        }
+
+        timings[k] = best / inputs.size();
+    }
+
+    kernel = KERNEL_SCAN;
+
+    for (uint8_t k = 1; k < NUM_KERNELS; k++)
+        if (timings[k] < timings[kernel])
+            kernel = k;
+
+    // Keep only the structures of the selected kernel
+    if (kernel != KERNEL_INDEX) {
+        std::vector<uint32_t>().swap(i_offs);
+        std::vector<uint32_t>().swap(i_dends);
+        index_version = 0;
+    }
+
+    if (kernel != KERNEL_SLICED) {
+        std::vector<word_t>().swap(i_masks);
+        std::vector<word_t>().swap(slices);
+        sliced_version = 0;
+    }
+
+    return kernel;
+}
+
+// =============================================================================
+// # Set Kernel
+//
+// Selects the kernel used by overlap_all().
+// =============================================================================
+void OverlapTuner::set_kernel(const uint8_t kernel) {
+
+    assert(kernel < NUM_KERNELS);
+
+    this->kernel = kernel;
+}
+
+// =============================================================================
+// # Build
+//
+// Rebuilds a kernel's derived structures if the memory changed.
+// =============================================================================
+void OverlapTuner::build(BlockMemory& memory, const uint8_t kernel) {
+
+    if (kernel == KERNEL_INDEX && index_version != memory.version()) {
+        build_index(memory);
+        index_version = memory.version();
+    }
+
+    if (kernel == KERNEL_SLICED && sliced_version != memory.version()) {
+        build_sliced(memory);
+        sliced_version = memory.version();
+    }
+}
+
+// =============================================================================
+// # Build Index
+//
+// Lists the dendrites connected to each input bit.
+//
+// ## Example
+//
+// d0 conns: {1 4}   d1 conns: {0 4}   d2 conns: {4}
+//
+//  i_offs: {0 1 2 2 2 5}
+// i_dends: {1 0 0 1 2}
+// =============================================================================
+void OverlapTuner::build_index(BlockMemory& memory) {
+
+    uint32_t num_i = memory.num_inputs();
+    uint32_t num_d = memory.num_dendrites();
+    std::vector<std::vector<uint32_t>> conns(num_d);
+
+    i_offs.assign(num_i + 1, 0);
+
+    for (uint32_t d = 0; d < num_d; d++) {
+        conns[d] = memory.conn_addrs(d);
+
+        for (uint32_t j = 0; j < conns[d].size(); j++)
+            i_offs[conns[d][j] + 1]++;
+    }
+
+    for (uint32_t i = 0; i < num_i; i++)
+        i_offs[i + 1] += i_offs[i];
+
+    std::vector<uint32_t> next(i_offs.begin(), i_offs.end() - 1);
+    i_dends.resize(i_offs[num_i]);
+
+    for (uint32_t d = 0; d < num_d; d++)
+        for (uint32_t j = 0; j < conns[d].size(); j++)
+            i_dends[next[conns[d][j]]++] = d;
+}
+
+// =============================================================================
+// # Build Sliced
+//
+// Builds a num_d-bit mask of connected dendrites for each input bit and sizes
+// the counter slices for the most connected dendrite.
+// =============================================================================
+void OverlapTuner::build_sliced(BlockMemory& memory) {
+
+    uint32_t num_i = memory.num_inputs();
+    uint32_t num_d = memory.num_dendrites();
+    uint32_t max_conns = 0;
+
+    num_dw = (num_d + WBITS - 1) / WBITS;
+    i_masks.assign((size_t)num_i * num_dw, 0);
+
+    for (uint32_t d = 0; d < num_d; d++) {
+        std::vector<uint32_t> conns = memory.conn_addrs(d);
+
+        for (uint32_t j = 0; j < conns.size(); j++)
+            i_masks[(size_t)conns[j] * num_dw + get_wrd(d)] |=
+                (word_t)1 << get_idx(d);
+
+        if (conns.size() > max_conns)
+            max_conns = (uint32_t)conns.size();
+    }
+
+    num_sl = 0;
+
+    while ((max_conns >> num_sl) > 0)
+        num_sl++;
+
+    slices.assign((size_t)num_sl * num_dw, 0);
+}
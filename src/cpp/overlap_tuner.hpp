@@ -0,0 +1,80 @@
+// =============================================================================
+// overlap_tuner.hpp
+// =============================================================================
+#ifndef OVERLAP_TUNER_HPP
+#define OVERLAP_TUNER_HPP
+
+#include "bitarray.hpp"
+#include "block_memory.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Overlap kernels (see OverlapTuner)
+#define KERNEL_SCAN 0   // receptor scan (BlockMemory::overlap)
+#define KERNEL_CONN 1   // dense connection masks (BlockMemory::overlap_conn)
+#define KERNEL_INDEX 2  // inverted index from input bits to dendrites
+#define KERNEL_SLICED 3 // bit-sliced vertical counters over dendrites
+#define NUM_KERNELS 4
+
+namespace BrainBlocks {
+
+class OverlapTuner {
+
+public:
+
+    // Misc. functions
+    void save(FILE* fptr);
+    void load(FILE* fptr);
+    void clear();
+    uint64_t memory_usage();
+
+    // Core functions
+    void overlap_all(
+        BlockMemory& memory,
+        BitArray& input,
+        std::vector<uint32_t>& overlaps);
+
+    void overlap_all(
+        BlockMemory& memory,
+        const uint8_t kernel,
+        BitArray& input,
+        std::vector<uint32_t>& overlaps);
+
+    uint8_t tune(
+        BlockMemory& memory,
+        std::vector<BitArray>& inputs,
+        const bool learn_flag=false);
+
+    // Setters and getters
+    void set_kernel(const uint8_t kernel);
+    uint8_t get_kernel() { return kernel; };
+    const std::vector<double>& get_timings() { return timings; };
+
+private:
+
+    void build(BlockMemory& memory, const uint8_t kernel);
+    void build_index(BlockMemory& memory);
+    void build_sliced(BlockMemory& memory);
+
+    uint8_t kernel = KERNEL_CONN; // selected kernel
+    std::vector<double> timings;  // seconds per input of each kernel (tune)
+
+    // Inverted index (KERNEL_INDEX)
+    uint64_t index_version = 0;      // BlockMemory version of the index
+    std::vector<uint32_t> i_offs;    // input bit offsets into i_dends
+    std::vector<uint32_t> i_dends;   // dendrites connected to each input bit
+
+    // Bit-sliced counters (KERNEL_SLICED)
+    uint64_t sliced_version = 0;     // BlockMemory version of the masks
+    uint32_t num_dw = 0;             // words per dendrite mask
+    uint32_t num_sl = 0;             // number of counter slices
+    std::vector<word_t> i_masks;     // dendrites connected to each input bit
+    std::vector<word_t> slices;      // counter bit b of every dendrite
+
+    std::vector<uint32_t> acts;      // scratch active input bits
+};
+
+} // namespace BrainBlocks
+
+#endif // OVERLAP_TUNER_HPP
@@ -0,0 +1,91 @@
+// =============================================================================
+// parallel_fit.cpp
+// =============================================================================
+#include "parallel_fit.hpp"
+#include <cassert>
+#include <thread>
+
+using namespace BrainBlocks;
+
+// =============================================================================
+// # Parallel Fit
+//
+// Data-parallel training loop shared by the blocks' fit_parallel functions.
+// The samples are split into one contiguous shard per replica.  Each round
+// copies the memory into every replica, trains each replica on its next
+// merge_every samples in its own thread, then merges the replicas back into
+// the memory.  Smaller merge_every values stay closer to sequential training
+// at the cost of more merges.
+//
+// ## Example
+//
+// num_samples: 10, replicas: 2, merge_every: 3
+//
+// shard 0: {0, 1, 2, 3, 4}
+// shard 1: {5, 6, 7, 8, 9}
+//
+// round 0: r0 trains {0, 1, 2}, r1 trains {5, 6, 7}, merge
+// round 1: r0 trains {3, 4},    r1 trains {8, 9},    merge
+// =============================================================================
+void BrainBlocks::parallel_fit(
+        BlockMemory& memory,
+        std::vector<BlockMemory*>& replicas,
+        const uint32_t num_samples,
+        const uint32_t num_epochs,
+        const uint32_t merge_every,
+        const uint8_t merge_mode,
+        fit_fn train) {
+
+    assert(replicas.size() > 0);
+    assert(merge_every > 0);
+
+    uint32_t num_r = (uint32_t)replicas.size();
+    std::vector<uint32_t> begs(num_r);
+    std::vector<uint32_t> ends(num_r);
+    std::vector<BlockMemory*> active;
+    std::vector<std::thread> threads;
+
+    // Setup shards
+    for (uint32_t r = 0; r < num_r; r++) {
+        begs[r] = (uint32_t)((uint64_t)num_samples * r / num_r);
+        ends[r] = (uint32_t)((uint64_t)num_samples * (r + 1) / num_r);
+    }
+
+    for (uint32_t e = 0; e < num_epochs; e++) {
+        for (uint32_t beg = 0; ; beg += merge_every) {
+            active.clear();
+
+            // Broadcast memory and train each replica on its next samples
+            for (uint32_t r = 0; r < num_r; r++) {
+                uint32_t i_beg = begs[r] + beg;
+
+                if (i_beg >= ends[r])
+                    continue;
+
+                uint32_t i_end = i_beg + merge_every;
+
+                if (i_end > ends[r])
+                    i_end = ends[r];
+
+                *replicas[r] = memory;
+                active.push_back(replicas[r]);
+
+                threads.emplace_back([&train, r, i_beg, i_end]() {
+                    for (uint32_t i = i_beg; i < i_end; i++)
+                        train(r, i);
+                });
+            }
+
+            if (active.empty())
+                break;
+
+            for (uint32_t t = 0; t < threads.size(); t++)
+                threads[t].join();
+
+            threads.clear();
+
+            // Merge replicas that trained this round back into memory
+            memory.merge(active, merge_mode);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+// =============================================================================
+// parallel_fit.hpp
+// =============================================================================
+#ifndef PARALLEL_FIT_HPP
+#define PARALLEL_FIT_HPP
+
+#include "block_memory.hpp"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace BrainBlocks {
+
+// Trains replica r on sample i
+typedef std::function<void(const uint32_t r, const uint32_t i)> fit_fn;
+
+void parallel_fit(
+    BlockMemory& memory,
+    std::vector<BlockMemory*>& replicas,
+    const uint32_t num_samples,
+    const uint32_t num_epochs,
+    const uint32_t merge_every,
+    const uint8_t merge_mode,
+    fit_fn train);
+
+} // namespace BrainBlocks
+
+#endif // PARALLEL_FIT_HPP
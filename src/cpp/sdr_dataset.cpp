@@ -0,0 +1,409 @@
+// =============================================================================
+// sdr_dataset.cpp
+// =============================================================================
+#include "sdr_dataset.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace BrainBlocks;
+
+#define SDR_DATASET_MAGIC 0x44534242 // "BBSD"
+#define SDR_DATASET_VERSION 1
+#define SDR_DATASET_HEADER 8
+
+// =============================================================================
+// # SDR Dataset
+//
+// Binary file of packed SDR rows so encoded training data can be written once
+// and streamed back without re-encoding.  Every row has the same number of
+// words.  Labels and timestamps are optional columns stored after the rows.
+//
+// ## Layout
+//
+// header: magic, version, word bytes, num_b, num_w, num_r, flags, 0 (uint32)
+//   rows: num_r * num_w words
+// labels: num_r uint32 (if SDR_LABELS)
+//    pad: zeros up to a multiple of 8 bytes
+//  times: num_r int64 (if SDR_TIMESTAMPS)
+// =============================================================================
+
+// =============================================================================
+// # Writer Destructor
+//
+// Finishes the file if it is still open.
+// =============================================================================
+SDRDatasetWriter::~SDRDatasetWriter() {
+
+    close();
+}
+
+// =============================================================================
+// # Writer Open
+//
+// Creates a dataset file for rows of num_b bits.  Returns false if the file
+// can not be opened.
+// =============================================================================
+bool SDRDatasetWriter::open(
+        const char* file,
+        const uint32_t num_b,
+        const uint32_t flags) {
+
+    assert(num_b > 0);
+
+    close();
+
+    if ((fptr = std::fopen(file, "wb")) == NULL)
+        return false;
+
+    this->num_b = num_b;
+    this->flags = flags;
+    num_w = (num_b + WBITS - 1) / WBITS;
+    num_r = 0;
+    labels.clear();
+    times.clear();
+
+    // Header is rewritten with the row count on close
+    uint32_t header[SDR_DATASET_HEADER] = {
+        SDR_DATASET_MAGIC, SDR_DATASET_VERSION, (uint32_t)WBYTES,
+        num_b, num_w, 0, flags, 0};
+
+    std::fwrite(header, sizeof(uint32_t), SDR_DATASET_HEADER, fptr);
+
+    return true;
+}
+
+// =============================================================================
+// # Writer Close
+//
+// Writes the label and timestamp columns and the final row count.  Returns
+// false if no file was open.
+// =============================================================================
+bool SDRDatasetWriter::close() {
+
+    if (fptr == NULL)
+        return false;
+
+    size_t bytes = SDR_DATASET_HEADER * sizeof(uint32_t) +
+                   (size_t)num_r * num_w * WBYTES;
+
+    if (flags & SDR_LABELS) {
+        std::fwrite(labels.data(), sizeof(uint32_t), labels.size(), fptr);
+        bytes += labels.size() * sizeof(uint32_t);
+    }
+
+    if (flags & SDR_TIMESTAMPS) {
+        uint8_t pad[8] = {0};
+        std::fwrite(pad, 1, (8 - bytes % 8) % 8, fptr);
+        std::fwrite(times.data(), sizeof(int64_t), times.size(), fptr);
+    }
+
+    std::fseek(fptr, 5 * sizeof(uint32_t), SEEK_SET);
+    std::fwrite(&num_r, sizeof(uint32_t), 1, fptr);
+    std::fclose(fptr);
+    fptr = NULL;
+
+    return true;
+}
+
+// =============================================================================
+// # Writer Add
+//
+// Appends a row.  The label and timestamp are kept only if the file has those
+// columns.
+// =============================================================================
+void SDRDatasetWriter::add(
+        BitArray& ba,
+        const uint32_t label,
+        const int64_t time) {
+
+    assert(fptr != NULL);
+    assert(ba.num_bits() == num_b);
+
+    std::fwrite(ba.words.data(), sizeof(word_t), num_w, fptr);
+
+    if (flags & SDR_LABELS)
+        labels.push_back(label);
+
+    if (flags & SDR_TIMESTAMPS)
+        times.push_back(time);
+
+    num_r++;
+}
+
+// =============================================================================
+// # Open
+//
+// Maps a dataset file read-only.  Returns false if the file can not be read or
+// is not a dataset file.
+// =============================================================================
+bool SDRDataset::open(const char* file) {
+
+    close();
+
+    if (!this->file.open(file))
+        return false;
+
+    const uint8_t* data = this->file.data();
+    size_t len = this->file.size();
+    const uint32_t* header = (const uint32_t*)data;
+
+    if (len < SDR_DATASET_HEADER * sizeof(uint32_t) ||
+        header[0] != SDR_DATASET_MAGIC ||
+        header[1] != SDR_DATASET_VERSION ||
+        header[2] != (uint32_t)WBYTES) {
+        close();
+        return false;
+    }
+
+    num_b = header[3];
+    num_w = header[4];
+    num_r = header[5];
+    flags = header[6];
+
+    // Locate columns
+    size_t bytes = SDR_DATASET_HEADER * sizeof(uint32_t) +
+                   (size_t)num_r * num_w * WBYTES;
+    rows = (const word_t*)(data + SDR_DATASET_HEADER * sizeof(uint32_t));
+
+    if (flags & SDR_LABELS) {
+        labels = (const uint32_t*)(data + bytes);
+        bytes += (size_t)num_r * sizeof(uint32_t);
+    }
+
+    if (flags & SDR_TIMESTAMPS) {
+        bytes += (8 - bytes % 8) % 8;
+        times = (const int64_t*)(data + bytes);
+        bytes += (size_t)num_r * sizeof(int64_t);
+    }
+
+    if (num_w != (num_b + WBITS - 1) / WBITS || len < bytes) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+// =============================================================================
+// # Close
+//
+// Unmaps the dataset file.
+// =============================================================================
+void SDRDataset::close() {
+
+    file.close();
+    num_b = 0;
+    num_w = 0;
+    num_r = 0;
+    flags = 0;
+    rows = nullptr;
+    labels = nullptr;
+    times = nullptr;
+}
+
+// =============================================================================
+// # Row
+//
+// Returns a pointer to the num_words() packed words of a row inside the
+// mapped file.  No data is copied.
+// =============================================================================
+const word_t* SDRDataset::row(const uint32_t r) {
+
+    assert(r < num_r);
+
+    return rows + (size_t)r * num_w;
+}
+
+// =============================================================================
+// # Get Row
+//
+// Copies a row into a BitArray of num_bits() bits.
+// =============================================================================
+void SDRDataset::get_row(const uint32_t r, BitArray& ba) {
+
+    assert(r < num_r);
+    assert(ba.num_bits() == num_b);
+
+    std::memcpy(ba.words.data(), row(r), num_w * sizeof(word_t));
+}
+
+// =============================================================================
+// # Label
+//
+// Returns the label of a row, or 0 if the dataset has no labels.
+// =============================================================================
+uint32_t SDRDataset::label(const uint32_t r) {
+
+    assert(r < num_r);
+
+    return labels ? labels[r] : 0;
+}
+
+// =============================================================================
+// # Timestamp
+//
+// Returns the timestamp of a row, or 0 if the dataset has no timestamps.
+// =============================================================================
+int64_t SDRDataset::timestamp(const uint32_t r) {
+
+    assert(r < num_r);
+
+    return times ? times[r] : 0;
+}
+
+// =============================================================================
+// # Loader Constructor
+//
+// Constructs an epoch loader over an open dataset.  Batches are gathered in
+// shuffled (or file) order by a prefetch thread while the caller trains on
+// the previous batch.
+//
+// ## Example
+//
+// SDRLoader loader(data, 1024);
+//
+// for (uint32_t e = 0; e < num_epochs; e++) {
+//     loader.start_epoch();
+//
+//     while (loader.next(rows, labels))
+//         pc.fit_parallel(rows, labels, num_threads);
+// }
+// =============================================================================
+SDRLoader::SDRLoader(
+    SDRDataset& data,          // open dataset
+    const uint32_t batch_size, // rows per batch
+    const bool shuffle,        // shuffle rows each epoch (optional)
+    const uint32_t seed)       // seed for random number generator (optional)
+: data(data), rng(seed) {
+
+    assert(batch_size > 0);
+
+    this->batch_size = batch_size;
+    this->shuffle = shuffle;
+
+    order.resize(data.num_rows());
+
+    for (uint32_t r = 0; r < order.size(); r++)
+        order[r] = r;
+}
+
+// =============================================================================
+// # Loader Destructor
+//
+// Stops the prefetch thread.
+// =============================================================================
+SDRLoader::~SDRLoader() {
+
+    stop();
+}
+
+// =============================================================================
+// # Start Epoch
+//
+// Discards any unread batches, reshuffles the row order, and starts
+// prefetching the new epoch.
+// =============================================================================
+void SDRLoader::start_epoch() {
+
+    stop();
+
+    if (shuffle)
+        utils_shuffle(order, (uint32_t)order.size(), rng);
+
+    ready.clear();
+    stop_flag = false;
+    done_flag = false;
+    worker = std::thread(&SDRLoader::produce, this);
+}
+
+// =============================================================================
+// # Next
+//
+// Moves the next batch into rows and labels.  Returns false once the epoch is
+// finished.
+// =============================================================================
+bool SDRLoader::next(
+        std::vector<BitArray>& rows,
+        std::vector<uint32_t>& labels) {
+
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this]() { return !ready.empty() || done_flag; });
+
+    if (ready.empty())
+        return false;
+
+    rows.swap(ready.front().rows);
+    labels.swap(ready.front().labels);
+    ready.pop_front();
+    cv.notify_all();
+
+    return true;
+}
+
+// =============================================================================
+// # Number of Batches
+//
+// Returns the number of batches per epoch.
+// =============================================================================
+uint32_t SDRLoader::num_batches() {
+
+    return (data.num_rows() + batch_size - 1) / batch_size;
+}
+
+// =============================================================================
+// # Stop
+//
+// Signals the prefetch thread to finish and waits for it.
+// =============================================================================
+void SDRLoader::stop() {
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop_flag = true;
+    }
+
+    cv.notify_all();
+
+    if (worker.joinable())
+        worker.join();
+}
+
+// =============================================================================
+// # Produce
+//
+// Prefetch thread body.  Gathers batches of rows in epoch order, keeping at
+// most max_ready batches ahead of the caller.
+// =============================================================================
+void SDRLoader::produce() {
+
+    uint32_t num_r = data.num_rows();
+
+    for (uint32_t beg = 0; beg < num_r; beg += batch_size) {
+        uint32_t end = std::min(beg + batch_size, num_r);
+        Batch batch;
+
+        batch.rows.resize(end - beg, BitArray(data.num_bits()));
+        batch.labels.resize(end - beg);
+
+        for (uint32_t i = beg; i < end; i++) {
+            data.get_row(order[i], batch.rows[i - beg]);
+            batch.labels[i - beg] = data.label(order[i]);
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this]() {
+            return ready.size() < max_ready || stop_flag; });
+
+        if (stop_flag)
+            return;
+
+        ready.push_back(std::move(batch));
+        cv.notify_all();
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    done_flag = true;
+    cv.notify_all();
+}
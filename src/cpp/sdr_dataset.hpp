@@ -0,0 +1,143 @@
+// =============================================================================
+// sdr_dataset.hpp
+// =============================================================================
+#ifndef SDR_DATASET_HPP
+#define SDR_DATASET_HPP
+
+#include "bitarray.hpp"
+#include "mapped_file.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Optional per-row columns
+#define SDR_LABELS 1     // uint32 label per row
+#define SDR_TIMESTAMPS 2 // int64 timestamp per row
+
+namespace BrainBlocks {
+
+class SDRDatasetWriter {
+
+public:
+
+    // Constructor and destructor
+    SDRDatasetWriter() {};
+    ~SDRDatasetWriter();
+    SDRDatasetWriter(const SDRDatasetWriter&) = delete;
+    SDRDatasetWriter& operator=(const SDRDatasetWriter&) = delete;
+
+    // Open and close
+    bool open(const char* file, const uint32_t num_b, const uint32_t flags);
+    bool close();
+
+    // Core functions
+    void add(BitArray& ba, const uint32_t label=0, const int64_t time=0);
+
+    // Getters
+    uint32_t num_rows() { return num_r; };
+
+private:
+
+    FILE* fptr = NULL;
+    uint32_t num_b = 0; // number of bits per row
+    uint32_t num_w = 0; // number of words per row
+    uint32_t num_r = 0; // number of rows
+    uint32_t flags = 0; // optional columns
+    std::vector<uint32_t> labels;
+    std::vector<int64_t> times;
+};
+
+class SDRDataset {
+
+public:
+
+    // Constructor
+    SDRDataset() {};
+    SDRDataset(const SDRDataset&) = delete;
+    SDRDataset& operator=(const SDRDataset&) = delete;
+
+    // Open and close
+    bool open(const char* file);
+    void close();
+
+    // Row access
+    const word_t* row(const uint32_t r);
+    void get_row(const uint32_t r, BitArray& ba);
+    uint32_t label(const uint32_t r);
+    int64_t timestamp(const uint32_t r);
+
+    // Getters
+    uint32_t num_bits() { return num_b; };
+    uint32_t num_words() { return num_w; };
+    uint32_t num_rows() { return num_r; };
+    bool has_labels() { return (flags & SDR_LABELS) != 0; };
+    bool has_timestamps() { return (flags & SDR_TIMESTAMPS) != 0; };
+
+private:
+
+    MappedFile file;
+    uint32_t num_b = 0; // number of bits per row
+    uint32_t num_w = 0; // number of words per row
+    uint32_t num_r = 0; // number of rows
+    uint32_t flags = 0; // optional columns
+    const word_t* rows = nullptr;
+    const uint32_t* labels = nullptr;
+    const int64_t* times = nullptr;
+};
+
+class SDRLoader {
+
+public:
+
+    // Constructor and destructor
+    SDRLoader(
+        SDRDataset& data,
+        const uint32_t batch_size,
+        const bool shuffle=true,
+        const uint32_t seed=0);
+
+    ~SDRLoader();
+    SDRLoader(const SDRLoader&) = delete;
+    SDRLoader& operator=(const SDRLoader&) = delete;
+
+    // Core functions
+    void start_epoch();
+    bool next(std::vector<BitArray>& rows, std::vector<uint32_t>& labels);
+
+    // Getters
+    uint32_t num_batches();
+
+private:
+
+    struct Batch {
+        std::vector<BitArray> rows;
+        std::vector<uint32_t> labels;
+    };
+
+    void stop();
+    void produce();
+
+    SDRDataset& data;
+    uint32_t batch_size;
+    bool shuffle;
+    std::mt19937 rng;
+    std::vector<uint32_t> order; // row order of the current epoch
+
+    // Prefetch thread
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Batch> ready;   // prefetched batches
+    uint32_t max_ready = 2;    // number of batches to prefetch
+    bool stop_flag = false;
+    bool done_flag = true;
+};
+
+} // namespace BrainBlocks
+
+#endif // SDR_DATASET_HPP
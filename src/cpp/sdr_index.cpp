@@ -0,0 +1,465 @@
+// =============================================================================
+// sdr_index.cpp
+// =============================================================================
+#include "sdr_index.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+using namespace BrainBlocks;
+
+#define SDR_INDEX_MAGIC 0x58494242 // "BBIX"
+#define SDR_INDEX_VERSION 1
+#define SDR_INDEX_HEADER 7
+
+// =============================================================================
+// # SDRIndex
+//
+// SDRIndex is a library of reference BitArrays searchable by similarity.  Each
+// entry keeps its words for brute-force scoring and every active bit keeps a
+// posting list of the entries that contain it.  A query walks the posting
+// lists of its own active bits, so the work is proportional to the total
+// overlap rather than to num_entries * num_words.  When the posting lists are
+// longer than a word scan, e.g. dense queries against a small library, the
+// words are scanned instead.
+//
+// An index can be saved to a file and mapped back read-only, so large
+// libraries are shared between processes and only touched pages are read.
+// =============================================================================
+
+// =============================================================================
+// # Initialize
+//
+// Sets the number of bits per entry and removes all entries.
+// =============================================================================
+void SDRIndex::init(const uint32_t num_b) {
+
+    assert(num_b > 0);
+
+    clear();
+    this->num_b = num_b;
+    num_w = (num_b + WBITS - 1) / WBITS;
+    plists.resize(num_b);
+}
+
+// =============================================================================
+// # Clear
+//
+// Removes all entries and unmaps any mapped file.
+// =============================================================================
+void SDRIndex::clear() {
+
+    file.close();
+    map_flag = false;
+    num_e = 0;
+    ids.clear();
+    sizes.clear();
+    rows.clear();
+    plists.assign(num_b, std::vector<uint32_t>());
+    m_ids = nullptr;
+    m_sizes = nullptr;
+    m_rows = nullptr;
+    m_poffs = nullptr;
+    m_pdata = nullptr;
+    counts.clear();
+    touched.clear();
+}
+
+// =============================================================================
+// # Save
+//
+// Writes the index to a file.  Posting lists are flattened so the file can be
+// mapped without any fix-ups.  Returns false if the file can not be opened.
+//
+// ## Layout (all fields are uint32)
+//
+// magic, version, word bytes, num_b, num_w, num_e, num_p
+// ids[num_e]
+// sizes[num_e]
+// rows[num_e * num_w]
+// posting offsets[num_b + 1]
+// posting entries[num_p]
+// =============================================================================
+bool SDRIndex::save(const char* file) {
+
+    FILE* fptr;
+
+    if ((fptr = std::fopen(file, "wb")) == NULL)
+        return false;
+
+    std::vector<uint32_t> poffs(num_b + 1);
+    uint32_t num_p = 0;
+
+    for (uint32_t b = 0; b < num_b; b++) {
+        uint32_t len;
+        postings(b, &len);
+        poffs[b] = num_p;
+        num_p += len;
+    }
+
+    poffs[num_b] = num_p;
+
+    uint32_t header[SDR_INDEX_HEADER] = {
+        SDR_INDEX_MAGIC, SDR_INDEX_VERSION, (uint32_t)WBYTES,
+        num_b, num_w, num_e, num_p};
+
+    const uint32_t* ids_ptr = map_flag ? m_ids : ids.data();
+    const uint32_t* sizes_ptr = map_flag ? m_sizes : sizes.data();
+    const word_t* rows_ptr = map_flag ? m_rows : rows.data();
+
+    std::fwrite(header, sizeof(uint32_t), SDR_INDEX_HEADER, fptr);
+
+    // Empty arrays may have null data pointers, which fwrite must not get
+    if (num_e > 0) {
+        std::fwrite(ids_ptr, sizeof(uint32_t), num_e, fptr);
+        std::fwrite(sizes_ptr, sizeof(uint32_t), num_e, fptr);
+        std::fwrite(rows_ptr, sizeof(word_t), (size_t)num_e * num_w, fptr);
+    }
+
+    std::fwrite(poffs.data(), sizeof(uint32_t), poffs.size(), fptr);
+
+    for (uint32_t b = 0; b < num_b; b++) {
+        uint32_t len;
+        const uint32_t* p = postings(b, &len);
+
+        if (len > 0)
+            std::fwrite(p, sizeof(uint32_t), len, fptr);
+    }
+
+    std::fclose(fptr);
+    return true;
+}
+
+// =============================================================================
+// # Load
+//
+// Reads an index file into memory.  The loaded index accepts new entries.
+// Returns false if the file can not be read or is not an index file.
+// =============================================================================
+bool SDRIndex::load(const char* file) {
+
+    MappedFile mf;
+
+    if (!mf.open(file))
+        return false;
+
+    return read(mf.data(), mf.size(), true);
+}
+
+// =============================================================================
+// # Map
+//
+// Maps an index file read-only.  Entries are queried in place and no inserts
+// are allowed.  Returns false if the file can not be read or is not an index
+// file.
+// =============================================================================
+bool SDRIndex::map(const char* file) {
+
+    clear();
+
+    if (!this->file.open(file))
+        return false;
+
+    if (!read(this->file.data(), this->file.size(), false)) {
+        this->file.close();
+        return false;
+    }
+
+    return true;
+}
+
+// =============================================================================
+// # Read
+//
+// Parses index file bytes.  Either copies the arrays into owned storage or
+// points into the bytes.  Returns false if the posting offsets do not run
+// from 0 to the number of postings without decreasing, or, when copying, if a
+// posting names an entry the index does not have.  Mapped postings are left
+// unread here and bounds checked as queries walk them.
+// =============================================================================
+bool SDRIndex::read(const uint8_t* data, const size_t len, const bool copy) {
+
+    if (len < SDR_INDEX_HEADER * sizeof(uint32_t))
+        return false;
+
+    const uint32_t* header = (const uint32_t*)data;
+
+    if (header[0] != SDR_INDEX_MAGIC ||
+        header[1] != SDR_INDEX_VERSION ||
+        header[2] != (uint32_t)WBYTES)
+        return false;
+
+    uint32_t nb = header[3];
+    uint32_t nw = header[4];
+    uint32_t ne = header[5];
+    uint32_t np = header[6];
+
+    size_t expected = sizeof(uint32_t) * (SDR_INDEX_HEADER + 2 * (size_t)ne +
+        (size_t)nb + 1 + np) + sizeof(word_t) * (size_t)ne * nw;
+
+    if (nb == 0 || nw != (nb + WBITS - 1) / WBITS || len < expected)
+        return false;
+
+    const uint32_t* ids_ptr = header + SDR_INDEX_HEADER;
+    const uint32_t* sizes_ptr = ids_ptr + ne;
+    const word_t* rows_ptr = (const word_t*)(sizes_ptr + ne);
+    const uint32_t* poffs_ptr = (const uint32_t*)(rows_ptr + (size_t)ne * nw);
+    const uint32_t* pdata_ptr = poffs_ptr + nb + 1;
+
+    if (poffs_ptr[0] != 0 || poffs_ptr[nb] != np)
+        return false;
+
+    for (uint32_t b = 0; b < nb; b++)
+        if (poffs_ptr[b] > poffs_ptr[b + 1])
+            return false;
+
+    if (copy)
+        for (uint32_t j = 0; j < np; j++)
+            if (pdata_ptr[j] >= ne)
+                return false;
+
+    if (copy) {
+        init(nb);
+        num_e = ne;
+        ids.assign(ids_ptr, ids_ptr + ne);
+        sizes.assign(sizes_ptr, sizes_ptr + ne);
+        rows.assign(rows_ptr, rows_ptr + (size_t)ne * nw);
+
+        for (uint32_t b = 0; b < nb; b++)
+            plists[b].assign(pdata_ptr + poffs_ptr[b],
+                             pdata_ptr + poffs_ptr[b + 1]);
+    }
+    else {
+        num_b = nb;
+        num_w = nw;
+        num_e = ne;
+        plists.clear();
+        m_ids = ids_ptr;
+        m_sizes = sizes_ptr;
+        m_rows = rows_ptr;
+        m_poffs = poffs_ptr;
+        m_pdata = pdata_ptr;
+        map_flag = true;
+    }
+
+    return true;
+}
+
+// =============================================================================
+// # Memory Usage
+//
+// Returns the number of bytes held in memory, excluding mapped file pages.
+// =============================================================================
+uint64_t SDRIndex::memory_usage() {
+
+    uint64_t bytes = 0;
+
+    bytes += sizeof(map_flag);
+    bytes += sizeof(num_b);
+    bytes += sizeof(num_w);
+    bytes += sizeof(num_e);
+    bytes += (uint64_t)(ids.size() * sizeof(uint32_t));
+    bytes += (uint64_t)(sizes.size() * sizeof(uint32_t));
+    bytes += (uint64_t)(rows.size() * sizeof(word_t));
+
+    for (uint32_t b = 0; b < plists.size(); b++)
+        bytes += (uint64_t)(plists[b].size() * sizeof(uint32_t));
+
+    bytes += (uint64_t)(counts.size() * sizeof(uint32_t));
+    bytes += (uint64_t)(touched.capacity() * sizeof(uint32_t));
+
+    return bytes;
+}
+
+// =============================================================================
+// # Insert
+//
+// Adds a BitArray to the index under an id.  Ids need not be unique.
+// =============================================================================
+void SDRIndex::insert(const uint32_t id, BitArray& ba) {
+
+    assert(!map_flag);
+    assert(num_b > 0);
+    assert(ba.num_bits() == num_b);
+
+    uint32_t e = num_e++;
+    std::vector<uint32_t> acts = ba.get_acts();
+
+    ids.push_back(id);
+    sizes.push_back((uint32_t)acts.size());
+    rows.insert(rows.end(), ba.words.begin(), ba.words.end());
+
+    for (uint32_t i = 0; i < acts.size(); i++)
+        plists[acts[i]].push_back(e);
+}
+
+// =============================================================================
+// # Query
+//
+// Returns up to k entries most similar to a BitArray, best first.  Entries
+// with no overlap are never returned.  Ties keep insertion order.
+//
+// ## Metrics
+//
+// SDR_OVERLAP: |a & b|
+// SDR_JACCARD: |a & b| / |a | b|
+//
+// ## Strategy
+//
+// inverted cost: sum of posting list lengths of the query's active bits
+//    scan cost: num_e * num_w word popcounts
+//
+// Posting list updates are scattered so they are weighted twice a word.
+// =============================================================================
+std::vector<SDRMatch> SDRIndex::query(
+        BitArray& ba,
+        const uint32_t k,
+        const uint8_t metric) {
+
+    assert(ba.num_bits() == num_b);
+    assert(metric == SDR_OVERLAP || metric == SDR_JACCARD);
+
+    std::vector<SDRMatch> matches;
+
+    if (num_e == 0 || k == 0)
+        return matches;
+
+    if (counts.size() < num_e)
+        counts.resize(num_e, 0);
+
+    std::vector<uint32_t> acts = ba.get_acts();
+    uint64_t p_cost = 0;
+    uint64_t s_cost = (uint64_t)num_e * num_w;
+
+    for (uint32_t i = 0; i < acts.size(); i++) {
+        uint32_t len;
+        postings(acts[i], &len);
+        p_cost += len;
+    }
+
+    if (2 * p_cost <= s_cost)
+        count_inverted(acts);
+    else
+        count_brute(ba);
+
+    // Score touched entries
+    const uint32_t* ids_ptr = map_flag ? m_ids : ids.data();
+    const uint32_t* sizes_ptr = map_flag ? m_sizes : sizes.data();
+    uint32_t q_size = (uint32_t)acts.size();
+
+    std::sort(touched.begin(), touched.end());
+    matches.resize(touched.size());
+
+    for (uint32_t t = 0; t < touched.size(); t++) {
+        uint32_t e = touched[t];
+        uint32_t ov = counts[e];
+        double score = ov;
+
+        if (metric == SDR_JACCARD)
+            score = (double)ov / (double)(q_size + sizes_ptr[e] - ov);
+
+        matches[t].id = e;
+        matches[t].score = score;
+        counts[e] = 0;
+    }
+
+    touched.clear();
+
+    // Keep the top k, breaking ties by entry
+    uint32_t n = std::min(k, (uint32_t)matches.size());
+
+    std::partial_sort(
+        matches.begin(), matches.begin() + n, matches.end(),
+        [](const SDRMatch& a, const SDRMatch& b) {
+            return a.score > b.score || (a.score == b.score && a.id < b.id);
+        });
+
+    matches.resize(n);
+
+    for (uint32_t m = 0; m < n; m++)
+        matches[m].id = ids_ptr[matches[m].id];
+
+    return matches;
+}
+
+// =============================================================================
+// # Query Batch
+//
+// Runs query() on each BitArray.
+// =============================================================================
+std::vector<std::vector<SDRMatch>> SDRIndex::query_batch(
+        std::vector<BitArray>& bas,
+        const uint32_t k,
+        const uint8_t metric) {
+
+    std::vector<std::vector<SDRMatch>> results(bas.size());
+
+    for (uint32_t i = 0; i < bas.size(); i++)
+        results[i] = query(bas[i], k, metric);
+
+    return results;
+}
+
+// =============================================================================
+// # Count Inverted
+//
+// Accumulates overlaps by walking the posting lists of the active bits.
+// =============================================================================
+void SDRIndex::count_inverted(std::vector<uint32_t>& acts) {
+
+    for (uint32_t i = 0; i < acts.size(); i++) {
+        uint32_t len;
+        const uint32_t* p = postings(acts[i], &len);
+
+        for (uint32_t j = 0; j < len; j++) {
+
+            // Skip postings of corrupt mapped files (see read)
+            if (p[j] >= num_e)
+                continue;
+
+            if (counts[p[j]]++ == 0)
+                touched.push_back(p[j]);
+        }
+    }
+}
+
+// =============================================================================
+// # Count Brute
+//
+// Accumulates overlaps by scanning every entry's words.  The inner loop has no
+// branches so the compiler can vectorize it.
+// =============================================================================
+void SDRIndex::count_brute(BitArray& ba) {
+
+    const word_t* rows_ptr = map_flag ? m_rows : rows.data();
+    const word_t* q = ba.words.data();
+
+    for (uint32_t e = 0; e < num_e; e++) {
+        const word_t* r = &rows_ptr[(size_t)e * num_w];
+        uint32_t ov = 0;
+
+        for (uint32_t w = 0; w < num_w; w++)
+            ov += popcount(r[w] & q[w]);
+
+        if (ov > 0) {
+            counts[e] = ov;
+            touched.push_back(e);
+        }
+    }
+}
+
+// =============================================================================
+// # Postings
+//
+// Returns the entries containing bit b and their count.
+// =============================================================================
+const uint32_t* SDRIndex::postings(const uint32_t b, uint32_t* len) {
+
+    if (map_flag) {
+        *len = m_poffs[b + 1] - m_poffs[b];
+        return m_pdata + m_poffs[b];
+    }
+
+    *len = (uint32_t)plists[b].size();
+    return plists[b].data();
+}
@@ -0,0 +1,97 @@
+// =============================================================================
+// sdr_index.hpp
+// =============================================================================
+#ifndef SDR_INDEX_HPP
+#define SDR_INDEX_HPP
+
+#include "bitarray.hpp"
+#include "mapped_file.hpp"
+#include <cstdint>
+#include <vector>
+
+#define SDR_OVERLAP 0
+#define SDR_JACCARD 1
+
+namespace BrainBlocks {
+
+struct SDRMatch {
+    uint32_t id;  // entry id
+    double score; // overlap or jaccard similarity
+};
+
+class SDRIndex {
+
+public:
+
+    // Constructor
+    SDRIndex() {};
+    SDRIndex(const SDRIndex&) = delete;
+    SDRIndex& operator=(const SDRIndex&) = delete;
+
+    // Initializers
+    void init(const uint32_t num_b);
+    void clear();
+
+    // Misc. functions
+    bool save(const char* file);
+    bool load(const char* file);
+    bool map(const char* file);
+    uint64_t memory_usage();
+
+    // Core functions
+    void insert(const uint32_t id, BitArray& ba);
+
+    std::vector<SDRMatch> query(
+        BitArray& ba,
+        const uint32_t k,
+        const uint8_t metric=SDR_OVERLAP);
+
+    std::vector<std::vector<SDRMatch>> query_batch(
+        std::vector<BitArray>& bas,
+        const uint32_t k,
+        const uint8_t metric=SDR_OVERLAP);
+
+    // Getters
+    uint32_t num_bits() { return num_b; };
+    uint32_t num_entries() { return num_e; };
+    bool is_mapped() { return map_flag; };
+
+private:
+
+    bool read(const uint8_t* data, const size_t len, const bool copy);
+    void count_inverted(std::vector<uint32_t>& acts);
+    void count_brute(BitArray& ba);
+    const uint32_t* postings(const uint32_t b, uint32_t* len);
+
+private:
+
+    // Flags
+    bool map_flag = false;
+
+    // Parameters
+    uint32_t num_b = 0; // number of bits per entry
+    uint32_t num_w = 0; // number of words per entry
+    uint32_t num_e = 0; // number of entries
+
+    // Arrays (owned)
+    std::vector<uint32_t> ids;                 // entry ids
+    std::vector<uint32_t> sizes;               // entry active bit counts
+    std::vector<word_t> rows;                  // entry words
+    std::vector<std::vector<uint32_t>> plists; // entries per active bit
+
+    // Arrays (mapped)
+    MappedFile file;
+    const uint32_t* m_ids = nullptr;
+    const uint32_t* m_sizes = nullptr;
+    const word_t* m_rows = nullptr;
+    const uint32_t* m_poffs = nullptr;
+    const uint32_t* m_pdata = nullptr;
+
+    // Scratch
+    std::vector<uint32_t> counts;  // overlap per entry
+    std::vector<uint32_t> touched; // entries with nonzero overlap
+};
+
+} // namespace BrainBlocks
+
+#endif // SDR_INDEX_HPP
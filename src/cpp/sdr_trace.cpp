@@ -0,0 +1,333 @@
+// =============================================================================
+// sdr_trace.cpp
+// =============================================================================
+#include "sdr_trace.hpp"
+#include <cassert>
+
+using namespace BrainBlocks;
+
+#define SDR_TRACE_MAGIC 0x52544242 // "BBTR"
+#define SDR_TRACE_VERSION 1
+#define SDR_TRACE_FLUSH (64 << 10) // bytes buffered before writing
+
+// =============================================================================
+// # SDR Trace
+//
+// Compact record of the BlockOutput states feeding a block hierarchy, so a
+// run can be replayed exactly.  Each step is one frame: a learn flag followed
+// by every source's active bits as a count and delta-encoded indices, all
+// packed as varints.  A 1024 bit source with 40 active bits typically takes
+// 40-60 bytes per frame instead of 128.
+//
+// Frames go to rolling files "<prefix>.<n>.bbt".  Each file starts with its
+// own header so any file can be replayed on its own.
+//
+// ## File Layout
+//
+// header: magic, version, num_sources (uint32)
+//         num_b, num_t per source (uint32)
+// frames: flags (byte, bit 0 = learn)
+//         per source: varint count, varint deltas
+//
+// ## Example
+//
+// active bits: {3, 7, 8, 300}
+// varints: 4, 3, 4, 1, 292
+// bytes: {04 03 04 01 a4 02}
+// =============================================================================
+
+// =============================================================================
+// # Varint Encode
+// =============================================================================
+inline void varint_encode(std::vector<uint8_t>& buf, uint32_t v) {
+
+    while (v >= 0x80) {
+        buf.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+
+    buf.push_back((uint8_t)v);
+}
+
+// =============================================================================
+// # Recorder Destructor
+//
+// Flushes and closes the current file.
+// =============================================================================
+SDRTraceRecorder::~SDRTraceRecorder() {
+
+    close();
+}
+
+// =============================================================================
+// # Add Source
+//
+// Adds a BlockOutput to record.  Sources are replayed in the order added.
+// =============================================================================
+void SDRTraceRecorder::add_source(BlockOutput* src) {
+
+    assert(src != nullptr);
+    assert(fptr == NULL);
+
+    sources.push_back(src);
+}
+
+// =============================================================================
+// # Open
+//
+// Starts recording to rolling files.  A new file is started once the current
+// one holds about max_bytes, and only the newest max_files files are kept.
+// Returns false if the first file can not be created.
+// =============================================================================
+bool SDRTraceRecorder::open(
+        const char* prefix,
+        const uint32_t max_bytes,
+        const uint32_t max_files) {
+
+    assert(sources.size() > 0);
+    assert(max_bytes > 0);
+    assert(max_files > 0);
+
+    close();
+
+    this->prefix = prefix;
+    this->max_bytes = max_bytes;
+    this->max_files = max_files;
+    file_n = 0;
+    num_f = 0;
+
+    return open_next();
+}
+
+// =============================================================================
+// # Close
+//
+// Flushes buffered frames and closes the current file.
+// =============================================================================
+void SDRTraceRecorder::close() {
+
+    if (fptr == NULL)
+        return;
+
+    flush();
+    std::fclose(fptr);
+    fptr = NULL;
+}
+
+// =============================================================================
+// # Record
+//
+// Appends the current state of every source as one frame.  Call once per step
+// after the sources have been fed forward.
+// =============================================================================
+void SDRTraceRecorder::record(const bool learn_flag) {
+
+    assert(fptr != NULL);
+
+    buf.push_back(learn_flag ? 1 : 0);
+
+    for (uint32_t s = 0; s < sources.size(); s++) {
+        BitArray& state = sources[s]->state;
+        uint32_t prev = 0;
+
+        varint_encode(buf, state.num_set());
+
+        for (uint32_t w = 0; w < state.num_words(); w++) {
+            word_t word = state.words[w];
+
+            while (word) {
+                uint32_t b = w * WBITS + (uint32_t)trailing_zeros(word);
+                word &= word - 1;
+                varint_encode(buf, b - prev);
+                prev = b;
+            }
+        }
+    }
+
+    num_f++;
+
+    if (buf.size() >= SDR_TRACE_FLUSH) {
+        flush();
+
+        if (file_bytes >= max_bytes)
+            open_next();
+    }
+}
+
+// =============================================================================
+// # File Name
+//
+// Returns the name of the nth file.
+// =============================================================================
+std::string SDRTraceRecorder::file_name(const uint32_t n) {
+
+    return prefix + "." + std::to_string(n) + ".bbt";
+}
+
+// =============================================================================
+// # Open Next
+//
+// Closes the current file, starts the next one with a header, and removes the
+// oldest file beyond max_files.
+// =============================================================================
+bool SDRTraceRecorder::open_next() {
+
+    close();
+
+    if ((fptr = std::fopen(file_name(file_n).c_str(), "wb")) == NULL)
+        return false;
+
+    std::vector<uint32_t> header = {
+        SDR_TRACE_MAGIC, SDR_TRACE_VERSION, (uint32_t)sources.size()};
+
+    for (uint32_t s = 0; s < sources.size(); s++) {
+        header.push_back(sources[s]->state.num_bits());
+        header.push_back(sources[s]->num_t());
+    }
+
+    std::fwrite(header.data(), sizeof(uint32_t), header.size(), fptr);
+    file_bytes = (uint32_t)(header.size() * sizeof(uint32_t));
+    file_n++;
+
+    if (file_n > max_files)
+        std::remove(file_name(file_n - 1 - max_files).c_str());
+
+    return true;
+}
+
+// =============================================================================
+// # Flush
+//
+// Writes buffered frames to the current file.
+// =============================================================================
+void SDRTraceRecorder::flush() {
+
+    std::fwrite(buf.data(), 1, buf.size(), fptr);
+    file_bytes += (uint32_t)buf.size();
+    buf.clear();
+}
+
+// =============================================================================
+// # Replayer Open
+//
+// Maps a trace file and builds one BlankBlock per recorded source with the
+// same number of bits and history steps.  Returns false if the file can not
+// be read or is not a trace file.
+// =============================================================================
+bool SDRTraceReplayer::open(const char* file) {
+
+    close();
+
+    if (!this->file.open(file))
+        return false;
+
+    data = this->file.data();
+    len = this->file.size();
+
+    const uint32_t* header = (const uint32_t*)data;
+
+    if (len < 3 * sizeof(uint32_t) ||
+        header[0] != SDR_TRACE_MAGIC ||
+        header[1] != SDR_TRACE_VERSION ||
+        len < (3 + 2 * (size_t)header[2]) * sizeof(uint32_t)) {
+        close();
+        return false;
+    }
+
+    uint32_t num_s = header[2];
+
+    for (uint32_t s = 0; s < num_s; s++) {
+        uint32_t num_b = header[3 + 2 * s];
+        uint32_t num_t = header[4 + 2 * s];
+        blocks.emplace_back(new BlankBlock(num_b, num_t));
+    }
+
+    pos = (3 + 2 * (size_t)num_s) * sizeof(uint32_t);
+
+    return true;
+}
+
+// =============================================================================
+// # Replayer Close
+//
+// Unmaps the trace file and removes the replay blocks.
+// =============================================================================
+void SDRTraceReplayer::close() {
+
+    file.close();
+    blocks.clear();
+    data = nullptr;
+    len = 0;
+    pos = 0;
+    learn = false;
+}
+
+// =============================================================================
+// # Step
+//
+// Decodes the next frame into the replay blocks and feeds them forward.
+// Blocks connected to output() then see exactly the recorded states.  Returns
+// false at the end of the file.  A truncated frame or a bit index past its
+// block's size also returns false and stops the replay.
+// =============================================================================
+bool SDRTraceReplayer::step() {
+
+    if (pos >= len)
+        return false;
+
+    learn = (data[pos++] & 1) != 0;
+
+    for (uint32_t s = 0; s < blocks.size(); s++) {
+        BitArray& state = blocks[s]->output.state;
+        uint32_t num_a;
+        uint64_t b = 0;
+
+        state.clear_all();
+
+        if (!read_varint(&num_a)) {
+            pos = len;
+            return false;
+        }
+
+        for (uint32_t a = 0; a < num_a; a++) {
+            uint32_t delta;
+
+            if (!read_varint(&delta) ||
+                (b += delta) >= state.num_bits()) {
+                state.clear_all();
+                pos = len;
+                return false;
+            }
+
+            state.set_bit((uint32_t)b);
+        }
+
+        blocks[s]->feedforward();
+    }
+
+    return true;
+}
+
+// =============================================================================
+// # Read Varint
+//
+// Decodes one varint.  Returns false on a truncated frame.
+// =============================================================================
+bool SDRTraceReplayer::read_varint(uint32_t* v) {
+
+    uint32_t shift = 0;
+
+    *v = 0;
+
+    while (pos < len && shift < 35) {
+        uint8_t byte = data[pos++];
+        *v |= (uint32_t)(byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0)
+            return true;
+
+        shift += 7;
+    }
+
+    return false;
+}
@@ -0,0 +1,94 @@
+// =============================================================================
+// sdr_trace.hpp
+// =============================================================================
+#ifndef SDR_TRACE_HPP
+#define SDR_TRACE_HPP
+
+#include "bitarray.hpp"
+#include "block_output.hpp"
+#include "blocks/blank_block.hpp"
+#include "mapped_file.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BrainBlocks {
+
+class SDRTraceRecorder {
+
+public:
+
+    // Constructor and destructor
+    SDRTraceRecorder() {};
+    ~SDRTraceRecorder();
+    SDRTraceRecorder(const SDRTraceRecorder&) = delete;
+    SDRTraceRecorder& operator=(const SDRTraceRecorder&) = delete;
+
+    // Setup functions (call before opening)
+    void add_source(BlockOutput* src);
+
+    // Open and close
+    bool open(
+        const char* prefix,
+        const uint32_t max_bytes=(64 << 20),
+        const uint32_t max_files=4);
+
+    void close();
+
+    // Core functions
+    void record(const bool learn_flag);
+
+    // Getters
+    std::string file_name(const uint32_t n);
+    uint32_t num_files() { return file_n; };
+    uint64_t num_frames() { return num_f; };
+
+private:
+
+    bool open_next();
+    void flush();
+
+    std::vector<BlockOutput*> sources;
+    std::string prefix;
+    FILE* fptr = NULL;
+    uint32_t max_bytes = 0;   // bytes per file before rolling over
+    uint32_t max_files = 0;   // files kept on disk
+    uint32_t file_n = 0;      // number of files opened
+    uint32_t file_bytes = 0;  // bytes written to the current file
+    uint64_t num_f = 0;       // number of frames recorded
+    std::vector<uint8_t> buf; // encoded frames not yet written
+};
+
+class SDRTraceReplayer {
+
+public:
+
+    // Open and close
+    bool open(const char* file);
+    void close();
+
+    // Core functions
+    bool step();
+
+    // Getters
+    BlockOutput& output(const uint32_t s) { return blocks[s]->output; };
+    uint32_t num_sources() { return (uint32_t)blocks.size(); };
+    bool learn_flag() { return learn; };
+
+private:
+
+    bool read_varint(uint32_t* v);
+
+    MappedFile file;
+    bool learn = false;
+    std::vector<std::unique_ptr<BlankBlock>> blocks;
+    const uint8_t* data = nullptr; // file contents
+    size_t len = 0;                // number of bytes in file
+    size_t pos = 0;                // read position in file
+};
+
+} // namespace BrainBlocks
+
+#endif // SDR_TRACE_HPP
@@ -0,0 +1,255 @@
+// =============================================================================
+// summary_bitarray.cpp
+// =============================================================================
+#include "summary_bitarray.hpp"
+#include <cassert>
+
+using namespace BrainBlocks;
+
+// =============================================================================
+// # SummaryBitArray
+//
+// A BitArray with a hierarchy of summary bitmaps for very large, very sparse
+// arrays such as per-dendrite states.  Each summary level has one bit per word
+// of the level below, set when that word is nonzero.  set_bit and clear_bit
+// keep the summaries up to date, touching an extra level only when a word
+// changes between zero and nonzero.  Searches, iteration and counts then skip
+// long zero runs a whole summary word (1024 bits for level 1) at a time, so
+// find_next_set_bit costs O(levels) instead of O(words).
+//
+// ## Example
+//
+// bits (4096):     {0...0 1 0...0 ... 0...0}   (bit 2000 set)
+// level 1 (128):   {0...0 1 0...0}             (word 62 nonzero)
+// level 2 (4):     {0 1 0 0}                   (level 1 word 1 nonzero)
+//
+// find_next_set_bit(5, &result): level 0 word 0 is empty, level 1 word 0 has
+// no set bit after 0, level 2 gives word 1, level 1 word 1 gives word 62,
+// level 0 word 62 gives bit 2000.
+// =============================================================================
+
+// =============================================================================
+// # Constructor
+//
+// Constructs a SummaryBitArray with n bits.
+// =============================================================================
+SummaryBitArray::SummaryBitArray(const uint32_t n) {
+
+    resize(n);
+}
+
+// =============================================================================
+// # Resize
+//
+// Resizes the array to n bits and rebuilds the summary levels.  All bits are
+// cleared.
+// =============================================================================
+void SummaryBitArray::resize(const uint32_t n) {
+
+    assert(n > 0);
+
+    uint32_t num = n;
+    levels.clear();
+
+    while (true) {
+        levels.push_back(BitArray(num));
+
+        if (levels.back().num_words() <= 1)
+            break;
+
+        num = levels.back().num_words();
+    }
+}
+
+// =============================================================================
+// # Set Bit
+//
+// Sets a particular bit to 1 and marks its word in the summary levels.
+// =============================================================================
+void SummaryBitArray::set_bit(const uint32_t b) {
+
+    assert(b < num_bits());
+
+    uint32_t pos = b;
+
+    for (uint32_t l = 0; l < levels.size(); l++) {
+        word_t& word = levels[l].words[get_wrd(pos)];
+        bool was_empty = word == 0;
+
+        word |= (word_t)1 << get_idx(pos);
+
+        // Summaries above are already set
+        if (!was_empty)
+            break;
+
+        pos = get_wrd(pos);
+    }
+}
+
+// =============================================================================
+// # Clear Bit
+//
+// Sets a particular bit to 0 and unmarks its word in the summary levels when
+// the word becomes empty.
+// =============================================================================
+void SummaryBitArray::clear_bit(const uint32_t b) {
+
+    assert(b < num_bits());
+
+    uint32_t pos = b;
+
+    for (uint32_t l = 0; l < levels.size(); l++) {
+        word_t& word = levels[l].words[get_wrd(pos)];
+
+        word &= ~((word_t)1 << get_idx(pos));
+
+        // Summaries above still have a set bit below them
+        if (word != 0)
+            break;
+
+        pos = get_wrd(pos);
+    }
+}
+
+// =============================================================================
+// # Clear All
+//
+// Sets all bits to 0 by zeroing only the nonzero words found through the
+// summary level above each level.
+// =============================================================================
+void SummaryBitArray::clear_all() {
+
+    for (uint32_t l = 0; l + 1 < levels.size(); l++) {
+        std::vector<word_t>& summary = levels[l + 1].words;
+
+        for (uint32_t sw = 0; sw < summary.size(); sw++) {
+            word_t word = summary[sw];
+
+            while (word) {
+                uint32_t w = sw * WBITS + trailing_zeros(word);
+                levels[l].words[w] = 0;
+                word &= word - 1;
+            }
+        }
+    }
+
+    levels.back().clear_all();
+}
+
+// =============================================================================
+// # Get Acts
+//
+// Returns the indices of all set bits in ascending order.
+// =============================================================================
+std::vector<uint32_t> SummaryBitArray::get_acts() {
+
+    std::vector<uint32_t> acts;
+    uint32_t w = 0;
+
+    if (levels.size() == 1)
+        return levels[0].get_acts();
+
+    // Visit nonzero words only
+    while (find_from(1, w, &w)) {
+        word_t word = levels[0].words[w];
+
+        while (word) {
+            acts.push_back(w * WBITS + trailing_zeros(word));
+            word &= word - 1;
+        }
+
+        w++;
+    }
+
+    return acts;
+}
+
+// =============================================================================
+// # Number of Set
+//
+// Returns the number of set bits, counting nonzero words only.
+// =============================================================================
+uint32_t SummaryBitArray::num_set() {
+
+    uint32_t count = 0;
+    uint32_t w = 0;
+
+    if (levels.size() == 1)
+        return levels[0].num_set();
+
+    while (find_from(1, w, &w)) {
+        count += popcount(levels[0].words[w]);
+        w++;
+    }
+
+    return count;
+}
+
+// =============================================================================
+// # Find Next Set Bit
+//
+// Finds the index of the next set bit from a bit offset, wrapping around to
+// offset-1 like BitArray::find_next_set_bit.  Returns false if no bits are set.
+// =============================================================================
+bool SummaryBitArray::find_next_set_bit(const uint32_t beg, uint32_t* result) {
+
+    assert(beg < num_bits());
+
+    if (find_from(0, beg, result))
+        return true;
+
+    // Wrap around
+    return beg > 0 && find_from(0, 0, result);
+}
+
+// =============================================================================
+// # Memory Usage
+//
+// Returns an estimate of the number of bytes used by the SummaryBitArray.
+// =============================================================================
+uint64_t SummaryBitArray::memory_usage() {
+
+    uint64_t bytes = 0;
+
+    for (uint32_t l = 0; l < levels.size(); l++)
+        bytes += levels[l].memory_usage();
+
+    return bytes;
+}
+
+// =============================================================================
+// # Find From
+//
+// Finds the first set bit at or after pos in level l without wrapping.  When
+// the word holding pos has no such bit, the next nonzero word is found through
+// level l + 1.
+// =============================================================================
+bool SummaryBitArray::find_from(
+        const uint32_t l,
+        const uint32_t pos,
+        uint32_t* result) {
+
+    BitArray& ba = levels[l];
+
+    if (pos >= ba.num_bits())
+        return false;
+
+    uint32_t w = get_wrd(pos);
+    word_t word = ba.words[w] & ~bitmask(get_idx(pos));
+
+    if (word == 0) {
+
+        // The top level is a single word
+        if (l + 1 == levels.size())
+            return false;
+
+        if (!find_from(l + 1, w + 1, &w))
+            return false;
+
+        word = ba.words[w];
+    }
+
+    *result = w * WBITS + trailing_zeros(word);
+
+    return true;
+}
@@ -0,0 +1,54 @@
+// =============================================================================
+// summary_bitarray.hpp
+// =============================================================================
+#ifndef SUMMARY_BITARRAY_HPP
+#define SUMMARY_BITARRAY_HPP
+
+#include "bitarray.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace BrainBlocks {
+
+class SummaryBitArray {
+
+public:
+
+    // Constructors, resize
+    SummaryBitArray() {};
+    SummaryBitArray(const uint32_t n);
+    void resize(const uint32_t n);
+
+    // Access and manipulate a single bit
+    void set_bit(const uint32_t b);
+    uint8_t get_bit(const uint32_t b) { return levels[0].get_bit(b); };
+    void clear_bit(const uint32_t b);
+
+    // Access and manipulate all bits
+    void clear_all();
+    std::vector<uint32_t> get_acts();
+
+    // Get count of bits
+    uint32_t num_set();
+
+    // Find indices of set bits
+    bool find_next_set_bit(const uint32_t beg, uint32_t* result);
+
+    // Get Information
+    BitArray& get_bitarray() { return levels[0]; };
+    uint32_t num_bits() { return levels.empty() ? 0 : levels[0].num_bits(); };
+    uint32_t num_levels() { return (uint32_t)levels.size(); };
+    uint64_t memory_usage();
+
+private:
+
+    bool find_from(const uint32_t l, const uint32_t pos, uint32_t* result);
+
+    // levels[0] holds the bits, bit i of levels[l + 1] is set when word i of
+    // levels[l] is nonzero, and the last level is a single word
+    std::vector<BitArray> levels;
+};
+
+} // namespace BrainBlocks
+
+#endif // SUMMARY_BITARRAY_HPP
@@ -0,0 +1,366 @@
+// =============================================================================
+// sweep_runner.cpp
+// =============================================================================
+#include "sweep_runner.hpp"
+#include "blocks/blank_block.hpp"
+#include "blocks/pattern_classifier.hpp"
+#include "blocks/pattern_classifier_dynamic.hpp"
+#include "blocks/pattern_pooler.hpp"
+#include "blocks/sequence_learner.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+using namespace BrainBlocks;
+
+typedef std::chrono::steady_clock sweep_clock;
+
+// =============================================================================
+// # SweepRunner
+//
+// Hyperparameter sweep engine.  The dataset is encoded once by the caller and
+// stored as packed words shared by every configuration.  Each configuration
+// builds its own blocks behind a BlankBlock that replays the packed samples,
+// so configurations run concurrently without re-encoding or sharing state.
+//
+// ## Example
+//
+// SweepRunner runner(1024);
+// runner.add_train(encoded, label); // for each training sample
+// runner.add_test(encoded, label);  // for each test sample
+//
+// std::vector<SweepConfig> configs(2);
+// configs[0].num_s = 512;
+// configs[1].num_s = 1024;
+//
+// std::vector<SweepResult> results = runner.run_all(configs, 4);
+// =============================================================================
+
+// =============================================================================
+// # Constructor
+//
+// Constructs a SweepRunner for samples of num_b bits.
+// =============================================================================
+SweepRunner::SweepRunner(const uint32_t num_b) {
+
+    assert(num_b > 0);
+
+    this->num_b = num_b;
+    num_w = (num_b + WBITS - 1) / WBITS;
+}
+
+// =============================================================================
+// # Add Train
+//
+// Appends an encoded training sample and its label.
+// =============================================================================
+void SweepRunner::add_train(BitArray& ba, const uint32_t label) {
+
+    assert(ba.num_bits() == num_b);
+
+    train_words.insert(train_words.end(), ba.words.begin(), ba.words.end());
+    train_labels.push_back(label);
+}
+
+// =============================================================================
+// # Add Test
+//
+// Appends an encoded test sample and its label.
+// =============================================================================
+void SweepRunner::add_test(BitArray& ba, const uint32_t label) {
+
+    assert(ba.num_bits() == num_b);
+
+    test_words.insert(test_words.end(), ba.words.begin(), ba.words.end());
+    test_labels.push_back(label);
+}
+
+// =============================================================================
+// # Clear
+//
+// Removes all samples.
+// =============================================================================
+void SweepRunner::clear() {
+
+    train_words.clear();
+    test_words.clear();
+    train_labels.clear();
+    test_labels.clear();
+}
+
+// =============================================================================
+// # Memory Usage
+//
+// Returns an estimate of the number of bytes used by the shared samples.
+// =============================================================================
+uint64_t SweepRunner::memory_usage() {
+
+    uint64_t bytes = 0;
+
+    bytes += sizeof(num_b);
+    bytes += sizeof(num_w);
+    bytes += (uint64_t)(train_words.size() * sizeof(word_t));
+    bytes += (uint64_t)(test_words.size() * sizeof(word_t));
+    bytes += (uint64_t)(train_labels.size() * sizeof(uint32_t));
+    bytes += (uint64_t)(test_labels.size() * sizeof(uint32_t));
+
+    return bytes;
+}
+
+// =============================================================================
+// # Run
+//
+// Trains and evaluates one configuration.  Safe to call from several threads
+// at once since the samples are only read.
+// =============================================================================
+SweepResult SweepRunner::run(const SweepConfig& config) {
+
+    assert(config.type == SWEEP_CLASSIFIER ||
+           config.type == SWEEP_CLASSIFIER_DYNAMIC ||
+           config.type == SWEEP_ANOMALY);
+
+    if (config.type == SWEEP_CLASSIFIER)
+        return run_classifier(config);
+
+    if (config.type == SWEEP_CLASSIFIER_DYNAMIC)
+        return run_classifier_dynamic(config);
+
+    return run_anomaly(config);
+}
+
+// =============================================================================
+// # Run All
+//
+// Runs every configuration on a pool of num_threads threads.  Results are in
+// the same order as the configurations.
+// =============================================================================
+std::vector<SweepResult> SweepRunner::run_all(
+        const std::vector<SweepConfig>& configs,
+        const uint32_t num_threads) {
+
+    assert(num_threads > 0);
+
+    std::vector<SweepResult> results(configs.size());
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> next(0);
+    uint32_t num_k = (uint32_t)configs.size();
+
+    for (uint32_t t = 0; t < std::min(num_threads, num_k); t++) {
+        threads.emplace_back([&]() {
+            for (uint32_t k = next++; k < num_k; k = next++)
+                results[k] = run(configs[k]);
+        });
+    }
+
+    for (uint32_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+
+    return results;
+}
+
+// =============================================================================
+// # Run Classifier
+//
+// Trains a PatternClassifier and scores the most voted label on the test set.
+// =============================================================================
+SweepResult SweepRunner::run_classifier(const SweepConfig& c) {
+
+    SweepResult result;
+    BlankBlock blank(num_b);
+    PatternClassifier pc(
+        c.num_l, c.num_s, c.num_as, c.perm_thr, c.perm_inc, c.perm_dec,
+        c.pct_pool, c.pct_conn, c.pct_learn, 2, c.seed);
+
+    pc.input.add_child(&blank.output, 0);
+    pc.init();
+
+    // Train
+    sweep_clock::time_point t0 = sweep_clock::now();
+
+    for (uint32_t e = 0; e < c.num_epochs; e++) {
+        for (uint32_t i = 0; i < train_labels.size(); i++) {
+            load(blank, train_words, i);
+            blank.feedforward();
+            pc.set_label(train_labels[i]);
+            pc.feedforward(true);
+        }
+    }
+
+    // Test
+    sweep_clock::time_point t1 = sweep_clock::now();
+    std::vector<uint32_t> votes(c.num_l);
+    uint32_t num_correct = 0;
+
+    for (uint32_t i = 0; i < test_labels.size(); i++) {
+        load(blank, test_words, i);
+        blank.feedforward();
+        pc.feedforward(false);
+
+        if (pc.get_votes(votes.data()) == test_labels[i])
+            num_correct++;
+    }
+
+    sweep_clock::time_point t2 = sweep_clock::now();
+
+    if (test_labels.size() > 0)
+        result.accuracy = (double)num_correct / (double)test_labels.size();
+
+    result.train_time = std::chrono::duration<double>(t1 - t0).count();
+    result.test_time = std::chrono::duration<double>(t2 - t1).count();
+    result.memory_usage = pc.memory.memory_usage() +
+                          pc.input.memory_usage() +
+                          pc.output.memory_usage();
+
+    return result;
+}
+
+// =============================================================================
+// # Run Classifier Dynamic
+//
+// Trains a PatternClassifierDynamic and scores the most probable label on the
+// test set.  The mean anomaly score is the mean unrecognized fraction.
+// =============================================================================
+SweepResult SweepRunner::run_classifier_dynamic(const SweepConfig& c) {
+
+    SweepResult result;
+    BlankBlock blank(num_b);
+    PatternClassifierDynamic pcd(
+        c.num_s, c.num_as, c.num_spl, c.perm_thr, c.perm_inc, c.perm_dec,
+        c.pct_pool, c.pct_conn, c.pct_learn, 2, c.seed);
+
+    pcd.input.add_child(&blank.output, 0);
+    pcd.init();
+
+    // Train
+    sweep_clock::time_point t0 = sweep_clock::now();
+
+    for (uint32_t e = 0; e < c.num_epochs; e++) {
+        for (uint32_t i = 0; i < train_labels.size(); i++) {
+            load(blank, train_words, i);
+            blank.feedforward();
+            pcd.set_label(train_labels[i]);
+            pcd.feedforward(true);
+        }
+    }
+
+    // Test
+    sweep_clock::time_point t1 = sweep_clock::now();
+    std::vector<uint32_t> labels = pcd.get_labels();
+    uint32_t num_correct = 0;
+    double sum_anom = 0.0;
+
+    for (uint32_t i = 0; i < test_labels.size(); i++) {
+        load(blank, test_words, i);
+        blank.feedforward();
+        pcd.feedforward(false);
+
+        std::vector<double> probs = pcd.get_probabilities();
+        sum_anom += pcd.get_anomaly_score();
+
+        if (probs.empty())
+            continue;
+
+        uint32_t l = (uint32_t)(std::max_element(probs.begin(), probs.end()) -
+                                probs.begin());
+
+        if (labels[l] == test_labels[i])
+            num_correct++;
+    }
+
+    sweep_clock::time_point t2 = sweep_clock::now();
+
+    if (test_labels.size() > 0) {
+        result.accuracy = (double)num_correct / (double)test_labels.size();
+        result.mean_anomaly = sum_anom / (double)test_labels.size();
+    }
+
+    result.train_time = std::chrono::duration<double>(t1 - t0).count();
+    result.test_time = std::chrono::duration<double>(t2 - t1).count();
+    result.memory_usage = pcd.memory.memory_usage() +
+                          pcd.input.memory_usage() +
+                          pcd.output.memory_usage();
+
+    return result;
+}
+
+// =============================================================================
+// # Run Anomaly
+//
+// Trains a PatternPooler into SequenceLearner anomaly detector on the training
+// sequence and reports its mean anomaly score over the test sequence.  Labels
+// are ignored.
+// =============================================================================
+SweepResult SweepRunner::run_anomaly(const SweepConfig& c) {
+
+    SweepResult result;
+    BlankBlock blank(num_b);
+    PatternPooler pp(
+        c.num_s, c.num_as, c.perm_thr, c.perm_inc, c.perm_dec, c.pct_pool,
+        c.pct_conn, c.pct_learn, 2, false, c.seed);
+    SequenceLearner sl(
+        c.num_s, c.num_spc, c.num_dps, c.num_rpd, c.d_thresh, c.perm_thr,
+        c.perm_inc, c.perm_dec, 2, false, c.seed);
+
+    pp.input.add_child(&blank.output, 0);
+    sl.input.add_child(&pp.output, 0);
+    pp.init();
+    sl.init();
+
+    // Train
+    sweep_clock::time_point t0 = sweep_clock::now();
+
+    for (uint32_t e = 0; e < c.num_epochs; e++) {
+        for (uint32_t i = 0; i < train_labels.size(); i++) {
+            load(blank, train_words, i);
+            blank.feedforward();
+            pp.feedforward(true);
+            sl.feedforward(true);
+        }
+    }
+
+    // Test
+    sweep_clock::time_point t1 = sweep_clock::now();
+    double sum_anom = 0.0;
+
+    for (uint32_t i = 0; i < test_labels.size(); i++) {
+        load(blank, test_words, i);
+        blank.feedforward();
+        pp.feedforward(false);
+        sl.feedforward(false);
+        sum_anom += sl.get_anomaly_score();
+    }
+
+    sweep_clock::time_point t2 = sweep_clock::now();
+
+    if (test_labels.size() > 0)
+        result.mean_anomaly = sum_anom / (double)test_labels.size();
+
+    result.train_time = std::chrono::duration<double>(t1 - t0).count();
+    result.test_time = std::chrono::duration<double>(t2 - t1).count();
+    result.memory_usage = pp.memory.memory_usage() +
+                          pp.input.memory_usage() +
+                          pp.output.memory_usage() +
+                          sl.memory.memory_usage() +
+                          sl.input.memory_usage() +
+                          sl.output.memory_usage();
+
+    return result;
+}
+
+// =============================================================================
+// # Load
+//
+// Copies packed sample i into a BlankBlock's output state.
+// =============================================================================
+void SweepRunner::load(
+        BlankBlock& blank,
+        std::vector<word_t>& words,
+        const uint32_t i) {
+
+    std::copy(
+        words.begin() + (size_t)i * num_w,
+        words.begin() + (size_t)(i + 1) * num_w,
+        blank.output.state.words.begin());
+}
@@ -0,0 +1,93 @@
+// =============================================================================
+// sweep_runner.hpp
+// =============================================================================
+#ifndef SWEEP_RUNNER_HPP
+#define SWEEP_RUNNER_HPP
+
+#include "bitarray.hpp"
+#include <cstdint>
+#include <vector>
+
+#define SWEEP_CLASSIFIER 0         // PatternClassifier
+#define SWEEP_CLASSIFIER_DYNAMIC 1 // PatternClassifierDynamic
+#define SWEEP_ANOMALY 2            // PatternPooler into SequenceLearner
+
+namespace BrainBlocks {
+
+class BlankBlock;
+
+struct SweepConfig {
+    uint8_t type = SWEEP_CLASSIFIER;
+    uint32_t num_l = 2;       // number of labels (classifier)
+    uint32_t num_s = 512;     // number of statelets (columns for anomaly)
+    uint32_t num_as = 8;      // number of active statelets
+    uint32_t num_spl = 8;     // statelets per label (dynamic classifier)
+    uint8_t perm_thr = 20;    // permanence threshold
+    uint8_t perm_inc = 2;     // permanence increment
+    uint8_t perm_dec = 1;     // permanence decrement
+    double pct_pool = 0.8;    // percent pooled
+    double pct_conn = 0.5;    // percent initially connected
+    double pct_learn = 0.3;   // percent learn
+    uint32_t num_spc = 10;    // statelets per column (anomaly)
+    uint32_t num_dps = 10;    // dendrites per statelet (anomaly)
+    uint32_t num_rpd = 12;    // receptors per dendrite (anomaly)
+    uint32_t d_thresh = 6;    // dendrite threshold (anomaly)
+    uint32_t num_epochs = 1;  // training passes
+    uint32_t seed = 0;        // seed for random number generator
+};
+
+struct SweepResult {
+    double accuracy = 0.0;     // fraction of test samples classified correctly
+    double mean_anomaly = 0.0; // mean anomaly score over test samples
+    double train_time = 0.0;   // seconds spent training
+    double test_time = 0.0;    // seconds spent testing
+    uint64_t memory_usage = 0; // bytes used by the trained blocks
+};
+
+class SweepRunner {
+
+public:
+
+    // Constructor
+    SweepRunner(const uint32_t num_b);
+
+    // Data functions
+    void add_train(BitArray& ba, const uint32_t label=0);
+    void add_test(BitArray& ba, const uint32_t label=0);
+    void clear();
+    uint64_t memory_usage();
+
+    // Core functions
+    SweepResult run(const SweepConfig& config);
+
+    std::vector<SweepResult> run_all(
+        const std::vector<SweepConfig>& configs,
+        const uint32_t num_threads);
+
+    // Getters
+    uint32_t num_bits() { return num_b; };
+    uint32_t num_train() { return (uint32_t)train_labels.size(); };
+    uint32_t num_test() { return (uint32_t)test_labels.size(); };
+
+private:
+
+    SweepResult run_classifier(const SweepConfig& c);
+    SweepResult run_classifier_dynamic(const SweepConfig& c);
+    SweepResult run_anomaly(const SweepConfig& c);
+    void load(BlankBlock& blank, std::vector<word_t>& words, const uint32_t i);
+
+private:
+
+    uint32_t num_b; // number of bits per sample
+    uint32_t num_w; // number of words per sample
+
+    // Packed samples (num_w words each) and labels
+    std::vector<word_t> train_words;
+    std::vector<word_t> test_words;
+    std::vector<uint32_t> train_labels;
+    std::vector<uint32_t> test_labels;
+};
+
+} // namespace BrainBlocks
+
+#endif // SWEEP_RUNNER_HPP
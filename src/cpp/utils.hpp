@@ -5,7 +5,10 @@
 #define UTILS_HPP
 
 #include <cstdlib>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <new>
 #include <vector>
 #include <random>
 
@@ -43,6 +46,70 @@ inline void utils_shuffle(
     }
 }
 
+// =============================================================================
+// Utils Bytes Left
+//
+// Returns the number of bytes between the file position and the end of the
+// file, so loaders can reject counts the file cannot hold before allocating.
+// =============================================================================
+inline uint64_t utils_bytes_left(FILE* fptr)
+{
+
+    long pos = std::ftell(fptr);
+
+    if (pos < 0 || std::fseek(fptr, 0, SEEK_END) != 0)
+        return 0;
+
+    long end = std::ftell(fptr);
+    std::fseek(fptr, pos, SEEK_SET);
+
+    return end > pos ? (uint64_t)(end - pos) : 0;
+}
+
+// =============================================================================
+// Utils Aligned Allocator
+//
+// Allocator for std::vector storage aligned to A bytes (a power of 2 no
+// smaller than a pointer).  Over-allocates by A bytes and keeps the original
+// pointer just before the aligned block, so it works on any platform.
+// =============================================================================
+template<class T, size_t A>
+struct utils_aligned_allocator {
+
+    typedef T value_type;
+
+    template<class U>
+    struct rebind { typedef utils_aligned_allocator<U, A> other; };
+
+    utils_aligned_allocator() {}
+
+    template<class U>
+    utils_aligned_allocator(const utils_aligned_allocator<U, A>&) {}
+
+    T* allocate(size_t n) {
+        char* raw = static_cast<char*>(::operator new(n * sizeof(T) + A));
+        uintptr_t beg = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+        beg = (beg + A - 1) & ~(uintptr_t)(A - 1);
+        char* ptr = reinterpret_cast<char*>(beg);
+        reinterpret_cast<void**>(ptr)[-1] = raw;
+        return reinterpret_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t) {
+        ::operator delete(reinterpret_cast<void**>(ptr)[-1]);
+    }
+};
+
+template<class T, class U, size_t A>
+bool operator==(
+    const utils_aligned_allocator<T, A>&,
+    const utils_aligned_allocator<U, A>&) { return true; }
+
+template<class T, class U, size_t A>
+bool operator!=(
+    const utils_aligned_allocator<T, A>&,
+    const utils_aligned_allocator<U, A>&) { return false; }
+
 } // namespace BrainBlocks
 
 #endif // UTILS_HPP
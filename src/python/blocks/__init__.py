@@ -1,6 +1,7 @@
 from .blocks import BlankBlock
 from .blocks import ContextLearner
 from .blocks import DiscreteTransformer
+from .blocks import FrozenPooler
 from .blocks import PatternClassifier
 from .blocks import PatternClassifierDynamic
 from .blocks import PatternPooler
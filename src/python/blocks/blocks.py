@@ -10,7 +10,10 @@ class BitArray():
         self.obj = bitarray_obj
 
     def set_bits(self, new_bits=[]):
-        self.obj.set_bits(new_bits)
+        if isinstance(new_bits, np.ndarray):
+            self.obj.set_bits_array(new_bits)
+        else:
+            self.obj.set_bits(new_bits)
 
     def set_acts(self, new_acts=[]):
         self.obj.set_acts(new_acts)
@@ -92,6 +95,56 @@ class BlockMemory():
     def conns(self, d):
         return self.obj.conns(d)
 
+    def set_perm_bits(self, perm_bits=8):
+        self.obj.set_perm_bits(perm_bits)
+
+    def set_pool_cap(self, max_rpd, field=0):
+        self.obj.set_pool_cap(max_rpd, field)
+
+    def set_interleaved(self, flag=True):
+        self.obj.set_interleaved(flag)
+
+    @property
+    def is_interleaved(self):
+        return self.obj.is_interleaved
+
+    @property
+    def num_record_bytes(self):
+        return self.obj.num_record_bytes
+
+    def set_tiering(self, flag=True):
+        self.obj.set_tiering(flag)
+
+    def update_tiers(self, min_hits=1):
+        return self.obj.update_tiers(min_hits)
+
+    def decompress_all(self):
+        self.obj.decompress_all()
+
+    @property
+    def num_cold(self):
+        return self.obj.num_cold
+
+    def set_tracing(self, flag=True, max_trace=1048576):
+        self.obj.set_tracing(flag, max_trace)
+
+    def trace_step(self):
+        self.obj.trace_step()
+
+    def relayout(self):
+        self.obj.relayout()
+
+    def layout_report(self):
+        return self.obj.layout_report()
+
+    @property
+    def num_perm_bits(self):
+        return self.obj.num_perm_bits
+
+    @property
+    def version(self):
+        return self.obj.version
+
 # ==============================================================================
 # BlockOutput
 # ==============================================================================
@@ -135,6 +188,58 @@ class BlockOutput():
     def num_words(self):
         return BitArray(self.obj.state).num_words
 
+# ==============================================================================
+# EncodeCache
+# ==============================================================================
+class EncodeCache():
+
+    def __init__(self, encode_cache_obj):
+        self.obj = encode_cache_obj
+
+    def resize(self, capacity):
+        self.obj.resize(capacity)
+
+    def clear(self):
+        self.obj.clear()
+
+    @property
+    def capacity(self):
+        return self.obj.capacity
+
+    @property
+    def size(self):
+        return self.obj.size
+
+    @property
+    def num_hits(self):
+        return self.obj.num_hits
+
+    @property
+    def num_misses(self):
+        return self.obj.num_misses
+
+# ==============================================================================
+# OverlapTuner
+# ==============================================================================
+class OverlapTuner():
+
+    def __init__(self, overlap_tuner_obj):
+        self.obj = overlap_tuner_obj
+
+    def set_kernel(self, kernel):
+        self.obj.set_kernel(kernel)
+
+    def clear(self):
+        self.obj.clear()
+
+    @property
+    def kernel(self):
+        return self.obj.kernel
+
+    @property
+    def timings(self):
+        return self.obj.timings
+
 # ==============================================================================
 # BlankBlock
 # ==============================================================================
@@ -234,6 +339,48 @@ class DiscreteTransformer():
     def get_value(self):
         return self.obj.get_value()
 
+    def encode_batch(self, values):
+        return [BitArray(ba) for ba in self.obj.encode_batch(values)]
+
+    @property
+    def output(self):
+        return BlockOutput(self.obj.output)
+
+# ==============================================================================
+# FrozenPooler
+# ==============================================================================
+class FrozenPooler():
+
+    def __init__(
+            self,
+            num_s=512, # number of statelets
+            num_as=8,  # number of active statelets
+            num_t=2):  # number of BlockOutput time steps (optional)
+
+        self.obj = bb.FrozenPooler(num_s, num_as, num_t)
+
+    def save(self, file='./file.bin'):
+        self.obj.save(file.encode('utf-8'))
+
+    def load(self, file='./file.bin'):
+        self.obj.load(file.encode('utf-8'))
+
+    def clear(self):
+        self.obj.clear()
+
+    def feedforward(self):
+        self.obj.feedforward()
+
+    def get_labels(self):
+        return self.obj.get_labels()
+
+    def get_probabilities(self):
+        return self.obj.get_probabilities()
+
+    @property
+    def input(self):
+        return BlockInput(self.obj.input)
+
     @property
     def output(self):
         return BlockOutput(self.obj.output)
@@ -285,6 +432,17 @@ class PatternClassifier():
     def get_probabilities(self):
         return self.obj.get_probabilities()
 
+    def get_votes(self, votes):
+        return self.obj.get_votes(votes)
+
+    def fit_parallel(self, bits, labels, num_threads, num_epochs=1,
+                     merge_every=1024, merge_mode=bb.MERGE_AVERAGE):
+        self.obj.fit_parallel(bits, labels, num_threads, num_epochs,
+                              merge_every, merge_mode)
+
+    def freeze(self, frozen):
+        self.obj.freeze(frozen.obj)
+
     @property
     def input(self):
         return BlockInput(self.obj.input)
@@ -297,6 +455,10 @@ class PatternClassifier():
     def memory(self):
         return BlockMemory(self.obj.memory)
 
+    @property
+    def cache(self):
+        return EncodeCache(self.obj.cache)
+
 # ==============================================================================
 # PatternClassifierDynamic
 # ==============================================================================
@@ -347,6 +509,14 @@ class PatternClassifierDynamic():
     def get_probabilities(self):
         return self.obj.get_probabilities()
 
+    def fit_parallel(self, bits, labels, num_threads, num_epochs=1,
+                     merge_every=1024, merge_mode=bb.MERGE_AVERAGE):
+        self.obj.fit_parallel(bits, labels, num_threads, num_epochs,
+                              merge_every, merge_mode)
+
+    def freeze(self, frozen):
+        self.obj.freeze(frozen.obj)
+
     @property
     def input(self):
         return BlockInput(self.obj.input)
@@ -359,6 +529,10 @@ class PatternClassifierDynamic():
     def memory(self):
         return BlockMemory(self.obj.memory)
 
+    @property
+    def cache(self):
+        return EncodeCache(self.obj.cache)
+
 # ==============================================================================
 # PatternPooler
 # ==============================================================================
@@ -397,6 +571,27 @@ class PatternPooler():
     def feedforward(self, learn=False):
         self.obj.feedforward(learn)
 
+    def get_winners(self):
+        return self.obj.get_winners()
+
+    def encode_batch(self, inputs):
+        outputs = self.obj.encode_batch([ba.obj for ba in inputs])
+        return [BitArray(ba) for ba in outputs]
+
+    def autotune(self, bits, learn_flag=False):
+        return self.obj.autotune(bits, learn_flag)
+
+    def set_autotune(self, pct_active, num_samples=64):
+        self.obj.set_autotune(pct_active, num_samples)
+
+    def fit_parallel(self, bits, num_threads, num_epochs=1,
+                     merge_every=1024, merge_mode=bb.MERGE_AVERAGE):
+        self.obj.fit_parallel(bits, num_threads, num_epochs, merge_every,
+                              merge_mode)
+
+    def freeze(self, frozen):
+        self.obj.freeze(frozen.obj)
+
     @property
     def input(self):
         return BlockInput(self.obj.input)
@@ -409,6 +604,14 @@ class PatternPooler():
     def memory(self):
         return BlockMemory(self.obj.memory)
 
+    @property
+    def cache(self):
+        return EncodeCache(self.obj.cache)
+
+    @property
+    def tuner(self):
+        return OverlapTuner(self.obj.tuner)
+
 # ==============================================================================
 # PersistenceTransformer
 # ==============================================================================
@@ -470,6 +673,9 @@ class ScalarTransformer():
     def get_value(self):
         return self.obj.get_value()
 
+    def encode_batch(self, values):
+        return [BitArray(ba) for ba in self.obj.encode_batch(values)]
+
     @property
     def output(self):
         return BlockOutput(self.obj.output)
@@ -512,9 +718,21 @@ class SequenceLearner():
     def feedforward(self, learn=False):
         self.obj.feedforward(learn)
 
+    def feedforward_acts(self, acts, learn=False):
+        self.obj.feedforward_acts(acts, learn)
+
     def get_anomaly_score(self):
         return self.obj.get_anomaly_score()
 
+    def set_prefetch(self, depth, inputs=False):
+        self.obj.set_prefetch(depth, inputs)
+
+    def get_prefetch(self):
+        return self.obj.get_prefetch()
+
+    def backfill(self, bits, num_threads=1, warmup=0):
+        return self.obj.backfill(bits, num_threads, warmup)
+
     @property
     def input(self):
         return BlockInput(self.obj.input)
@@ -17,6 +17,7 @@ class BBClassifier:
                  # Training Arguments
                  num_epochs=3,
                  use_undefined_class=False,
+                 num_threads=1,
 
                  # Distributed Pattern Classifier Arguments
                  num_l=2,       # number of labels
@@ -25,6 +26,8 @@ class BBClassifier:
                  pct_pool=0.8,  # percent pooled
                  pct_conn=0.8,  # percent initially connected
                  pct_learn=0.3, # percent learn
+                 max_rpd=0,     # receptors per detector cap (0 is uncapped)
+                 pool_field=0,  # input bits per detector field (0 is all)
                  seed=0,
 
                  # HyperGrid Transform Arguments
@@ -55,6 +58,11 @@ class BBClassifier:
         use_undefined_class: boolean
         Whether to reserve a class for test samples that have no training data
 
+        num_threads: integer
+        Number of threads to train with. Above 1, replicas of the classifier
+        are trained on shards of the data and merged (no training probabilities
+        are recorded).
+
         num_s: integer
         Number of class detectors to allocate for the distributed pattern classifier
 
@@ -70,6 +78,14 @@ class BBClassifier:
         pct_learn: float, Between 0.0 and 1.0
         Percentage of bits to update when training occurs.
 
+        max_rpd: integer
+        Maximum receptors per detector. Above 0, each detector samples at most
+        max_rpd bits so memory does not grow with the input width.
+
+        pool_field: integer
+        With max_rpd, number of contiguous input bits each detector samples
+        from (a local receptive field). 0 samples from the whole input.
+
         num_bins: integer
         Number of bins to create for each grid.
 
@@ -119,6 +135,9 @@ class BBClassifier:
         """
 
         self.num_epochs = num_epochs
+        self.max_rpd = max_rpd
+        self.pool_field = pool_field
+        self.num_threads = num_threads
         self.use_undefined_class = use_undefined_class
         self._y = []
         self.classes_ = np.array([])
@@ -238,6 +257,9 @@ class BBClassifier:
         # Create PatternClassifier block
         self.dpc = PatternClassifier(**self.dpc_config)
 
+        if self.max_rpd > 0:
+            self.dpc.memory.set_pool_cap(self.max_rpd, self.pool_field)
+
         #print("PatternClassifier:")
         #self.dpc.print_parameters()
 
@@ -369,6 +391,15 @@ class BBClassifier:
     def _fit(self, X, y):
 
         probabilities = []
+
+        # train pattern classifier replicas in parallel
+        if self.num_threads > 1:
+            self.dpc.init()
+            self.dpc.fit_parallel(
+                np.asarray(X, dtype=np.uint8), np.asarray(y, dtype=np.uint32),
+                self.num_threads, self.num_epochs)
+            return np.asarray(probabilities)
+
         # train pattern classifier
         for i in range(self.num_epochs):
             epoch_probs = []
@@ -10,10 +10,17 @@
 #include "block_input.hpp"
 #include "block_memory.hpp"
 #include "block_output.hpp"
+#include "encode_cache.hpp"
+#include "overlap_tuner.hpp"
+#include "sdr_dataset.hpp"
+#include "sdr_index.hpp"
+#include "sdr_trace.hpp"
+#include "sweep_runner.hpp"
 
 #include "blocks/blank_block.hpp"
 #include "blocks/context_learner.hpp"
 #include "blocks/discrete_transformer.hpp"
+#include "blocks/frozen_pooler.hpp"
 #include "blocks/pattern_classifier.hpp"
 #include "blocks/pattern_classifier_dynamic.hpp"
 #include "blocks/pattern_pooler.hpp"
@@ -29,6 +36,27 @@ using namespace py::literals;
 
 using namespace BrainBlocks;
 
+typedef py::array_t<uint8_t, py::array::c_style | py::array::forcecast> bits_t;
+
+// Converts a 2D array of bits (one row per sample) into BitArrays of num_b bits
+std::vector<BitArray> to_bitarrays(bits_t bits, const uint32_t num_b) {
+
+    py::buffer_info info = bits.request();
+
+    if (info.ndim != 2 || (uint32_t)info.shape[1] > num_b)
+        throw std::runtime_error("bits must be 2D with at most num_b columns");
+
+    uint32_t num_rows = (uint32_t)info.shape[0];
+    uint32_t num_cols = (uint32_t)info.shape[1];
+    const uint8_t* ptr = (const uint8_t*)info.ptr;
+    std::vector<BitArray> bas(num_rows, BitArray(num_b));
+
+    for (uint32_t r = 0; r < num_rows; r++)
+        bas[r].set_bits(&ptr[r * num_cols], num_cols);
+
+    return bas;
+}
+
 PYBIND11_MODULE(bb_backend, m) {
     m.doc() = R"pbdoc(
         BrainBlocks Python Module
@@ -40,6 +68,7 @@ PYBIND11_MODULE(bb_backend, m) {
            :toctree: _generate
 
            BlankBlock
+           FrozenPooler
            ScalarTransformer
            SymbolsEncoder
            PersistenceTransformer
@@ -57,15 +86,38 @@ PYBIND11_MODULE(bb_backend, m) {
     // =========================================================================
     py::class_<BitArray>(m, "BitArray")
 
-        .def("set_bits", &BitArray::set_bits,
+        .def(py::init<const uint32_t>(), "Constructs a BitArray", "n"_a)
+
+        .def("set_bits",
+             static_cast<void (BitArray::*)(std::vector<uint8_t>&)>(
+                 &BitArray::set_bits),
              "Set the BitArray from a vector of bits", "bits"_a)
 
+        .def("set_bits_array",
+             [](BitArray& ba, bits_t bits) {
+                 py::buffer_info info = bits.request();
+                 uint32_t n = (uint32_t)info.shape[0];
+                 if (info.ndim != 1 || n > ba.num_bits())
+                     throw std::runtime_error("bits must be 1D with at most "
+                                              "num_bits values");
+                 ba.set_bits((const uint8_t*)info.ptr, n); },
+             "Set the BitArray from a numpy array of bits", "bits"_a)
+
         .def("set_acts", &BitArray::set_acts,
              "Set the BitArray from a vector of acts", "acts"_a)
 
-        .def("get_bits", &BitArray::get_bits,
+        .def("get_bits",
+             static_cast<std::vector<uint8_t> (BitArray::*)()>(
+                 &BitArray::get_bits),
              "Returns a vector of bits from the BitArray")
 
+        .def("get_bits_array",
+             [](BitArray& ba) {
+                 bits_t bits(ba.num_bits());
+                 ba.get_bits(bits.mutable_data());
+                 return bits; },
+             "Returns a numpy array of bits from the BitArray")
+
         .def("get_acts", &BitArray::get_acts,
              "Returns a vector of acts from the BitArray")
 
@@ -137,6 +189,17 @@ PYBIND11_MODULE(bb_backend, m) {
     // =========================================================================
     // BlockMemory
     // =========================================================================
+    py::class_<LayoutReport>(m, "LayoutReport")
+
+        .def_readonly("num_steps", &LayoutReport::num_steps,
+                      "Returns number of traced steps")
+
+        .def_readonly("lines_per_step", &LayoutReport::lines_per_step,
+                      "Returns mean distinct cache lines touched per step")
+
+        .def_readonly("pages_per_step", &LayoutReport::pages_per_step,
+                      "Returns mean distinct pages touched per step");
+
     py::class_<BlockMemory>(m, "BlockMemory")
 
         .def("addrs", &BlockMemory::addrs,
@@ -148,8 +211,69 @@ PYBIND11_MODULE(bb_backend, m) {
         .def("conns", &BlockMemory::conns,
              "Returns a particular dendrite's receptor connections", "d"_a)
 
+        .def("set_perm_bits", &BlockMemory::set_perm_bits,
+             "Sets permanence precision (8, 4 or 2 bits) used by init",
+             "perm_bits"_a)
+
+        .def("set_tiering", &BlockMemory::set_tiering,
+             "Turns hot/cold dendrite tiering on or off", "flag"_a)
+
+        .def("update_tiers", &BlockMemory::update_tiers,
+             "Compresses rarely accessed dendrites and returns the number "
+             "of cold dendrites", "min_hits"_a)
+
+        .def("decompress_all", &BlockMemory::decompress_all,
+             "Decompresses all cold dendrites")
+
+        .def_property_readonly("num_cold", &BlockMemory::num_cold,
+                               "Returns number of cold dendrites")
+
+        .def("set_tracing", &BlockMemory::set_tracing,
+             "Turns recording of a dendrite co-activation trace on or off",
+             "flag"_a, "max_trace"_a=1048576)
+
+        .def("trace_step", &BlockMemory::trace_step,
+             "Starts a new step in the dendrite co-activation trace")
+
+        .def("relayout", &BlockMemory::relayout,
+             "Reorders dendrite storage by traced co-activation")
+
+        .def("layout_report", &BlockMemory::layout_report,
+             "Returns cache lines and pages touched per traced step")
+
+        .def("set_pool_cap", &BlockMemory::set_pool_cap,
+             "Caps receptors per dendrite (and optionally the input field) "
+             "used by init", "max_rpd"_a, "field"_a=0)
+
+        .def("set_interleaved", &BlockMemory::set_interleaved,
+             "Stores each dendrite as one aligned record (used by init)",
+             "flag"_a)
+
+        .def_property_readonly("is_interleaved", &BlockMemory::is_interleaved,
+                               "Returns true if dendrites are records")
+
+        .def_property_readonly("num_record_bytes",
+                               &BlockMemory::num_record_bytes,
+                               "Returns bytes of receptor storage per dendrite")
+
         .def_property_readonly("num_dendrites", &BlockMemory::num_dendrites,
-                               "Returns number of dendrites");
+                               "Returns number of dendrites")
+
+        .def_property_readonly("num_receptors", &BlockMemory::num_receptors,
+                               "Returns number of receptors")
+
+        .def_property_readonly("num_receptors_per_dendrite",
+                               &BlockMemory::num_receptors_per_dendrite,
+                               "Returns number of receptors per dendrite")
+
+        .def_property_readonly("num_perm_bits", &BlockMemory::num_perm_bits,
+                               "Returns number of bits per permanence")
+
+        .def_property_readonly("version", &BlockMemory::version,
+                               "Returns a value that changes with memories");
+
+    m.attr("MERGE_AVERAGE") = MERGE_AVERAGE;
+    m.attr("MERGE_DELTA") = MERGE_DELTA;
 
 
     // =========================================================================
@@ -166,6 +290,361 @@ PYBIND11_MODULE(bb_backend, m) {
         .def_readonly("state", &BlockOutput::state,
                       "Returns state BitArray object");
 
+    // =========================================================================
+    // EncodeCache
+    // =========================================================================
+    py::class_<EncodeCache>(m, "EncodeCache")
+
+        .def("resize", &EncodeCache::resize,
+             "Sets the maximum number of entries (0 = disabled) and clears",
+             "capacity"_a)
+
+        .def("clear", &EncodeCache::clear,
+             "Drops all entries and resets the hit and miss counters")
+
+        .def_property_readonly("capacity", &EncodeCache::capacity,
+                               "Returns maximum number of entries")
+
+        .def_property_readonly("size", &EncodeCache::size,
+                               "Returns number of entries")
+
+        .def_property_readonly("num_hits", &EncodeCache::num_hits,
+                               "Returns number of cache hits")
+
+        .def_property_readonly("num_misses", &EncodeCache::num_misses,
+                               "Returns number of cache misses");
+
+    // =========================================================================
+    // OverlapTuner
+    // =========================================================================
+    py::class_<OverlapTuner>(m, "OverlapTuner")
+
+        .def("set_kernel", &OverlapTuner::set_kernel,
+             "Selects the overlap kernel", "kernel"_a)
+
+        .def("clear", &OverlapTuner::clear,
+             "Frees the derived overlap structures")
+
+        .def_property_readonly("kernel", &OverlapTuner::get_kernel,
+                               "Returns the selected overlap kernel")
+
+        .def_property_readonly("timings", &OverlapTuner::get_timings,
+                               "Returns seconds per input of each kernel");
+
+    m.attr("KERNEL_SCAN") = KERNEL_SCAN;
+    m.attr("KERNEL_CONN") = KERNEL_CONN;
+    m.attr("KERNEL_INDEX") = KERNEL_INDEX;
+    m.attr("KERNEL_SLICED") = KERNEL_SLICED;
+
+    // =========================================================================
+    // SDRDataset
+    // =========================================================================
+    py::class_<SDRDatasetWriter>(m, "SDRDatasetWriter")
+
+        .def(py::init<>(), "Constructs an SDRDatasetWriter")
+
+        .def("open", &SDRDatasetWriter::open,
+             "Creates a dataset file", "file"_a, "num_b"_a,
+             "flags"_a=SDR_LABELS)
+
+        .def("close", &SDRDatasetWriter::close,
+             "Writes labels, timestamps and row count and closes the file")
+
+        .def("add", &SDRDatasetWriter::add,
+             "Appends a row", "ba"_a, "label"_a=0, "time"_a=0)
+
+        .def("add_bits",
+             [](SDRDatasetWriter& w, bits_t bits, std::vector<uint32_t> labels,
+                const uint32_t num_b) {
+                 std::vector<BitArray> bas = to_bitarrays(bits, num_b);
+                 if (!labels.empty() && labels.size() != bas.size())
+                     throw std::runtime_error("need one label per row");
+                 for (uint32_t i = 0; i < bas.size(); i++)
+                     w.add(bas[i], labels.empty() ? 0 : labels[i]); },
+             "Appends rows of bits", "bits"_a, "labels"_a, "num_b"_a)
+
+        .def_property_readonly("num_rows", &SDRDatasetWriter::num_rows,
+                               "Returns number of rows written");
+
+    py::class_<SDRDataset>(m, "SDRDataset")
+
+        .def(py::init<>(), "Constructs an SDRDataset")
+
+        .def("open", &SDRDataset::open, "Maps a dataset file", "file"_a)
+
+        .def("close", &SDRDataset::close, "Unmaps the dataset file")
+
+        .def("get_row",
+             [](SDRDataset& d, const uint32_t r) {
+                 BitArray ba(d.num_bits());
+                 d.get_row(r, ba);
+                 return ba; },
+             "Returns a row as a BitArray", "r"_a)
+
+        .def("label", &SDRDataset::label, "Returns a row's label", "r"_a)
+
+        .def("timestamp", &SDRDataset::timestamp,
+             "Returns a row's timestamp", "r"_a)
+
+        .def_property_readonly("num_bits", &SDRDataset::num_bits,
+                               "Returns number of bits per row")
+
+        .def_property_readonly("num_rows", &SDRDataset::num_rows,
+                               "Returns number of rows")
+
+        .def_property_readonly("has_labels", &SDRDataset::has_labels,
+                               "Returns true if rows have labels")
+
+        .def_property_readonly("has_timestamps", &SDRDataset::has_timestamps,
+                               "Returns true if rows have timestamps")
+
+        .def("loader",
+             [](SDRDataset& d, const uint32_t batch_size, const bool shuffle,
+                const uint32_t seed) {
+                 return new SDRLoader(d, batch_size, shuffle, seed); },
+             "Returns an epoch loader that keeps the dataset alive",
+             "batch_size"_a, "shuffle"_a=true, "seed"_a=0,
+             py::keep_alive<0, 1>());
+
+    py::class_<SDRLoader>(m, "SDRLoader")
+
+        .def("start_epoch", &SDRLoader::start_epoch,
+             "Reshuffles and starts prefetching the next epoch")
+
+        .def("next",
+             [](SDRLoader& l) -> py::object {
+                 std::vector<BitArray> rows;
+                 std::vector<uint32_t> labels;
+                 bool ok;
+                 {
+                     py::gil_scoped_release release;
+                     ok = l.next(rows, labels);
+                 }
+                 if (!ok)
+                     return py::none();
+                 return py::make_tuple(rows, labels); },
+             "Returns the next (rows, labels) batch or None at epoch end")
+
+        .def_property_readonly("num_batches", &SDRLoader::num_batches,
+                               "Returns number of batches per epoch");
+
+    m.attr("SDR_LABELS") = SDR_LABELS;
+    m.attr("SDR_TIMESTAMPS") = SDR_TIMESTAMPS;
+
+    // =========================================================================
+    // SDRIndex
+    // =========================================================================
+    py::class_<SDRMatch>(m, "SDRMatch")
+
+        .def_readonly("id", &SDRMatch::id, "Returns entry id")
+
+        .def_readonly("score", &SDRMatch::score, "Returns similarity score");
+
+    py::class_<SDRIndex>(m, "SDRIndex")
+
+        .def(py::init<>(), "Constructs an SDRIndex")
+
+        .def("init", &SDRIndex::init,
+             "Sets the number of bits per entry", "num_b"_a)
+
+        .def("clear", &SDRIndex::clear, "Removes all entries")
+
+        .def("save", &SDRIndex::save, "Saves index to file", "file"_a)
+
+        .def("load", &SDRIndex::load, "Loads index from file", "file"_a)
+
+        .def("map", &SDRIndex::map, "Maps index file read-only", "file"_a)
+
+        .def("insert", &SDRIndex::insert,
+             "Adds a BitArray under an id", "id"_a, "ba"_a)
+
+        .def("query", &SDRIndex::query,
+             "Returns top k most similar entries",
+             "ba"_a, "k"_a, "metric"_a=SDR_OVERLAP)
+
+        .def("query_batch", &SDRIndex::query_batch,
+             "Returns top k most similar entries for each BitArray",
+             "bas"_a, "k"_a, "metric"_a=SDR_OVERLAP)
+
+        .def("memory_usage", &SDRIndex::memory_usage,
+             "Returns memory usage in bytes")
+
+        .def_property_readonly("num_bits", &SDRIndex::num_bits,
+                               "Returns number of bits per entry")
+
+        .def_property_readonly("num_entries", &SDRIndex::num_entries,
+                               "Returns number of entries")
+
+        .def_property_readonly("is_mapped", &SDRIndex::is_mapped,
+                               "Returns true if index is mapped from file");
+
+    m.attr("SDR_OVERLAP") = SDR_OVERLAP;
+    m.attr("SDR_JACCARD") = SDR_JACCARD;
+
+    // =========================================================================
+    // SDRTrace
+    // =========================================================================
+    py::class_<SDRTraceRecorder>(m, "SDRTraceRecorder")
+
+        .def(py::init<>(), "Constructs an SDRTraceRecorder")
+
+        .def("add_source",
+             [](SDRTraceRecorder& r, BlockOutput& src) { r.add_source(&src); },
+             "Adds a BlockOutput to record", "src"_a, py::keep_alive<1, 2>())
+
+        .def("open", &SDRTraceRecorder::open,
+             "Starts recording to rolling files", "prefix"_a,
+             "max_bytes"_a=(64 << 20), "max_files"_a=4)
+
+        .def("close", &SDRTraceRecorder::close,
+             "Flushes and closes the current file")
+
+        .def("record", &SDRTraceRecorder::record,
+             "Appends the current source states as one frame", "learn_flag"_a)
+
+        .def("file_name", &SDRTraceRecorder::file_name,
+             "Returns the name of the nth file", "n"_a)
+
+        .def_property_readonly("num_files", &SDRTraceRecorder::num_files,
+                               "Returns number of files opened")
+
+        .def_property_readonly("num_frames", &SDRTraceRecorder::num_frames,
+                               "Returns number of frames recorded");
+
+    py::class_<SDRTraceReplayer>(m, "SDRTraceReplayer")
+
+        .def(py::init<>(), "Constructs an SDRTraceReplayer")
+
+        .def("open", &SDRTraceReplayer::open, "Maps a trace file", "file"_a)
+
+        .def("close", &SDRTraceReplayer::close, "Unmaps the trace file")
+
+        .def("step", &SDRTraceReplayer::step,
+             "Feeds the next recorded frame forward")
+
+        .def("output", &SDRTraceReplayer::output,
+             "Returns the BlockOutput replaying a source", "s"_a,
+             py::return_value_policy::reference_internal)
+
+        .def_property_readonly("num_sources", &SDRTraceReplayer::num_sources,
+                               "Returns number of recorded sources")
+
+        .def_property_readonly("learn_flag", &SDRTraceReplayer::learn_flag,
+                               "Returns the learn flag of the current frame");
+
+    // =========================================================================
+    // SweepRunner
+    // =========================================================================
+    py::class_<SweepConfig>(m, "SweepConfig")
+
+        .def(py::init<>(), "Constructs a default SweepConfig")
+
+        .def_readwrite("type", &SweepConfig::type, "block type")
+
+        .def_readwrite("num_l", &SweepConfig::num_l, "number of labels")
+
+        .def_readwrite("num_s", &SweepConfig::num_s, "number of statelets")
+
+        .def_readwrite("num_as", &SweepConfig::num_as, "number of active statelets")
+
+        .def_readwrite("num_spl", &SweepConfig::num_spl, "number of statelets per label")
+
+        .def_readwrite("perm_thr", &SweepConfig::perm_thr, "permanence threshold")
+
+        .def_readwrite("perm_inc", &SweepConfig::perm_inc, "permanence increment")
+
+        .def_readwrite("perm_dec", &SweepConfig::perm_dec, "permanence decrement")
+
+        .def_readwrite("pct_pool", &SweepConfig::pct_pool, "percent pooled")
+
+        .def_readwrite("pct_conn", &SweepConfig::pct_conn, "percent initially connected")
+
+        .def_readwrite("pct_learn", &SweepConfig::pct_learn, "percent learn")
+
+        .def_readwrite("num_spc", &SweepConfig::num_spc, "number of statelets per column")
+
+        .def_readwrite("num_dps", &SweepConfig::num_dps, "number of dendrites per statelet")
+
+        .def_readwrite("num_rpd", &SweepConfig::num_rpd, "number of receptors per dendrite")
+
+        .def_readwrite("d_thresh", &SweepConfig::d_thresh, "dendrite threshold")
+
+        .def_readwrite("num_epochs", &SweepConfig::num_epochs, "number of training passes")
+
+        .def_readwrite("seed", &SweepConfig::seed, "seed for random number generator");
+
+    py::class_<SweepResult>(m, "SweepResult")
+
+        .def_readonly("accuracy", &SweepResult::accuracy,
+                      "Returns fraction of test samples classified correctly")
+
+        .def_readonly("mean_anomaly", &SweepResult::mean_anomaly,
+                      "Returns mean anomaly score over test samples")
+
+        .def_readonly("train_time", &SweepResult::train_time,
+                      "Returns seconds spent training")
+
+        .def_readonly("test_time", &SweepResult::test_time,
+                      "Returns seconds spent testing")
+
+        .def_readonly("memory_usage", &SweepResult::memory_usage,
+                      "Returns bytes used by the trained blocks");
+
+    py::class_<SweepRunner>(m, "SweepRunner")
+
+        .def(py::init<const uint32_t>(), "Constructs a SweepRunner", "num_b"_a)
+
+        .def("add_train", &SweepRunner::add_train,
+             "Appends an encoded training sample", "ba"_a, "label"_a=0)
+
+        .def("add_test", &SweepRunner::add_test,
+             "Appends an encoded test sample", "ba"_a, "label"_a=0)
+
+        .def("add_train_bits",
+             [](SweepRunner& sr, bits_t bits, std::vector<uint32_t> labels) {
+                 std::vector<BitArray> bas = to_bitarrays(bits, sr.num_bits());
+                 if (labels.size() != bas.size())
+                     throw std::runtime_error("need one label per row");
+                 for (uint32_t i = 0; i < bas.size(); i++)
+                     sr.add_train(bas[i], labels[i]); },
+             "Appends rows of encoded training bits", "bits"_a, "labels"_a)
+
+        .def("add_test_bits",
+             [](SweepRunner& sr, bits_t bits, std::vector<uint32_t> labels) {
+                 std::vector<BitArray> bas = to_bitarrays(bits, sr.num_bits());
+                 if (labels.size() != bas.size())
+                     throw std::runtime_error("need one label per row");
+                 for (uint32_t i = 0; i < bas.size(); i++)
+                     sr.add_test(bas[i], labels[i]); },
+             "Appends rows of encoded test bits", "bits"_a, "labels"_a)
+
+        .def("clear", &SweepRunner::clear, "Removes all samples")
+
+        .def("run", &SweepRunner::run,
+             "Trains and evaluates one configuration", "config"_a,
+             py::call_guard<py::gil_scoped_release>())
+
+        .def("run_all", &SweepRunner::run_all,
+             "Trains and evaluates configurations on a thread pool",
+             "configs"_a, "num_threads"_a,
+             py::call_guard<py::gil_scoped_release>())
+
+        .def("memory_usage", &SweepRunner::memory_usage,
+             "Returns memory usage of the shared samples in bytes")
+
+        .def_property_readonly("num_bits", &SweepRunner::num_bits,
+                               "Returns number of bits per sample")
+
+        .def_property_readonly("num_train", &SweepRunner::num_train,
+                               "Returns number of training samples")
+
+        .def_property_readonly("num_test", &SweepRunner::num_test,
+                               "Returns number of test samples");
+
+    m.attr("SWEEP_CLASSIFIER") = SWEEP_CLASSIFIER;
+    m.attr("SWEEP_CLASSIFIER_DYNAMIC") = SWEEP_CLASSIFIER_DYNAMIC;
+    m.attr("SWEEP_ANOMALY") = SWEEP_ANOMALY;
+
     // =========================================================================
     // BlankBlock
     // =========================================================================
@@ -244,9 +723,43 @@ PYBIND11_MODULE(bb_backend, m) {
         .def("get_value", &DiscreteTransformer::get_value,
              "Returns value")
 
+        .def("encode_batch",
+             [](DiscreteTransformer& b, std::vector<uint32_t> values) {
+                 std::vector<BitArray> outputs;
+                 b.encode_batch(values, outputs);
+                 return outputs; },
+             "Returns a list of encoded BitArrays, one per value",
+             "values"_a)
+
         .def_readonly("output", &DiscreteTransformer::output,
                       "Returns output BlockOutput object");
 
+    // =========================================================================
+    // FrozenPooler
+    // =========================================================================
+    py::class_<FrozenPooler, Block>(m, "FrozenPooler")
+
+        .def(py::init<
+            const uint32_t,
+            const uint32_t,
+            const uint32_t>(),
+        "num_s"_a,
+        "num_as"_a,
+        "num_t"_a=2,
+        "Constructs a FrozenPooler")
+
+        .def("get_labels", &FrozenPooler::get_labels,
+             "Returns array of stored labels")
+
+        .def("get_probabilities", &FrozenPooler::get_probabilities,
+             "Returns array of probability scores for each stored label")
+
+        .def_readonly("input", &FrozenPooler::input,
+                      "Returns input BlockInput object")
+
+        .def_readonly("output", &FrozenPooler::output,
+                      "Returns output BlockOutput object");
+
     // =========================================================================
     // PatternClassifier
     // =========================================================================
@@ -286,6 +799,32 @@ PYBIND11_MODULE(bb_backend, m) {
         .def("get_probabilities", &PatternClassifier::get_probabilities,
              "Returns array of probability scores for each stored label")
 
+        .def("get_votes",
+             [](PatternClassifier& pc, py::array_t<uint32_t> votes) {
+                 py::buffer_info info = votes.request(true);
+                 if (info.ndim != 1 ||
+                     (uint32_t)info.shape[0] != pc.num_labels())
+                     throw std::runtime_error("votes must have num_l values");
+                 return pc.get_votes((uint32_t*)info.ptr); },
+             "Writes label votes into array and returns the top label",
+             "votes"_a)
+
+        .def("fit_parallel",
+             [](PatternClassifier& pc, bits_t bits, std::vector<uint32_t> labels,
+                const uint32_t num_threads, const uint32_t num_epochs,
+                const uint32_t merge_every, const uint8_t merge_mode) {
+                 std::vector<BitArray> inputs =
+                     to_bitarrays(bits, pc.input.state.num_bits());
+                 py::gil_scoped_release release;
+                 pc.fit_parallel(inputs, labels, num_threads, num_epochs,
+                                 merge_every, merge_mode); },
+             "Trains on rows of input bits and labels with parallel replicas",
+             "bits"_a, "labels"_a, "num_threads"_a, "num_epochs"_a=1,
+             "merge_every"_a=1024, "merge_mode"_a=MERGE_AVERAGE)
+
+        .def("freeze", &PatternClassifier::freeze, "frozen"_a,
+             "Exports the trained block into a FrozenPooler")
+
         .def_readonly("input", &PatternClassifier::input,
                       "Returns input BlockInput object")
 
@@ -293,7 +832,12 @@ PYBIND11_MODULE(bb_backend, m) {
                       "Returns output BlockOutput object")
 
         .def_readonly("memory", &PatternClassifier::memory,
-                      "Returns memory BlockMemory object");
+                      "Returns memory BlockMemory object")
+
+        .def_property_readonly("cache",
+             [](PatternClassifier& b) -> EncodeCache& { return b.cache; },
+             py::return_value_policy::reference_internal,
+             "Returns encode cache EncodeCache object");
 
     // =========================================================================
     // PatternClassifierDynamic
@@ -337,6 +881,22 @@ PYBIND11_MODULE(bb_backend, m) {
         .def("get_probabilities", &PatternClassifierDynamic::get_probabilities,
              "Returns array of probability scores for each stored label")
 
+        .def("fit_parallel",
+             [](PatternClassifierDynamic& pcd, bits_t bits, std::vector<uint32_t> labels,
+                const uint32_t num_threads, const uint32_t num_epochs,
+                const uint32_t merge_every, const uint8_t merge_mode) {
+                 std::vector<BitArray> inputs =
+                     to_bitarrays(bits, pcd.input.state.num_bits());
+                 py::gil_scoped_release release;
+                 pcd.fit_parallel(inputs, labels, num_threads, num_epochs,
+                                 merge_every, merge_mode); },
+             "Trains on rows of input bits and labels with parallel replicas",
+             "bits"_a, "labels"_a, "num_threads"_a, "num_epochs"_a=1,
+             "merge_every"_a=1024, "merge_mode"_a=MERGE_AVERAGE)
+
+        .def("freeze", &PatternClassifierDynamic::freeze, "frozen"_a,
+             "Exports the trained block into a FrozenPooler")
+
         .def_readonly("input", &PatternClassifierDynamic::input,
                       "Returns input BlockInput object")
 
@@ -344,7 +904,12 @@ PYBIND11_MODULE(bb_backend, m) {
                       "Returns output BlockOutput object")
 
         .def_readonly("memory", &PatternClassifierDynamic::memory,
-                      "Returns memory BlockMemory object");
+                      "Returns memory BlockMemory object")
+
+        .def_property_readonly("cache",
+             [](PatternClassifierDynamic& b) -> EncodeCache& { return b.cache; },
+             py::return_value_policy::reference_internal,
+             "Returns encode cache EncodeCache object");
 
     // =========================================================================
     // PatternPooler
@@ -376,6 +941,49 @@ PYBIND11_MODULE(bb_backend, m) {
         "seed"_a,
         "Constructs a PatternPooler")
 
+        .def("get_winners", &PatternPooler::get_winners,
+             "Returns the active statelets in output in ascending order")
+
+        .def("encode_batch",
+             [](PatternPooler& pp, std::vector<BitArray> inputs) {
+                 std::vector<BitArray> outputs;
+                 {
+                     py::gil_scoped_release release;
+                     pp.encode_batch(inputs, outputs);
+                 }
+                 return outputs; },
+             "Returns a list of encoded BitArrays, one per input BitArray",
+             "inputs"_a)
+
+        .def("autotune",
+             [](PatternPooler& pp, bits_t bits, const bool learn_flag) {
+                 std::vector<BitArray> inputs =
+                     to_bitarrays(bits, pp.input.state.num_bits());
+                 py::gil_scoped_release release;
+                 return pp.autotune(inputs, learn_flag); },
+             "Selects the fastest overlap kernel on rows of input bits",
+             "bits"_a, "learn_flag"_a=false)
+
+        .def("set_autotune", &PatternPooler::set_autotune,
+             "Autotunes the overlap kernel on random inputs at init",
+             "pct_active"_a, "num_samples"_a=64)
+
+        .def("fit_parallel",
+             [](PatternPooler& pp, bits_t bits, const uint32_t num_threads,
+                const uint32_t num_epochs, const uint32_t merge_every,
+                const uint8_t merge_mode) {
+                 std::vector<BitArray> inputs =
+                     to_bitarrays(bits, pp.input.state.num_bits());
+                 py::gil_scoped_release release;
+                 pp.fit_parallel(inputs, num_threads, num_epochs,
+                                 merge_every, merge_mode); },
+             "Trains on rows of input bits with parallel replicas",
+             "bits"_a, "num_threads"_a, "num_epochs"_a=1,
+             "merge_every"_a=1024, "merge_mode"_a=MERGE_AVERAGE)
+
+        .def("freeze", &PatternPooler::freeze, "frozen"_a,
+             "Exports the trained block into a FrozenPooler")
+
         .def_readonly("input", &PatternPooler::input,
                       "Returns input BlockInput object")
 
@@ -383,7 +991,17 @@ PYBIND11_MODULE(bb_backend, m) {
                       "Returns output BlockOutput object")
 
         .def_readonly("memory", &PatternPooler::memory,
-                      "Returns memory BlockMemory object");
+                      "Returns memory BlockMemory object")
+
+        .def_property_readonly("cache",
+             [](PatternPooler& b) -> EncodeCache& { return b.cache; },
+             py::return_value_policy::reference_internal,
+             "Returns encode cache EncodeCache object")
+
+        .def_property_readonly("tuner",
+             [](PatternPooler& b) -> OverlapTuner& { return b.tuner; },
+             py::return_value_policy::reference_internal,
+             "Returns overlap kernel OverlapTuner object");
 
     // =========================================================================
     // PersistenceTransformer
@@ -438,6 +1056,14 @@ PYBIND11_MODULE(bb_backend, m) {
         .def("get_value", &ScalarTransformer::get_value,
              "Returns value")
 
+        .def("encode_batch",
+             [](ScalarTransformer& b, std::vector<double> values) {
+                 std::vector<BitArray> outputs;
+                 b.encode_batch(values, outputs);
+                 return outputs; },
+             "Returns a list of encoded BitArrays, one per value",
+             "values"_a)
+
         .def_readonly("output", &ScalarTransformer::output,
                       "Returns output BlockOutput object");
 
@@ -474,6 +1100,35 @@ PYBIND11_MODULE(bb_backend, m) {
         .def("get_anomaly_score", &SequenceLearner::get_anomaly_score,
              "Returns anomaly score")
 
+        .def("set_prefetch", &SequenceLearner::set_prefetch,
+             "Sets how many active columns recognition prefetches ahead",
+             "depth"_a, "inputs"_a=false)
+
+        .def("get_prefetch", &SequenceLearner::get_prefetch,
+             "Returns the recognition prefetch depth")
+
+        .def("feedforward_acts", &SequenceLearner::feedforward_acts,
+             "Performs feedforward with the active input columns given "
+             "directly", "acts"_a, "learn_flag"_a=false)
+
+        .def("backfill",
+             [](SequenceLearner& sl, bits_t bits, const uint32_t num_threads,
+                const uint32_t warmup) {
+                 std::vector<BitArray> inputs =
+                     to_bitarrays(bits, sl.input.state.num_bits());
+                 std::vector<double> scores;
+                 std::vector<double> divergence;
+                 {
+                     py::gil_scoped_release release;
+                     scores = sl.backfill(
+                         inputs, num_threads, warmup, &divergence);
+                 }
+                 return py::make_tuple(scores, divergence); },
+             "Scores rows of input bits in parallel chunks without learning "
+             "and returns (scores, boundary divergence).  Threads share the "
+             "block's memory rather than copying it",
+             "bits"_a, "num_threads"_a, "warmup"_a=0)
+
         .def_readonly("input", &SequenceLearner::input,
                       "Returns input BlockInput object")
 
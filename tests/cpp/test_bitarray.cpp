@@ -230,6 +230,32 @@ int main() {
     std::cout << "}" << std::endl;
     std::cout << std::endl;
 
+    std::cout << "dense.set_bits(ptr, n); dense.get_bits(ptr);" << std::endl;
+    std::cout << "-----------------------------------------" << std::endl;
+    std::mt19937 rng_bits(0);
+    uint32_t num_dense = 100003;
+    BitArray dense(num_dense + 29);
+    std::vector<uint8_t> dense_in(num_dense);
+    std::vector<uint8_t> dense_out(num_dense + 29);
+    for (uint32_t i = 0; i < num_dense; i++)
+        if (rng_bits() % 3 == 0)
+            dense_in[i] = (uint8_t)(1 + rng_bits() % 255);
+    dense.set_range(0, num_dense + 29);
+    t0 = std::chrono::high_resolution_clock::now();
+    dense.set_bits(dense_in.data(), num_dense);
+    dense.get_bits(dense_out.data());
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s" << std::endl;
+    uint32_t num_match = 0;
+    for (uint32_t i = 0; i < num_dense + 29; i++) {
+        uint8_t expect = i < num_dense && dense_in[i] > 0;
+        if (dense.get_bit(i) == expect && dense_out[i] == expect)
+            num_match++;
+    }
+    std::cout << "match=" << num_match << "/" << num_dense + 29 << std::endl;
+    std::cout << std::endl;
+
     std::cout << "ba.get_acts();" << std::endl;
     std::cout << "--------------" << std::endl;
     ba.clear_all();
@@ -260,6 +286,17 @@ int main() {
     std::cout << "num_set=" << num_set << std::endl;
     std::cout << std::endl;
 
+    std::cout << "ba.num_set(3, 40);" << std::endl;
+    std::cout << "------------------" << std::endl;
+    t0 = std::chrono::high_resolution_clock::now();
+    uint32_t num_set_range = ba.num_set(3, 40);
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s" << std::endl;
+    std::cout << "acts="; ba.print_acts();
+    std::cout << "num_set_range=" << num_set_range << std::endl;
+    std::cout << std::endl;
+
     std::cout << "ba.num_cleared();" << std::endl;
     std::cout << "-----------------" << std::endl;
     t0 = std::chrono::high_resolution_clock::now();
@@ -291,6 +328,44 @@ int main() {
     std::cout << "num_similar=" << num_similar << std::endl;
     std::cout << std::endl;
 
+    std::cout << "ba0.fingerprint();" << std::endl;
+    std::cout << "------------------" << std::endl;
+    t0 = std::chrono::high_resolution_clock::now();
+    uint64_t fp0 = ba0.fingerprint();
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    uint64_t fp2 = ba2.fingerprint();
+    uint64_t fp_inc = fp0;
+    uint32_t w = get_wrd(20);
+    word_t old_word = ba0.words[w];
+    ba0.set_bit(20);
+    fp_inc ^= fingerprint_word(w, old_word) ^ fingerprint_word(w, ba0.words[w]);
+    std::cout << "t=" << duration.count() << "s" << std::endl;
+    std::cout << "ba0 acts="; ba0.print_acts();
+    std::cout << "fp0 != fp2: " << (fp0 != fp2) << std::endl;
+    std::cout << "incremental matches: " << (fp_inc == ba0.fingerprint())
+              << std::endl;
+    ba0.clear_bit(20);
+    std::cout << std::endl;
+
+    std::cout << "big.clear_tracked();" << std::endl;
+    std::cout << "--------------------" << std::endl;
+    BitArray big(1 << 24);
+    big.set_bit_tracked(5);
+    big.set_bit_tracked(7);
+    big.set_bit_tracked(1000000);
+    big.set_bit_tracked(16000000);
+    std::cout << "num_set=" << big.num_set()
+              << " touched=" << big.touched.size() << std::endl;
+    t0 = std::chrono::high_resolution_clock::now();
+    big.clear_tracked();
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s" << std::endl;
+    std::cout << "num_set=" << big.num_set()
+              << " touched=" << big.touched.size() << std::endl;
+    std::cout << std::endl;
+
     bool success;
     uint32_t next_bit;
 
@@ -423,6 +498,36 @@ int main() {
     std::cout << "ba2 bits="; ba2.print_bits();
     std::cout << std::endl;
 
+    std::cout << "ba2 = ba0; ba2.andnot(ba1)" << std::endl;
+    std::cout << "--------------------------" << std::endl;
+    ba2 = ba0;
+    t0 = std::chrono::high_resolution_clock::now();
+    ba2.andnot(ba1);
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s" << std::endl;
+    std::cout << "ba0 acts="; ba0.print_acts();
+    std::cout << "ba1 acts="; ba1.print_acts();
+    std::cout << "ba2 acts="; ba2.print_acts();
+    std::cout << std::endl;
+
+    std::cout << "popcount(bitexpr(ba0) & ~bitexpr(ba1))" << std::endl;
+    std::cout << "--------------------------------------" << std::endl;
+    t0 = std::chrono::high_resolution_clock::now();
+    uint32_t num_andnot = popcount(bitexpr(ba0) & ~bitexpr(ba1));
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s" << std::endl;
+    std::cout << "num_andnot=" << num_andnot << " ("
+              << (ba0 & ~ba1).num_set() << ")" << std::endl;
+    std::cout << "any(ba0 & ba1)=" << any(bitexpr(ba0) & bitexpr(ba1))
+              << std::endl;
+    std::cout << "popcount(~ba1)=" << popcount(~bitexpr(ba1)) << " ("
+              << ba1.num_cleared() << ")" << std::endl;
+    ba2.assign((bitexpr(ba0) | bitexpr(ba1)) ^ bitexpr(ba1));
+    std::cout << "ba2.assign((ba0 | ba1) ^ ba1) acts="; ba2.print_acts();
+    std::cout << std::endl;
+
     std::cout << "ba0 == ba1" << std::endl;
     std::cout << "----------" << std::endl;
     t0 = std::chrono::high_resolution_clock::now();
@@ -0,0 +1,123 @@
+// =============================================================================
+// test_bitspan.cpp
+// =============================================================================
+#include "bitspan.hpp"
+#include "block_memory.hpp"
+#include <iostream>
+#include <random>
+
+using namespace BrainBlocks;
+
+// Copies bits [beg, beg + len) of a BitArray into a new BitArray bit by bit
+BitArray slice(BitArray& ba, uint32_t beg, uint32_t len) {
+
+    BitArray out(len);
+
+    for (uint32_t i = 0; i < len; i++)
+        if (ba.get_bit(beg + i))
+            out.set_bit(i);
+
+    return out;
+}
+
+int main() {
+
+    std::mt19937 rng(0);
+
+    // Basic view of a BitArray
+    BitArray ba(32);
+    ba.set_range(8, 4);
+
+    BitSpan span(ba, 6, 8);
+
+    std::cout << "bitarray: "; ba.print_bits();
+    std::cout << "span(6, 8) num_set=" << span.num_set() << std::endl;
+    span.set_bit(0);
+    std::cout << "span.set_bit(0)" << std::endl;
+    std::cout << "bitarray: "; ba.print_bits();
+    std::cout << std::endl;
+
+    // Compare span algorithms against bit-by-bit slices at unaligned offsets
+    uint32_t num_b = 1000;
+    BitArray a(num_b);
+    BitArray b(num_b);
+    a.random_set_pct(rng, 0.3);
+    b.random_set_pct(rng, 0.3);
+
+    uint32_t num_ok = 0;
+    uint32_t num_tests = 200;
+
+    for (uint32_t t = 0; t < num_tests; t++) {
+        uint32_t len = 2 + rng() % 300;
+        uint32_t beg_a = rng() % (num_b - len);
+        uint32_t beg_b = t % 2 ? (rng() % (num_b - len)) & ~31u : beg_a;
+
+        BitSpan sa(a, beg_a, len);
+        BitSpan sb(b, beg_b, len);
+        BitArray ca = slice(a, beg_a, len);
+        BitArray cb = slice(b, beg_b, len);
+
+        bool ok = true;
+        ok &= sa.num_set() == ca.num_set();
+        ok &= sa.get_acts() == ca.get_acts();
+        ok &= sa.num_similar(sb) == ca.num_similar(cb);
+
+        uint32_t pos = rng() % len;
+        uint32_t r0 = 0;
+        uint32_t r1 = 0;
+        bool f0 = sa.find_next_set_bit(pos, &r0);
+        bool f1 = ca.find_next_set_bit(pos, &r1);
+        ok &= f0 == f1 && r0 == r1;
+
+        // Writes through the span must only touch the span
+        BitArray c = a;
+        BitSpan sc(c, beg_a, len);
+        sc.copy_from(sb);
+        ok &= slice(c, beg_a, len).get_acts() == cb.get_acts();
+        ok &= slice(c, 0, beg_a).get_acts() == slice(a, 0, beg_a).get_acts();
+        uint32_t end = beg_a + len;
+        ok &= slice(c, end, num_b - end).get_acts() ==
+              slice(a, end, num_b - end).get_acts();
+
+        sc.clear_all();
+        ok &= sc.num_set() == 0 && c.num_set() == a.num_set() - ca.num_set();
+
+        sc.set_all();
+        ok &= sc.num_set() == len;
+
+        if (ok)
+            num_ok++;
+    }
+
+    std::cout << "span algorithms match: " << num_ok << "/" << num_tests
+              << std::endl;
+    std::cout << std::endl;
+
+    // BlockMemory overlap and learn on a span match a copied sub-range
+    uint32_t num_i = 256;
+    uint32_t beg = 77;
+    BitArray big(1024);
+    big.random_set_pct(rng, 0.2);
+    BitArray sub = slice(big, beg, num_i);
+    BitSpan view(big, beg, num_i);
+
+    BlockMemory m0;
+    BlockMemory m1;
+    std::mt19937 rng0(1);
+    std::mt19937 rng1(1);
+    m0.init_pooled(num_i, 10, 0.8, 0.5, 1.0, 20, 2, 1, rng0);
+    m1.init_pooled(num_i, 10, 0.8, 0.5, 1.0, 20, 2, 1, rng1);
+
+    uint32_t num_same = 0;
+
+    for (uint32_t d = 0; d < 10; d++) {
+        m0.learn(d, sub, rng0);
+        m1.learn(d, view, rng1);
+
+        if (m0.overlap(d, sub) == m1.overlap(d, view))
+            num_same++;
+    }
+
+    std::cout << "overlap on span matches copy: " << num_same << "/10"
+              << std::endl;
+}
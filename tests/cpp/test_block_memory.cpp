@@ -3,11 +3,15 @@
 // =============================================================================
 #include "block_memory.hpp"
 #include "bitarray.hpp"
+#include "utils.hpp"
 #include <iostream>
 #include <cstdint>
 #include <vector>
 #include <random>
 #include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
 
 using namespace BrainBlocks;
 
@@ -40,6 +44,30 @@ int main() {
     duration = t1 - t0;
     std::cout << "t=" << duration.count() << "s" << std::endl;
     std::cout << "memory_usage=" << mem.memory_usage() << " bytes" << std::endl;
+    std::cout << "num_receptors=" << mem.num_receptors() << std::endl;
+
+    // Oversized memories are rejected before anything is allocated
+    BlockMemory memx;
+
+    try {
+        memx.init(NUM_BITS, UINT32_MAX, UINT32_MAX, 20, 2, 1, 0.3);
+        std::cout << "oversized init: accepted" << std::endl;
+    }
+    catch (const std::length_error& e) {
+        std::cout << "oversized init: " << e.what() << std::endl;
+    }
+
+    BlockMemory memy;
+    memy.set_interleaved(true);
+
+    try {
+        memy.init(NUM_BITS, 1, UINT32_MAX - 1, 20, 2, 1, 0.3);
+        std::cout << "oversized record: accepted" << std::endl;
+    }
+    catch (const std::length_error& e) {
+        std::cout << "oversized record: " << e.what() << std::endl;
+    }
+
     std::cout << std::endl;
 
     uint32_t overlap = 0xFFFFFFFF;
@@ -128,6 +156,385 @@ int main() {
     std::cout << "d_conn="; mem.print_conns(0);
     std::cout << " addrs="; mem.print_addrs(0);
     std::cout << " perms="; mem.print_perms(0);
+    std::cout << std::endl;
+
+    std::cout << "mem4.set_perm_bits(PERM_BITS_4)" << std::endl;
+    std::cout << "-------------------------------" << std::endl;
+    BlockMemory mem4;
+    mem4.set_perm_bits(PERM_BITS_4);
+    mem4.init_pooled_conn(NUM_BITS, 1, 0.8, 0.5, 0.3, 20, 2, 1, rng);
+    std::cout << "memory_usage=" << mem4.memory_usage() << " bytes" << std::endl;
+
+    for (uint32_t i = 0; i < 200; i++)
+        mem4.learn_move_conn(0, input, rng);
+
+    std::cout << "overlap=" << mem4.overlap(0, input) << std::endl;
+    std::cout << "overlap_conn=" << mem4.overlap_conn(0, input) << std::endl;
+    std::cout << " perms="; mem4.print_perms(0);
+
+    // Loading checks the saved permanence precision
+    FILE* fptr4 = std::tmpfile();
+    mem4.save(fptr4);
+
+    BlockMemory mem8;
+    mem8.init_pooled_conn(NUM_BITS, 1, 0.8, 0.5, 0.3, 20, 2, 1, rng);
+    std::rewind(fptr4);
+    std::cout << "load into 8-bit=" << mem8.load(fptr4) << std::endl;
+
+    BlockMemory mem4b;
+    mem4b.set_perm_bits(PERM_BITS_4);
+    mem4b.init_pooled_conn(NUM_BITS, 1, 0.8, 0.5, 0.3, 20, 2, 1, rng);
+    std::rewind(fptr4);
+    std::cout << "load into 4-bit=" << mem4b.load(fptr4) << std::endl;
+
+    std::cout << "loaded overlap_conn=" << mem4b.overlap_conn(0, input)
+              << std::endl;
+
+    // Truncated files are rejected and leave the memory unchanged
+    std::vector<uint8_t> bytes(std::ftell(fptr4));
+    std::rewind(fptr4);
+    std::fread(bytes.data(), 1, bytes.size(), fptr4);
+    std::fclose(fptr4);
+
+    FILE* fptr_t = std::tmpfile();
+    std::fwrite(bytes.data(), 1, bytes.size() - 1, fptr_t);
+    std::rewind(fptr_t);
+    std::cout << "load truncated=" << mem4b.load(fptr_t) << std::endl;
+    std::fclose(fptr_t);
+    std::cout << "overlap_conn after truncated load="
+              << mem4b.overlap_conn(0, input) << std::endl;
+
+    // Headerless files hold 8-bit permanences
+    uint32_t num_rpd4 = mem4b.num_receptors_per_dendrite();
+    std::vector<uint8_t> legacy(num_rpd4 * sizeof(uint32_t) + num_rpd4, 0);
+    FILE* fptr_l = std::tmpfile();
+    std::fwrite(legacy.data(), 1, legacy.size(), fptr_l);
+    std::rewind(fptr_l);
+    std::cout << "load headerless into 4-bit=" << mem4b.load(fptr_l)
+              << std::endl;
+    std::rewind(fptr_l);
+    std::cout << "load headerless into 8-bit=" << mem8.load(fptr_l)
+              << std::endl;
+    std::fclose(fptr_l);
+    std::cout << std::endl;
+
+    std::cout << "memc.set_pool_cap(64, 4096)" << std::endl;
+    std::cout << "---------------------------" << std::endl;
+    uint32_t num_wide = 100000;
+    uint32_t num_dc = 100;
+    BlockMemory memc;
+    memc.set_pool_cap(64, 4096);
+    t0 = std::chrono::high_resolution_clock::now();
+    memc.init_pooled_conn(num_wide, num_dc, 0.8, 0.5, 0.3, 20, 2, 1, rng);
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s" << std::endl;
+    std::cout << "num_rpd=" << memc.num_receptors_per_dendrite() << std::endl;
+    std::cout << "memory_usage=" << memc.memory_usage() << " bytes"
+              << std::endl;
+
+    // Receptors must be distinct and inside each dendrite's field
+    uint32_t num_in_field = 0;
+
+    for (uint32_t d = 0; d < num_dc; d++) {
+        std::vector<uint32_t> addrs = memc.addrs(d);
+        uint32_t center = (uint32_t)(((2 * (uint64_t)d + 1) * num_wide) /
+                                     (2 * num_dc));
+        bool ok = true;
+
+        for (uint32_t j = 0; j < addrs.size(); j++) {
+            uint32_t dist = (addrs[j] + num_wide - center) % num_wide;
+            dist = dist < num_wide - dist ? dist : num_wide - dist;
+            ok &= dist <= 2048;
+        }
+
+        std::sort(addrs.begin(), addrs.end());
+        ok &= std::unique(addrs.begin(), addrs.end()) == addrs.end();
+
+        if (ok)
+            num_in_field++;
+    }
+
+    std::cout << "dendrites in field: " << num_in_field << "/" << num_dc
+              << std::endl;
+
+    BitArray wide(num_wide);
+    wide.random_set_pct(rng, 0.5);
+
+    for (uint32_t i = 0; i < 10; i++)
+        memc.learn_conn(0, wide, rng);
+
+    std::cout << "overlap=" << memc.overlap(0, wide) << std::endl;
+    std::cout << "overlap_conn=" << memc.overlap_conn(0, wide) << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "memt.update_tiers(1)" << std::endl;
+    std::cout << "--------------------" << std::endl;
+    uint32_t num_dt = 1000;
+    BlockMemory memt;
+    memt.init_pooled(1024, num_dt, 0.5, 0.5, 1.0, 20, 2, 1, rng);
+    BlockMemory memu = memt;
+    BitArray in_t(1024);
+    in_t.random_set_pct(rng, 0.3);
+
+    // Only a few dendrites are busy
+    memt.set_tiering(true);
+
+    for (uint32_t d = 0; d < num_dt; d += 20)
+        memt.overlap(d, in_t);
+
+    std::cout << "memory_usage before=" << memt.memory_usage() << " bytes"
+              << std::endl;
+    t0 = std::chrono::high_resolution_clock::now();
+    uint32_t num_c = memt.update_tiers(1);
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s" << std::endl;
+    std::cout << "num_cold=" << num_c << std::endl;
+    std::cout << "memory_usage after=" << memt.memory_usage() << " bytes"
+              << std::endl;
+
+    // Overlaps and learning must not depend on the tier
+    for (uint32_t d = 1; d < num_dt; d += 100) {
+        memt.learn(d, in_t, rng);
+        memu.learn(d, in_t, rng);
+    }
+
+    uint32_t num_equal = 0;
+
+    for (uint32_t d = 0; d < num_dt; d++)
+        if (memt.overlap(d, in_t) == memu.overlap(d, in_t))
+            num_equal++;
+
+    std::cout << "num_cold after learn=" << memt.num_cold() << std::endl;
+    std::cout << "overlaps equal: " << num_equal << "/" << num_dt << std::endl;
+
+    memt.decompress_all();
+    std::cout << "num_cold after decompress_all=" << memt.num_cold()
+              << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "memk.update_tiers(1) (connections)" << std::endl;
+    std::cout << "----------------------------------" << std::endl;
+    BlockMemory memk;
+    memk.init_pooled_conn(1024, num_dt, 0.5, 0.5, 1.0, 20, 2, 1, rng);
+    BlockMemory memv = memk;
+
+    // Only a few dendrites are busy, seen through overlap_conn
+    memk.set_tiering(true);
+
+    for (uint32_t d = 0; d < num_dt; d += 20)
+        memk.overlap_conn(d, in_t);
+
+    std::cout << "memory_usage before=" << memk.memory_usage() << " bytes"
+              << std::endl;
+    std::cout << "num_cold=" << memk.update_tiers(1) << std::endl;
+    std::cout << "memory_usage after=" << memk.memory_usage() << " bytes"
+              << std::endl;
+
+    for (uint32_t d = 1; d < num_dt; d += 100) {
+        memk.learn_conn(d, in_t, rng);
+        memv.learn_conn(d, in_t, rng);
+    }
+
+    num_equal = 0;
+
+    for (uint32_t d = 0; d < num_dt; d++)
+        if (memk.overlap_conn(d, in_t) == memv.overlap_conn(d, in_t))
+            num_equal++;
+
+    std::cout << "num_cold after learn=" << memk.num_cold() << std::endl;
+    std::cout << "overlaps equal: " << num_equal << "/" << num_dt << std::endl;
+
+    // Every dendrite was just accessed, so all become hot again
+    std::cout << "num_cold after busy step=" << memk.update_tiers(1)
+              << std::endl;
+
+    num_equal = 0;
+
+    for (uint32_t d = 0; d < num_dt; d++)
+        if (memk.overlap_conn(d, in_t) == memv.overlap_conn(d, in_t))
+            num_equal++;
+
+    std::cout << "overlaps equal: " << num_equal << "/" << num_dt << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "meml.relayout()" << std::endl;
+    std::cout << "---------------" << std::endl;
+    uint32_t num_dl = 4096;
+    uint32_t num_g = 64;
+    BlockMemory meml;
+    meml.set_pool_cap(8);
+    meml.init_pooled(1024, num_dl, 0.5, 0.5, 1.0, 20, 2, 1, rng);
+    BlockMemory memr = meml;
+    BitArray in_l(1024);
+    in_l.random_set_pct(rng, 0.3);
+
+    // Groups of co-active dendrites scattered across memory
+    std::vector<uint32_t> ids(num_dl);
+
+    for (uint32_t d = 0; d < num_dl; d++)
+        ids[d] = d;
+
+    std::shuffle(ids.begin(), ids.end(), rng);
+
+    std::vector<uint32_t> steps(1000);
+
+    for (uint32_t i = 0; i < steps.size(); i++)
+        steps[i] = utils_rand_uint(0, num_g - 1, rng);
+
+    uint32_t size_g = num_dl / num_g;
+
+    auto replay = [&](BlockMemory& mem) {
+        mem.set_tracing(true);
+
+        for (uint32_t i = 0; i < steps.size(); i++) {
+            mem.trace_step();
+
+            for (uint32_t j = 0; j < size_g; j++)
+                mem.overlap(ids[steps[i] * size_g + j], in_l);
+        }
+    };
+
+    replay(meml);
+    LayoutReport before = meml.layout_report();
+    t0 = std::chrono::high_resolution_clock::now();
+    meml.relayout();
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    replay(meml);
+    LayoutReport after = meml.layout_report();
+
+    std::cout << "t=" << duration.count() << "s" << std::endl;
+    std::cout << "steps=" << before.num_steps << std::endl;
+    std::cout << "lines/step before=" << before.lines_per_step
+              << " after=" << after.lines_per_step << std::endl;
+    std::cout << "pages/step before=" << before.pages_per_step
+              << " after=" << after.pages_per_step << std::endl;
+
+    for (uint32_t d = 1; d < num_dl; d += 100) {
+        meml.learn(d, in_l, rng);
+        memr.learn(d, in_l, rng);
+    }
+
+    num_equal = 0;
+
+    for (uint32_t d = 0; d < num_dl; d++)
+        if (meml.overlap(d, in_l) == memr.overlap(d, in_l))
+            num_equal++;
+
+    std::cout << "overlaps equal: " << num_equal << "/" << num_dl << std::endl;
+
+    // The layout survives save and load
+    FILE* fptr = std::tmpfile();
+    meml.save(fptr);
+    std::rewind(fptr);
+    BlockMemory memf;
+    memf.set_pool_cap(8);
+    memf.init_pooled(1024, num_dl, 0.5, 0.5, 1.0, 20, 2, 1, rng);
+    memf.load(fptr);
+    std::fclose(fptr);
+    replay(memf);
+    LayoutReport loaded = memf.layout_report();
+
+    num_equal = 0;
+
+    for (uint32_t d = 0; d < num_dl; d++)
+        if (memf.overlap(d, in_l) == memr.overlap(d, in_l))
+            num_equal++;
+
+    std::cout << "lines/step after load=" << loaded.lines_per_step
+              << std::endl;
+    std::cout << "overlaps equal after load: " << num_equal << "/" << num_dl
+              << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "memi.set_interleaved(true)" << std::endl;
+    std::cout << "--------------------------" << std::endl;
+    uint32_t num_di = 10000;
+    std::mt19937 rng_s(1);
+    std::mt19937 rng_i(1);
+    BlockMemory mems;
+    BlockMemory memi;
+    memi.set_interleaved(true);
+    mems.init_pooled(1024, num_di, 0.0625, 0.1, 1.0, 20, 2, 1, rng_s);
+    memi.init_pooled(1024, num_di, 0.0625, 0.1, 1.0, 20, 2, 1, rng_i);
+
+    std::cout << "record bytes: split=" << mems.num_record_bytes()
+              << " interleaved=" << memi.num_record_bytes() << std::endl;
+    std::cout << "memory_usage: split=" << mems.memory_usage()
+              << " interleaved=" << memi.memory_usage() << " bytes"
+              << std::endl;
+
+    BitArray in_i(1024);
+    in_i.random_set_pct(rng, 0.2);
+
+    // Learning must not depend on the layout
+    for (uint32_t d = 0; d + 7 < num_di; d += 7) {
+        mems.learn(d, in_i, rng_s);
+        memi.learn(d, in_i, rng_i);
+        mems.punish(d + 3, in_i, rng_s);
+        memi.punish(d + 3, in_i, rng_i);
+        mems.learn_move(d + 5, in_i, rng_s);
+        memi.learn_move(d + 5, in_i, rng_i);
+    }
+
+    uint64_t sum_s = 0;
+    uint64_t sum_i = 0;
+
+    t0 = std::chrono::high_resolution_clock::now();
+    for (uint32_t d = 0; d < num_di; d++)
+        sum_s += mems.overlap(d, in_i);
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s (split)" << std::endl;
+
+    t0 = std::chrono::high_resolution_clock::now();
+    for (uint32_t d = 0; d < num_di; d++)
+        sum_i += memi.overlap(d, in_i);
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s (interleaved)" << std::endl;
+
+    num_equal = 0;
+
+    for (uint32_t d = 0; d < num_di; d++)
+        if (mems.overlap(d, in_i) == memi.overlap(d, in_i) &&
+            mems.addrs(d) == memi.addrs(d) && mems.perms(d) == memi.perms(d))
+            num_equal++;
+
+    std::cout << "overlap sums: split=" << sum_s << " interleaved=" << sum_i
+              << std::endl;
+    std::cout << "dendrites equal: " << num_equal << "/" << num_di << std::endl;
+
+    // Tiers and saved files work the same with records
+    memi.set_tiering(true);
+
+    for (uint32_t d = 0; d < num_di; d += 3)
+        memi.overlap(d, in_i);
+
+    memi.update_tiers(1);
+    memi.learn(1, in_i, rng_i);
+    mems.learn(1, in_i, rng_s);
+
+    fptr = std::tmpfile();
+    memi.save(fptr);
+    std::rewind(fptr);
+    BlockMemory memj;
+    memj.init_pooled(1024, num_di, 0.0625, 0.1, 1.0, 20, 2, 1, rng);
+    memj.load(fptr);
+    std::fclose(fptr);
+
+    num_equal = 0;
+
+    for (uint32_t d = 0; d < num_di; d++)
+        if (memi.overlap(d, in_i) == mems.overlap(d, in_i) &&
+            memj.overlap(d, in_i) == mems.overlap(d, in_i))
+            num_equal++;
+
+    std::cout << "num_cold=" << memi.num_cold() << std::endl;
+    std::cout << "overlaps equal after tiers and load: " << num_equal << "/"
+              << num_di << std::endl;
 
     return 0;
 }
@@ -0,0 +1,119 @@
+// =============================================================================
+// test_frozen_pooler.cpp
+// =============================================================================
+#include "blocks/frozen_pooler.hpp"
+#include "blocks/pattern_classifier.hpp"
+#include "blocks/scalar_transformer.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace BrainBlocks;
+
+int main() {
+
+    ScalarTransformer st(0.0, 1.0, 1024, 128);
+    PatternClassifier pc(2, 1024, 8, 20, 2, 1, 0.8, 0.5, 0.3, 2);
+
+    pc.input.add_child(&st.output, 0);
+    pc.init();
+
+    // Train classifier
+    for (uint32_t i = 0; i < 10; i++) {
+        st.set_value(0.0);
+        pc.set_label(0);
+        st.feedforward();
+        pc.feedforward(true);
+
+        st.set_value(1.0);
+        pc.set_label(1);
+        st.feedforward();
+        pc.feedforward(true);
+    }
+
+    // Export classifier
+    FrozenPooler fp(1024, 8);
+    pc.freeze(fp);
+    fp.save("frozen.bin");
+
+    // Load frozen classifier
+    FrozenPooler fp_loaded(1024, 8);
+    fp_loaded.input.add_child(&st.output, 0);
+    fp_loaded.load("frozen.bin");
+
+    std::cout << "dense=" << fp_loaded.memory.is_dense() << std::endl;
+    std::cout << "classifier memory_usage=" << pc.memory.memory_usage()
+              << " bytes" << std::endl;
+    std::cout << "frozen memory_usage=" << fp_loaded.memory.memory_usage()
+              << " bytes" << std::endl;
+    std::cout << std::endl;
+
+    std::vector<double> probs;
+    std::vector<double> frozen_probs;
+    std::vector<double> values = {0.0, 1.0};
+
+    for (uint32_t i = 0; i < values.size(); i++) {
+        st.set_value(values[i]);
+        st.feedforward();
+        pc.feedforward(false);
+        fp_loaded.feedforward();
+        probs = pc.get_probabilities();
+        frozen_probs = fp_loaded.get_probabilities();
+
+        std::cout << "value=" << values[i] << std::endl;
+        std::cout << "classifier={" << probs[0] << ", " << probs[1] << "}"
+                  << std::endl;
+        std::cout << "    frozen={" << frozen_probs[0] << ", "
+                  << frozen_probs[1] << "}" << std::endl;
+        std::cout << "  matching=" << (pc.output.state == fp_loaded.output.state)
+                  << std::endl;
+    }
+
+    std::cout << std::endl;
+
+    // Truncated files and bad counts are rejected
+    std::vector<char> bytes;
+    FILE* fptr = std::fopen("frozen.bin", "rb");
+    char c;
+
+    while (std::fread(&c, 1, 1, fptr) == 1)
+        bytes.push_back(c);
+
+    std::fclose(fptr);
+
+    fptr = std::fopen("frozen_bad.bin", "wb");
+    std::fwrite(bytes.data(), 1, bytes.size() / 2, fptr);
+    std::fclose(fptr);
+    std::cout << "load truncated=" << fp_loaded.load("frozen_bad.bin")
+              << std::endl;
+
+    // Number of labels follows the 3 word header
+    std::vector<char> bad = bytes;
+    uint32_t num_l = 0xFFFFFFFF;
+    memcpy(&bad[3 * sizeof(uint32_t)], &num_l, sizeof(num_l));
+
+    fptr = std::fopen("frozen_bad.bin", "wb");
+    std::fwrite(bad.data(), 1, bad.size(), fptr);
+    std::fclose(fptr);
+    std::cout << "load bad num_l=" << fp_loaded.load("frozen_bad.bin")
+              << std::endl;
+
+    bad = bytes;
+    bad[0] = 'X';
+
+    fptr = std::fopen("frozen_bad.bin", "wb");
+    std::fwrite(bad.data(), 1, bad.size(), fptr);
+    std::fclose(fptr);
+    std::cout << "load bad magic=" << fp_loaded.load("frozen_bad.bin")
+              << std::endl;
+
+    fp_loaded.feedforward();
+    std::cout << "unchanged after failed loads="
+              << (pc.output.state == fp_loaded.output.state) << std::endl;
+
+    std::remove("frozen.bin");
+    std::remove("frozen_bad.bin");
+
+    return 0;
+}
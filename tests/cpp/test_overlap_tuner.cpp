@@ -0,0 +1,152 @@
+#include "overlap_tuner.hpp"
+#include "blocks/pattern_pooler.hpp"
+#include "blocks/blank_block.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+
+using namespace BrainBlocks;
+
+int main() {
+
+    std::chrono::high_resolution_clock::time_point t0;
+    std::chrono::high_resolution_clock::time_point t1;
+    std::chrono::duration<double> duration;
+
+    const char* names[NUM_KERNELS] = {"scan", "conn", "index", "sliced"};
+
+    std::mt19937 rng(0);
+    uint32_t num_i = 1024;
+    uint32_t num_d = 256;
+
+    BlockMemory memory;
+    memory.init_pooled_conn(num_i, num_d, 0.8, 0.5, 0.3, 20, 2, 1, rng);
+
+    std::vector<BitArray> inputs(32, BitArray(num_i));
+    for (uint32_t t = 0; t < inputs.size(); t++)
+        inputs[t].random_set_pct(rng, 0.05);
+
+    // Every kernel gives the same overlaps
+    OverlapTuner tuner;
+    std::vector<uint32_t> expected;
+    std::vector<uint32_t> overlaps;
+
+    for (uint8_t k = KERNEL_CONN; k < NUM_KERNELS; k++) {
+        uint32_t num_match = 0;
+
+        for (uint32_t t = 0; t < inputs.size(); t++) {
+            tuner.overlap_all(memory, KERNEL_CONN, inputs[t], expected);
+            tuner.overlap_all(memory, k, inputs[t], overlaps);
+
+            if (overlaps == expected)
+                num_match++;
+        }
+
+        std::cout << names[k] << " matches conn: " << num_match << "/"
+                  << inputs.size() << std::endl;
+    }
+
+    // Learning invalidates the derived structures
+    memory.learn_conn(0, inputs[0], rng);
+    tuner.overlap_all(memory, KERNEL_CONN, inputs[0], expected);
+    tuner.overlap_all(memory, KERNEL_INDEX, inputs[0], overlaps);
+    std::cout << "index after learn: "
+              << (overlaps == expected ? "match" : "mismatch") << std::endl;
+    tuner.overlap_all(memory, KERNEL_SLICED, inputs[0], overlaps);
+    std::cout << "sliced after learn: "
+              << (overlaps == expected ? "match" : "mismatch") << std::endl;
+
+    // The derived kernels count dendrite accesses for tiering
+    for (uint8_t k = KERNEL_INDEX; k < NUM_KERNELS; k++) {
+        BlockMemory memt = memory;
+        memt.set_tiering(true);
+        tuner.overlap_all(memt, k, inputs[0], overlaps);
+        std::cout << names[k] << " num_cold=" << memt.update_tiers(1)
+                  << std::endl;
+    }
+
+    // Tune for inference and for learning
+    for (uint32_t l = 0; l < 2; l++) {
+        t0 = std::chrono::high_resolution_clock::now();
+        uint8_t kernel = tuner.tune(memory, inputs, l == 1);
+        t1 = std::chrono::high_resolution_clock::now();
+        duration = t1 - t0;
+        std::cout << "t=" << duration.count() << "s (tune learn_flag="
+                  << l << ")" << std::endl;
+
+        for (uint8_t k = 0; k < NUM_KERNELS; k++)
+            std::cout << "t=" << tuner.get_timings()[k] << "s ("
+                      << names[k] << ")" << std::endl;
+
+        bool fastest = kernel == tuner.get_kernel();
+        for (uint8_t k = 0; k < NUM_KERNELS; k++)
+            if (tuner.get_timings()[k] < tuner.get_timings()[kernel])
+                fastest = false;
+
+        std::cout << "tuned kernel is fastest: " << (fastest ? "yes" : "no")
+                  << std::endl;
+    }
+
+    // PatternPooler encodes the same with every kernel
+    BlankBlock b(num_i);
+    PatternPooler pp(num_d, 20, 20, 2, 1, 0.8, 0.5, 0.3, 2);
+    pp.input.add_child(&b.output, 0);
+    pp.init();
+
+    std::vector<BitArray> pp_expected;
+    std::vector<BitArray> pp_outputs;
+
+    pp.tuner.set_kernel(KERNEL_CONN);
+    pp.encode_batch(inputs, pp_expected);
+
+    for (uint8_t k = 0; k < NUM_KERNELS; k++) {
+        pp.tuner.set_kernel(k);
+        pp.encode_batch(inputs, pp_outputs);
+
+        uint32_t num_match = 0;
+        for (uint32_t t = 0; t < inputs.size(); t++)
+            if (pp_outputs[t] == pp_expected[t])
+                num_match++;
+
+        std::cout << "pp " << names[k] << " matches conn: " << num_match
+                  << "/" << inputs.size() << std::endl;
+    }
+
+    // The selected kernel is saved with the block
+    pp.tuner.set_kernel(KERNEL_INDEX);
+    pp.save("test_overlap_tuner.bin");
+
+    PatternPooler pp2(num_d, 20, 20, 2, 1, 0.8, 0.5, 0.3, 2);
+    pp2.input.add_child(&b.output, 0);
+    pp2.load("test_overlap_tuner.bin");
+    std::cout << "loaded kernel: " << names[pp2.tuner.get_kernel()]
+              << std::endl;
+
+    pp2.encode_batch(inputs, pp_outputs);
+
+    uint32_t num_match = 0;
+    for (uint32_t t = 0; t < inputs.size(); t++)
+        if (pp_outputs[t] == pp_expected[t])
+            num_match++;
+
+    std::cout << "loaded matches saved: " << num_match << "/"
+              << inputs.size() << std::endl;
+    std::remove("test_overlap_tuner.bin");
+
+    // Autotune on synthetic inputs at init
+    PatternPooler pp3(num_d, 20, 20, 2, 1, 0.8, 0.5, 0.3, 2);
+    pp3.input.add_child(&b.output, 0);
+    pp3.set_autotune(0.05, 16);
+
+    t0 = std::chrono::high_resolution_clock::now();
+    pp3.init();
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s (init with autotune)"
+              << std::endl;
+    std::cout << "init timings: " << pp3.tuner.get_timings().size()
+              << std::endl;
+
+    return 0;
+}
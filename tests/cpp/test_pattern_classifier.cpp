@@ -58,5 +58,33 @@ int main() {
     std::cout << "{" << probs[0] << ", " << probs[1] << "}" << std::endl;
     std::cout << std::endl;
 
+    // Parallel training on pre-encoded inputs
+    PatternClassifier pc_par(4, 1024, 8, 20, 2, 1, 0.8, 0.5, 0.3, 2);
+    pc_par.input.add_child(&st.output, 0);
+    pc_par.init();
+
+    std::vector<BitArray> inputs;
+    std::vector<uint32_t> labels;
+
+    for (uint32_t i = 0; i < 400; i++) {
+        uint32_t label = i % 4;
+        st.set_value(label / 3.0);
+        st.feedforward();
+        inputs.push_back(st.output.state);
+        labels.push_back(label);
+    }
+
+    pc_par.fit_parallel(inputs, labels, 4, 1, 25, MERGE_DELTA);
+
+    for (uint32_t l = 0; l < 4; l++) {
+        st.set_value(l / 3.0);
+        st.feedforward();
+        pc_par.feedforward(false);
+        probs = pc_par.get_probabilities();
+        std::cout << "parallel label " << l << ": {" << probs[0] << ", "
+                  << probs[1] << ", " << probs[2] << ", " << probs[3] << "}"
+                  << std::endl;
+    }
+
     return 0;
 }
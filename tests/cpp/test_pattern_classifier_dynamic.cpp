@@ -57,5 +57,40 @@ int main() {
     std::cout << "{" << probs[0] << ", " << probs[1] << "}" << std::endl;
     std::cout << std::endl;
 
+    // Labels sharing statelets and a repeated label give the same
+    // probabilities as counting each label's statelets separately
+    ScalarTransformer st2(0.0, 1.0, 256, 32);
+    PatternClassifierDynamic pc2(32, 8, 16, 20, 2, 1, 0.8, 0.5, 0.3, 2);
+
+    pc2.input.add_child(&st2.output, 0);
+    pc2.init();
+
+    double values[4] = {0.0, 0.5, 1.0, 0.0};
+    uint32_t lbls[4] = {0, 1, 2, 0};
+    uint32_t num_match = 0;
+
+    for (uint32_t i = 0; i < 4; i++) {
+        st2.set_value(values[i]);
+        pc2.set_label(lbls[i]);
+        st2.feedforward();
+        pc2.feedforward(true);
+        probs = pc2.get_probabilities();
+
+        std::vector<BitArray> l_states = pc2.get_label_states();
+        bool match = probs.size() == l_states.size();
+
+        for (uint32_t l = 0; match && l < l_states.size(); l++) {
+            uint32_t count = l_states[l].num_similar(pc2.output.state);
+            match = probs[l] == (double)count / 8.0;
+        }
+
+        if (match)
+            num_match++;
+    }
+
+    std::cout << "num labels: " << pc2.get_labels().size() << std::endl;
+    std::cout << "matches per-label counts: " << num_match << "/4"
+              << std::endl;
+
     return 0;
 }
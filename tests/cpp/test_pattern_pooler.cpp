@@ -39,5 +39,60 @@ int main() {
         //std::cout << std::endl;
     }
 
+    // Encode the series step by step and as one batch without learning
+    std::vector<BitArray> step_outputs;
+    std::vector<BitArray> st_outputs;
+    std::vector<BitArray> pp_outputs;
+
+    for (uint32_t i = 0; i < values.size(); i++) {
+        st.set_value(values[i]);
+        st.feedforward();
+        pp.feedforward(false);
+        step_outputs.push_back(pp.output.state);
+    }
+
+    t0 = std::chrono::high_resolution_clock::now();
+    st.encode_batch(values, st_outputs);
+    pp.encode_batch(st_outputs, pp_outputs);
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s (batch)" << std::endl;
+
+    uint32_t num_match = 0;
+    for (uint32_t i = 0; i < values.size(); i++)
+        if (pp_outputs[i] == step_outputs[i])
+            num_match++;
+
+    std::cout << "batch matches step: " << num_match << "/" << values.size()
+              << std::endl;
+
+    // Encode the series again with a cache of encoded outputs
+    pp.cache.resize(16);
+    num_match = 0;
+
+    for (uint32_t i = 0; i < values.size(); i++) {
+        st.set_value(values[i]);
+        st.feedforward();
+        pp.feedforward(false);
+
+        if (pp.output.state == step_outputs[i])
+            num_match++;
+    }
+
+    std::cout << "cached matches step: " << num_match << "/" << values.size()
+              << std::endl;
+    std::cout << "cache hits=" << pp.cache.num_hits()
+              << " misses=" << pp.cache.num_misses()
+              << " size=" << pp.cache.size() << std::endl;
+
+    // Learning changes the memory version and flushes the cache
+    pp.feedforward(true);
+    st.set_value(values[1]);
+    st.feedforward();
+    pp.feedforward(false);
+    std::cout << "after learn hits=" << pp.cache.num_hits()
+              << " misses=" << pp.cache.num_misses()
+              << " size=" << pp.cache.size() << std::endl;
+
     return 0;
 }
@@ -0,0 +1,88 @@
+// =============================================================================
+// test_sdr_dataset.cpp
+// =============================================================================
+#include "sdr_dataset.hpp"
+#include "blocks/blank_block.hpp"
+#include "blocks/pattern_classifier.hpp"
+#include "blocks/scalar_transformer.hpp"
+#include <iostream>
+#include <vector>
+
+using namespace BrainBlocks;
+
+int main() {
+
+    // Encode once and write the dataset
+    ScalarTransformer st(0.0, 1.0, 1024, 128);
+    SDRDatasetWriter writer;
+    writer.open("sdr_dataset.bin", 1024, SDR_LABELS | SDR_TIMESTAMPS);
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t label = i % 4;
+        st.set_value(label / 3.0);
+        st.feedforward();
+        writer.add(st.output.state, label, 1000 + i);
+    }
+
+    writer.close();
+
+    // Map the dataset
+    SDRDataset data;
+    data.open("sdr_dataset.bin");
+
+    std::cout << "num_rows=" << data.num_rows() << std::endl;
+    std::cout << "num_bits=" << data.num_bits() << std::endl;
+    std::cout << "has_labels=" << data.has_labels() << std::endl;
+    std::cout << "has_timestamps=" << data.has_timestamps() << std::endl;
+
+    BitArray ba(1024);
+    data.get_row(5, ba);
+    std::cout << "row 5: label=" << data.label(5)
+              << " timestamp=" << data.timestamp(5)
+              << " num_set=" << ba.num_set() << std::endl;
+    std::cout << std::endl;
+
+    // Train a classifier over shuffled epochs
+    BlankBlock blank(1024);
+    PatternClassifier pc(4, 512, 8);
+    pc.input.add_child(&blank.output, 0);
+    pc.init();
+
+    SDRLoader loader(data, 128);
+    std::vector<BitArray> rows;
+    std::vector<uint32_t> labels;
+
+    for (uint32_t e = 0; e < 2; e++) {
+        uint32_t num_batches = 0;
+        uint32_t num_rows = 0;
+
+        loader.start_epoch();
+
+        while (loader.next(rows, labels)) {
+            pc.fit_parallel(rows, labels, 2);
+            num_batches++;
+            num_rows += (uint32_t)rows.size();
+        }
+
+        std::cout << "epoch " << e << ": batches=" << num_batches
+                  << " rows=" << num_rows << std::endl;
+    }
+
+    // Evaluate
+    std::vector<uint32_t> votes(4);
+    uint32_t num_correct = 0;
+
+    for (uint32_t r = 0; r < data.num_rows(); r++) {
+        data.get_row(r, blank.output.state);
+        blank.feedforward();
+        pc.feedforward(false);
+
+        if (pc.get_votes(votes.data()) == data.label(r))
+            num_correct++;
+    }
+
+    std::cout << "accuracy=" << (double)num_correct / data.num_rows()
+              << std::endl;
+
+    return 0;
+}
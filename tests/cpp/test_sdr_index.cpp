@@ -0,0 +1,129 @@
+// =============================================================================
+// test_sdr_index.cpp
+// =============================================================================
+#include "sdr_index.hpp"
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace BrainBlocks;
+
+void print_matches(std::vector<SDRMatch>& matches) {
+
+    for (uint32_t m = 0; m < matches.size(); m++)
+        std::cout << "  id=" << matches[m].id
+                  << " score=" << matches[m].score << std::endl;
+}
+
+int main() {
+
+    std::mt19937 rng(0);
+
+    // Build a library of random patterns
+    SDRIndex index;
+    index.init(1024);
+
+    std::vector<BitArray> library(1000, BitArray(1024));
+
+    for (uint32_t i = 0; i < library.size(); i++) {
+        library[i].random_set_num(rng, 20);
+        index.insert(i, library[i]);
+    }
+
+    std::cout << "num_entries=" << index.num_entries() << std::endl;
+    std::cout << "memory_usage=" << index.memory_usage() << " bytes"
+              << std::endl;
+    std::cout << std::endl;
+
+    // Query a noisy copy of entry 42
+    BitArray query = library[42];
+    std::vector<uint32_t> acts = query.get_acts();
+
+    for (uint32_t i = 0; i < 5; i++)
+        query.clear_bit(acts[i]);
+
+    std::vector<SDRMatch> matches = index.query(query, 3, SDR_OVERLAP);
+    std::cout << "overlap top 3:" << std::endl;
+    print_matches(matches);
+
+    matches = index.query(query, 3, SDR_JACCARD);
+    std::cout << "jaccard top 3:" << std::endl;
+    print_matches(matches);
+    std::cout << std::endl;
+
+    // Dense query takes the word scan path
+    BitArray dense(1024);
+    dense.set_all();
+    matches = index.query(dense, 1, SDR_OVERLAP);
+    std::cout << "dense top 1:" << std::endl;
+    print_matches(matches);
+    std::cout << std::endl;
+
+    // Save, map and batch query
+    index.save("sdr_index.bin");
+
+    SDRIndex mapped;
+    mapped.map("sdr_index.bin");
+
+    std::vector<BitArray> queries = {library[7], library[500], library[999]};
+    std::vector<std::vector<SDRMatch>> batch = mapped.query_batch(queries, 1);
+
+    std::cout << "mapped=" << mapped.is_mapped() << std::endl;
+    std::cout << "mapped memory_usage=" << mapped.memory_usage() << " bytes"
+              << std::endl;
+
+    for (uint32_t i = 0; i < batch.size(); i++) {
+        std::cout << "batch " << i << ":" << std::endl;
+        print_matches(batch[i]);
+    }
+
+    // Load into memory and keep inserting
+    SDRIndex loaded;
+    loaded.load("sdr_index.bin");
+    loaded.insert(1000, library[42]);
+    matches = loaded.query(library[42], 2);
+    std::cout << "loaded top 2:" << std::endl;
+    print_matches(matches);
+
+    // Corrupt files are rejected
+    std::vector<uint32_t> words;
+    FILE* fptr = std::fopen("sdr_index.bin", "rb");
+    uint32_t word;
+
+    while (std::fread(&word, sizeof(word), 1, fptr) == 1)
+        words.push_back(word);
+
+    std::fclose(fptr);
+    std::remove("sdr_index.bin");
+
+    auto write_words = [](std::vector<uint32_t>& w) {
+        FILE* f = std::fopen("sdr_index_bad.bin", "wb");
+        std::fwrite(w.data(), sizeof(w[0]), w.size(), f);
+        std::fclose(f);
+    };
+
+    uint32_t np = words[6];
+    std::vector<uint32_t> bad = words;
+    bad[words.size() - np - 1] = np + 1; // last posting offset
+    write_words(bad);
+
+    SDRIndex bad_offs;
+    std::cout << "bad offsets load=" << bad_offs.load("sdr_index_bad.bin")
+              << " map=" << bad_offs.map("sdr_index_bad.bin") << std::endl;
+
+    bad = words;
+    bad.back() = 0xFFFFFFFF; // last posting entry
+    write_words(bad);
+
+    SDRIndex bad_entry;
+    std::cout << "bad entry load=" << bad_entry.load("sdr_index_bad.bin")
+              << " map=" << bad_entry.map("sdr_index_bad.bin") << std::endl;
+
+    // Mapped queries skip the bad posting
+    matches = bad_entry.query(library[999], 1);
+    std::cout << "bad entry mapped top 1:" << std::endl;
+    print_matches(matches);
+    bad_entry.clear();
+    std::remove("sdr_index_bad.bin");
+}
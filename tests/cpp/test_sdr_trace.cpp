@@ -0,0 +1,100 @@
+// =============================================================================
+// test_sdr_trace.cpp
+// =============================================================================
+#include "sdr_trace.hpp"
+#include "blocks/pattern_pooler.hpp"
+#include "blocks/scalar_transformer.hpp"
+#include "blocks/sequence_learner.hpp"
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+using namespace BrainBlocks;
+
+int main() {
+
+    std::vector<double> values = {
+        0.0, 0.2, 0.4, 0.6, 0.8, 1.0, 0.0, 0.2, 0.4, 0.6, 0.8, 1.0,
+        0.0, 0.2, 0.4, 0.6, 0.8, 1.0, 0.0, 0.2, 0.9, 0.6, 0.8, 1.0};
+
+    // Record the encoder output of a live hierarchy
+    ScalarTransformer st(0.0, 1.0, 1024, 128);
+    PatternPooler pp(512, 8, 20, 2, 1, 0.8, 0.5, 0.3, 2, false, 1);
+    SequenceLearner sl(512, 10, 10, 12, 6, 20, 2, 1);
+
+    pp.input.add_child(&st.output, 0);
+    sl.input.add_child(&pp.output, 0);
+
+    SDRTraceRecorder recorder;
+    recorder.add_source(&st.output);
+    recorder.open("sdr_trace");
+
+    std::vector<double> scores;
+
+    for (uint32_t i = 0; i < values.size(); i++) {
+        st.set_value(values[i]);
+        st.feedforward();
+        recorder.record(true);
+        pp.feedforward(true);
+        sl.feedforward(true);
+        scores.push_back(sl.get_anomaly_score());
+    }
+
+    recorder.close();
+
+    std::cout << "num_frames=" << recorder.num_frames() << std::endl;
+    std::cout << "num_files=" << recorder.num_files() << std::endl;
+
+    // Replay the trace into an identical hierarchy
+    SDRTraceReplayer replayer;
+    replayer.open(recorder.file_name(0).c_str());
+
+    PatternPooler pp_re(512, 8, 20, 2, 1, 0.8, 0.5, 0.3, 2, false, 1);
+    SequenceLearner sl_re(512, 10, 10, 12, 6, 20, 2, 1);
+
+    pp_re.input.add_child(&replayer.output(0), 0);
+    sl_re.input.add_child(&pp_re.output, 0);
+
+    uint32_t t = 0;
+    uint32_t num_matches = 0;
+
+    while (replayer.step()) {
+        pp_re.feedforward(replayer.learn_flag());
+        sl_re.feedforward(replayer.learn_flag());
+
+        if (sl_re.get_anomaly_score() == scores[t])
+            num_matches++;
+
+        std::cout << "t=" << t << " score=" << scores[t]
+                  << " replay=" << sl_re.get_anomaly_score() << std::endl;
+        t++;
+    }
+
+    std::cout << "replayed=" << t << " matches=" << num_matches << std::endl;
+
+    // A bit index past the source size stops the replay
+    uint32_t header[5] = {0x52544242, 1, 1, 8, 2}; // "BBTR", 1 source of 8
+    uint8_t frames[8] = {
+        1, 1, 3,       // bit 3
+        1, 1, 0xc8, 1, // bit 200
+        1};
+
+    FILE* fptr = std::fopen("sdr_trace_bad.bin", "wb");
+    std::fwrite(header, sizeof(header[0]), 5, fptr);
+    std::fwrite(frames, 1, sizeof(frames), fptr);
+    std::fclose(fptr);
+
+    SDRTraceReplayer bad;
+    bad.open("sdr_trace_bad.bin");
+
+    std::cout << "step valid=" << bad.step() << " num_acts="
+              << bad.output(0).state.num_set() << std::endl;
+    std::cout << "step bad bit=" << bad.step() << " num_acts="
+              << bad.output(0).state.num_set() << std::endl;
+    std::cout << "step after=" << bad.step() << std::endl;
+
+    bad.close();
+    std::remove("sdr_trace_bad.bin");
+
+    return 0;
+}
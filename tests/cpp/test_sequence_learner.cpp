@@ -1,11 +1,16 @@
 // =============================================================================
 // test_sequence_learner.cpp
 // =============================================================================
+#include "blocks/blank_block.hpp"
+#include "blocks/pattern_pooler.hpp"
 #include "blocks/sequence_learner.hpp"
 #include "blocks/scalar_transformer.hpp"
 #include <iostream>
 #include <iomanip>
 #include <chrono>
+#include <random>
+#include <stdexcept>
+#include <vector>
 
 using namespace BrainBlocks;
 
@@ -62,5 +67,154 @@ int main() {
 		  << std::endl;
     }
 
+    // Backfill scores in parallel chunks
+    std::vector<BitArray> inputs;
+    std::vector<double> divergence;
+
+    for (uint32_t i = 0; i < values.size(); i++) {
+        st.set_value(values[i]);
+        st.feedforward();
+        inputs.push_back(st.output.state);
+    }
+
+    std::vector<double> backfill = sl.backfill(inputs, 3, 5, &divergence);
+
+    std::cout << "values, backfill scores" << std::endl;
+    for (uint32_t i = 0; i < backfill.size(); i++) {
+        std::cout << std::setprecision(4) << values[i] << ", " << backfill[i]
+                  << std::endl;
+    }
+
+    std::cout << "boundary divergence:";
+    for (uint32_t b = 0; b < divergence.size(); b++)
+        std::cout << " " << std::setprecision(4) << divergence[b];
+    std::cout << std::endl;
+
+    // Oversized learners are rejected at construction
+    try {
+        SequenceLearner slx(65536, 65536, 2, 12, 6, 20, 2, 1, 2);
+        std::cout << "oversized learner: accepted" << std::endl;
+    }
+    catch (const std::length_error& e) {
+        std::cout << "oversized learner: " << e.what() << std::endl;
+    }
+
+    // Pooler to sequence learner pipeline, unfused and fused
+    ScalarTransformer st0(0.0, 1.0, 512, 8, 2);
+    ScalarTransformer st1(0.0, 1.0, 512, 8, 2);
+    PatternPooler pp0(512, 16, 20, 2, 1, 0.8, 0.5, 0.3, 2);
+    PatternPooler pp1(512, 16, 20, 2, 1, 0.8, 0.5, 0.3, 2);
+    SequenceLearner sl0(512, 10, 10, 12, 6, 20, 2, 1, 2);
+    SequenceLearner sl1(512, 10, 10, 12, 6, 20, 2, 1, 2);
+
+    pp0.input.add_child(&st0.output, CURR);
+    pp1.input.add_child(&st1.output, CURR);
+    sl0.input.add_child(&pp0.output, CURR);
+    sl1.input.add_child(&pp1.output, CURR);
+
+    sl0.init();
+    sl1.init();
+    sl0.memory.set_tracing(true);
+    sl1.memory.set_tracing(true);
+
+    uint32_t num_match = 0;
+
+    for (uint32_t i = 0; i < values.size(); i++) {
+        st0.set_value(values[i]);
+        st0.feedforward();
+        pp0.feedforward(true);
+        sl0.feedforward(true);
+
+        st1.set_value(values[i]);
+        st1.feedforward();
+        pp1.feedforward(true);
+        sl1.feedforward_acts(pp1.get_winners(), true);
+
+        if (pp0.output.state == pp1.output.state &&
+            sl0.output.state == sl1.output.state &&
+            sl0.get_anomaly_score() == sl1.get_anomaly_score())
+            num_match++;
+    }
+
+    std::cout << "fused matches unfused: " << num_match << "/"
+              << values.size() << std::endl;
+
+    // Both paths trace one step per update, so relayout sees the same steps
+    LayoutReport report0 = sl0.memory.layout_report();
+    LayoutReport report1 = sl1.memory.layout_report();
+    std::cout << "traced steps unfused=" << report0.num_steps
+              << " fused=" << report1.num_steps << std::endl;
+
+    sl1.memory.relayout();
+    num_match = 0;
+
+    for (uint32_t i = 0; i < values.size(); i++) {
+        st1.set_value(values[i]);
+        st1.feedforward();
+        pp1.feedforward(false);
+        sl1.feedforward_acts(pp1.get_winners(), false);
+
+        st0.set_value(values[i]);
+        st0.feedforward();
+        pp0.feedforward(false);
+        sl0.feedforward(false);
+
+        if (sl0.output.state == sl1.output.state)
+            num_match++;
+    }
+
+    std::cout << "fused after relayout matches unfused: " << num_match << "/"
+              << values.size() << std::endl;
+
+    // Prefetched recognition matches the plain loop at every depth
+    std::mt19937 rng(0);
+    std::vector<std::vector<uint32_t>> seq(300);
+    std::vector<std::vector<uint32_t>> outs;
+    std::vector<uint32_t> depths = {0, 1, 2, 4, 8, 4};
+    std::vector<bool> with_inputs = {false, false, false, false, false, true};
+
+    for (uint32_t i = 0; i < seq.size(); i++) {
+        BitArray ba(2048);
+        ba.random_set_num(rng, 40);
+        seq[i] = ba.get_acts();
+    }
+
+    for (uint32_t p = 0; p < depths.size(); p++) {
+        BlankBlock blank(2048);
+        SequenceLearner slp(2048, 16, 16, 32, 20, 20, 2, 1, 2);
+        slp.input.add_child(&blank.output, CURR);
+        slp.set_prefetch(depths[p], with_inputs[p]);
+
+        for (uint32_t e = 0; e < 2; e++)
+            for (uint32_t i = 0; i < seq.size(); i++)
+                slp.feedforward_acts(seq[i], true);
+
+        num_match = 0;
+        t0 = std::chrono::high_resolution_clock::now();
+
+        for (uint32_t e = 0; e < 2; e++) {
+            for (uint32_t i = 0; i < seq.size(); i++) {
+                slp.feedforward_acts(seq[i], false);
+
+                if (p == 0)
+                    outs.push_back(slp.output.state.get_acts());
+                else if (outs[e * seq.size() + i] ==
+                         slp.output.state.get_acts())
+                    num_match++;
+            }
+        }
+
+        t1 = std::chrono::high_resolution_clock::now();
+        duration = t1 - t0;
+        std::cout << "t=" << duration.count() << "s (prefetch depth "
+                  << depths[p] << (with_inputs[p] ? " with inputs)" : ")")
+                  << std::endl;
+
+        if (p > 0)
+            std::cout << "prefetch depth " << depths[p]
+                      << (with_inputs[p] ? " with inputs" : "") << " matches: "
+                      << num_match << "/" << outs.size() << std::endl;
+    }
+
     return 0;
 }
@@ -0,0 +1,87 @@
+// =============================================================================
+// test_summary_bitarray.cpp
+// =============================================================================
+#include "summary_bitarray.hpp"
+#include <iostream>
+#include <chrono>
+#include <random>
+
+using namespace BrainBlocks;
+
+int main() {
+
+    std::chrono::high_resolution_clock::time_point t0;
+    std::chrono::high_resolution_clock::time_point t1;
+    std::chrono::duration<double> duration;
+
+    std::mt19937 rng(0);
+    uint32_t num_b = 1 << 25;
+
+    // Setup a very sparse array and a plain copy to compare against
+    SummaryBitArray sba(num_b);
+    BitArray ba(num_b);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        uint32_t b = rng() % num_b;
+        sba.set_bit(b);
+        ba.set_bit(b);
+    }
+
+    sba.clear_bit(sba.get_acts()[10]);
+    ba.clear_bit(ba.get_acts()[10]);
+
+    std::cout << "num_levels=" << sba.num_levels() << std::endl;
+    std::cout << "num_set=" << sba.num_set() << " (" << ba.num_set() << ")"
+              << std::endl;
+    std::cout << "acts match: " << (sba.get_acts() == ba.get_acts())
+              << std::endl;
+    std::cout << std::endl;
+
+    // Iterate set bits with find_next_set_bit
+    uint32_t count = 0;
+    uint32_t b = 0;
+    uint32_t next_b;
+
+    t0 = std::chrono::high_resolution_clock::now();
+    while (sba.find_next_set_bit(b, &next_b) && next_b >= b) {
+        count++;
+
+        if (next_b + 1 >= num_b)
+            break;
+
+        b = next_b + 1;
+    }
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s (summary)" << std::endl;
+    std::cout << "count=" << count << std::endl;
+
+    count = 0;
+    b = 0;
+
+    t0 = std::chrono::high_resolution_clock::now();
+    while (ba.find_next_set_bit(b, &next_b) && next_b >= b) {
+        count++;
+
+        if (next_b + 1 >= num_b)
+            break;
+
+        b = next_b + 1;
+    }
+    t1 = std::chrono::high_resolution_clock::now();
+    duration = t1 - t0;
+    std::cout << "t=" << duration.count() << "s (bitarray)" << std::endl;
+    std::cout << "count=" << count << std::endl;
+    std::cout << std::endl;
+
+    // Wrap around and clear
+    sba.find_next_set_bit(num_b - 1, &next_b);
+    std::cout << "wrapped to first: " << (next_b == sba.get_acts()[0])
+              << std::endl;
+
+    sba.clear_all();
+    std::cout << "after clear_all num_set=" << sba.num_set()
+              << " found=" << sba.find_next_set_bit(0, &next_b) << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+// =============================================================================
+// test_sweep_runner.cpp
+// =============================================================================
+#include "sweep_runner.hpp"
+#include "blocks/scalar_transformer.hpp"
+#include <iostream>
+#include <vector>
+
+using namespace BrainBlocks;
+
+int main() {
+
+    // Encode the dataset once
+    ScalarTransformer st(0.0, 1.0, 1024, 128);
+    SweepRunner runner(1024);
+
+    for (uint32_t i = 0; i < 200; i++) {
+        uint32_t label = i % 4;
+        st.set_value(label / 3.0);
+        st.feedforward();
+        runner.add_train(st.output.state, label);
+
+        if (i < 40)
+            runner.add_test(st.output.state, label);
+    }
+
+    std::cout << "num_train=" << runner.num_train() << std::endl;
+    std::cout << "num_test=" << runner.num_test() << std::endl;
+    std::cout << std::endl;
+
+    // Sweep classifier sizes and an anomaly detector
+    std::vector<SweepConfig> configs(4);
+    configs[0].num_l = 4;
+    configs[0].num_s = 128;
+    configs[1].num_l = 4;
+    configs[1].num_s = 512;
+    configs[2].type = SWEEP_CLASSIFIER_DYNAMIC;
+    configs[2].num_s = 512;
+    configs[3].type = SWEEP_ANOMALY;
+    configs[3].num_s = 512;
+
+    std::vector<SweepResult> results = runner.run_all(configs, 4);
+
+    for (uint32_t k = 0; k < results.size(); k++) {
+        std::cout << "config " << k << ": type=" << (uint32_t)configs[k].type
+                  << " num_s=" << configs[k].num_s
+                  << " accuracy=" << results[k].accuracy
+                  << " mean_anomaly=" << results[k].mean_anomaly
+                  << std::endl;
+        std::cout << "  train_time=" << results[k].train_time << " s"
+                  << std::endl;
+        std::cout << "  memory_usage=" << results[k].memory_usage << " bytes"
+                  << std::endl;
+    }
+
+    return 0;
+}